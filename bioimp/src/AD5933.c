@@ -9,191 +9,1534 @@
 /******************************************************************************/
 #include "AD5933.h"
 #include "math.h"
-#include "stdio.h"
 #include "i2c.h"
 
 /******************************************************************************/
 /************************** Constants Definitions *****************************/
 /******************************************************************************/
-const long POW_2_27 = 134217728ul;      // 2 to the power of 27
+const unsigned char ADDR_POINTER_UNKNOWN = 0x00;    // No register is below 0x80
 
-/******************************************************************************/
-/************************ Variables Definitions *******************************/
-/******************************************************************************/
-int i2cdevice = 0x0D;
-int adress;
-float AD5933_CALIBRATION_IMPEDANCE;
-unsigned long currentSysClk      = AD5933_INTERNAL_SYS_CLK;
-unsigned char currentClockSource = AD5933_CONTROL_INT_SYSCLK;
-unsigned char currentGain        = AD5933_GAIN_X1;
-unsigned char currentRange       = AD5933_RANGE_2000mVpp;
+/* Backend on the wiringPi calls, one call per operation */
+const AD5933_Transport AD5933_WIRINGPI_TRANSPORT = {
+    wiringPiI2CWriteReg8,
+    wiringPiI2CReadReg8,
+    wiringPiI2CWriteBlockData,
+    wiringPiI2CReadBlockData,
+    0
+};
 
 /******************************************************************************/
 /************************ Functions Definitions *******************************/
 /******************************************************************************/
 
 /***************************************************************************//**
- * @brief Initializes the communication peripheral.
+ * @brief Initializes the device context. Each AD5933 in the process has its
+ *        own context, so several devices can be used at the same time.
+ *
+ * @param dev       - Device context to initialize.
+ * @param i2cdevice - I2C handle of the device, as returned by the I2C setup.
+ *
+ * @return status - The result of the initialization procedure.
+ *                  Example: false - I2C peripheral was not initialized.
+ *                           true  - I2C peripheral was initialized.
+*******************************************************************************/
+bool AD5933_Init(AD5933_Device *dev, int i2cdevice)
+{
+    if(i2cdevice > 0)
+    {
+        dev->i2cdevice   = i2cdevice;
+        dev->transport   = &AD5933_WIRINGPI_TRANSPORT;
+        dev->batchOps    = 0;
+        dev->batchCapacity = 0;
+        dev->batchCount  = 0;
+        dev->sysClk      = AD5933_INTERNAL_SYS_CLK;
+        dev->clockSource = AD5933_CONTROL_INT_SYSCLK;
+        dev->gain        = AD5933_GAIN_X1;
+        dev->range       = AD5933_RANGE_2000mVpp;
+        dev->addrPointer = ADDR_POINTER_UNKNOWN;
+        dev->shadowValid = 0;
+        dev->pendingStatus = 0;
+        dev->pollCount   = 0;
+        dev->pollLimit   = AD5933_DEFAULT_POLL_LIMIT;
+        dev->log         = 0;
+#if AD5933_STATS
+        dev->stats       = 0;
+        dev->pendingSinceNs = 0;
+#endif
+        dev->pointCallback = 0;
+        dev->pointContext  = 0;
+        dev->pointRing     = 0;
+        return true;
+    }
+    return false;
+}
+
+/***************************************************************************//**
+ * @brief Attaches a log ring to the device. The driver writes its records
+ *        there; another thread formats them with AD5933_LogFormat.
+ *
+ * @param dev  - Device context.
+ * @param ring - Ring initialized with AD5933_LogInit, or NULL to stop logging.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_SetLog(AD5933_Device *dev, AD5933_Ring *ring)
+{
+    dev->log = ring;
+}
+
+/***************************************************************************//**
+ * @brief Attaches statistics to the device. The driver counts its bus
+ *        operations, polls and skipped writes there and records the latency
+ *        of sweeps, points, configurations and temperature reads; another
+ *        thread reads them with AD5933_StatsRead. Only built with
+ *        AD5933_STATS=1.
+ *
+ * @param dev   - Device context.
+ * @param stats - Statistics initialized with AD5933_StatsInit, or NULL.
+ *
+ * @return None.
+*******************************************************************************/
+#if AD5933_STATS
+void AD5933_SetStats(AD5933_Device *dev, AD5933_Stats *stats)
+{
+    dev->stats = stats;
+}
+#endif
+
+/***************************************************************************//**
+ * @brief Selects the I2C backend of the device, e.g. AD5933_I2CDEV_TRANSPORT
+ *        to batch the operations into I2C_RDWR calls on Linux.
+ *
+ * @param dev       - Device context, without an open batch.
+ * @param transport - Backend. i2cdevice must be a handle of that backend.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_SetTransport(AD5933_Device *dev, const AD5933_Transport *transport)
+{
+    dev->transport = transport;
+}
+
+/***************************************************************************//**
+ * @brief Runs bus operations in order: in one submit call if the backend has
+ *        one, otherwise one call each. Like an I2C_RDWR transfer, it stops
+ *        at the first operation that fails.
+ *
+ * @param dev   - Device context.
+ * @param ops   - Operations.
+ * @param count - Number of operations.
+ *
+ * @return true if every operation succeeded.
+*******************************************************************************/
+static bool AD5933_RunBusOps(AD5933_Device *dev,
+                             const AD5933_BusOp *ops,
+                             unsigned char count)
+{
+    const AD5933_Transport *bus    = dev->transport;
+    unsigned char           index  = 0;
+    int                     result = 0;
+    
+#if AD5933_STATS
+    for(index = 0; (dev->stats != 0) && (index < count); index++)
+    {
+        AD5933_STATS_COUNT(dev->stats,
+                           ((ops[index].type == AD5933_BUS_READ_REG8) ||
+                            (ops[index].type == AD5933_BUS_READ_BLOCK)) ?
+                           AD5933_COUNTER_BUS_READS : AD5933_COUNTER_BUS_WRITES,
+                           1);
+    }
+#endif
+    if((bus->submit != 0) && (count > 0))
+    {
+        return bus->submit(dev->i2cdevice, ops, count);
+    }
+    for(index = 0; index < count; index++)
+    {
+        switch(ops[index].type)
+        {
+            case AD5933_BUS_WRITE_REG8:
+                result = bus->writeReg8(dev->i2cdevice, ops[index].command,
+                                        ops[index].data[0]) ? 1 : -1;
+                break;
+            case AD5933_BUS_READ_REG8:
+                result = bus->readReg8(dev->i2cdevice, ops[index].command);
+                if(result >= 0)
+                {
+                    ops[index].readData[0] = (unsigned char)result;
+                }
+                break;
+            case AD5933_BUS_WRITE_BLOCK:
+                result = bus->writeBlock(dev->i2cdevice, ops[index].command,
+                                         ops[index].data, ops[index].size) ? 1 : -1;
+                break;
+            default:
+                result = bus->readBlock(dev->i2cdevice, ops[index].command,
+                                        ops[index].readData, ops[index].size);
+                result = (result == ops[index].size) ? 1 : -1;
+                break;
+        }
+        if(result < 0)
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Runs the operations queued so far and leaves the batch open. If the
+ *        batch failed the shadow copy and the address pointer are no longer
+ *        known: they were updated when the writes were queued.
+ *
+ * @param dev - Device context with an open batch.
+ *
+ * @return true if every queued operation succeeded.
+*******************************************************************************/
+static bool AD5933_FlushBatch(AD5933_Device *dev)
+{
+    bool result = AD5933_RunBusOps(dev, dev->batchOps, dev->batchCount);
+    
+    if(!result)
+    {
+        AD5933_LOG_ERROR(dev->log, AD5933_EVENT_BUS_ERROR,
+                         dev->batchOps[0].command, dev->batchCount, 0);
+        dev->shadowValid = 0;
+        dev->addrPointer = ADDR_POINTER_UNKNOWN;
+    }
+    dev->batchCount = 0;
+    
+    return result;
+}
+
+/***************************************************************************//**
+ * @brief Runs a bus operation now, or queues it if a batch is open. A full
+ *        batch is run first to make room.
+ *
+ * @param dev      - Device context.
+ * @param type     - AD5933_BUS_* operation.
+ * @param command  - Register or block command.
+ * @param data     - Bytes to write, NULL for reads.
+ * @param readData - Buffer for the bytes read, NULL for writes.
+ * @param size     - Number of bytes.
+ *
+ * @return true if the operation succeeded or was queued.
+*******************************************************************************/
+static bool AD5933_BusOperation(AD5933_Device *dev,
+                                unsigned char type,
+                                unsigned char command,
+                                const unsigned char *data,
+                                unsigned char *readData,
+                                unsigned char size)
+{
+    AD5933_BusOp  single;
+    AD5933_BusOp *op   = &single;
+    unsigned char byte = 0;
+    
+    if(dev->batchOps != 0)
+    {
+        if((dev->batchCount == dev->batchCapacity) && !AD5933_FlushBatch(dev))
+        {
+            return false;
+        }
+        op = &dev->batchOps[dev->batchCount++];
+    }
+    op->type     = type;
+    op->command  = command;
+    op->size     = size;
+    op->readData = readData;
+    for(byte = 0; (data != 0) && (byte < size) && (byte < AD5933_BUS_MAX_DATA); byte++)
+    {
+        op->data[byte] = data[byte];
+    }
+    
+    return (op != &single) || AD5933_RunBusOps(dev, op, 1);
+}
+
+/***************************************************************************//**
+ * @brief Starts queueing the bus operations of the device into a batch.
+ *        Register writes, address pointer changes and queued block reads
+ *        are run together by AD5933_SubmitBatch; with a backend that has a
+ *        submit call (i2c-dev) that is a single system call. Any other
+ *        read runs the queue first, so the order of the operations is kept.
+ *        The batch is full at capacity operations and is then run early.
+ *
+ * @param dev      - Device context.
+ * @param ops      - Caller-owned storage for the queued operations.
+ * @param capacity - Number of entries in ops, at least 1.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_BeginBatch(AD5933_Device *dev,
+                       AD5933_BusOp *ops,
+                       unsigned char capacity)
+{
+    dev->batchOps      = ops;
+    dev->batchCapacity = capacity;
+    dev->batchCount    = 0;
+}
+
+/***************************************************************************//**
+ * @brief Submits the queued operations and closes the batch.
+ *
+ * @param dev - Device context.
+ *
+ * @return true if every queued operation succeeded (or none was queued).
+*******************************************************************************/
+bool AD5933_SubmitBatch(AD5933_Device *dev)
+{
+    bool result = true;
+    
+    if(dev->batchOps != 0)
+    {
+        result        = AD5933_FlushBatch(dev);
+        dev->batchOps = 0;
+    }
+    
+    return result;
+}
+
+/***************************************************************************//**
+ * @brief Opens a batch for the operations of one driver call, if the backend
+ *        can submit them at once and the caller has not opened one already.
+ *
+ * @param dev      - Device context.
+ * @param ops      - Storage for the operations of the call.
+ * @param capacity - Number of entries in ops.
+ *
+ * @return true if the batch was opened and must be submitted by the call.
+*******************************************************************************/
+static bool AD5933_OpenCallBatch(AD5933_Device *dev,
+                                 AD5933_BusOp *ops,
+                                 unsigned char capacity)
+{
+    if((dev->batchOps != 0) || (dev->transport->submit == 0))
+    {
+        return false;
+    }
+    AD5933_BeginBatch(dev, ops, capacity);
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Registers a callback that receives each sweep point as soon as the
+ *        sweep loops read it, in the acquisition thread. It should return
+ *        quickly; slow consumers should use a point ring instead.
+ *
+ * @param dev      - Device context.
+ * @param callback - Function called for each point, or NULL for none.
+ * @param context  - Argument passed back to the callback.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_SetPointCallback(AD5933_Device *dev,
+                             AD5933_PointCallback callback,
+                             void *context)
+{
+    dev->pointCallback = callback;
+    dev->pointContext  = context;
+}
+
+/***************************************************************************//**
+ * @brief Initializes a ring of sweep points over caller-owned storage.
+ *
+ * @param ring     - Ring to initialize.
+ * @param points   - Storage for capacity points.
+ * @param capacity - Number of points, power of 2.
+ *
+ * @return false if capacity is not a power of 2.
+*******************************************************************************/
+bool AD5933_InitPointRing(AD5933_Ring *ring,
+                          AD5933_Point *points,
+                          unsigned long capacity)
+{
+    return AD5933_RingInit(ring, points, sizeof(AD5933_Point), capacity);
+}
+
+/***************************************************************************//**
+ * @brief Attaches a ring that receives each sweep point as soon as it is
+ *        read. Another thread pops the points with AD5933_RingPop while the
+ *        sweep goes on; points that do not fit are dropped and counted.
+ *
+ * @param dev  - Device context.
+ * @param ring - Ring initialized with AD5933_InitPointRing, or NULL for none.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_SetPointRing(AD5933_Device *dev, AD5933_Ring *ring)
+{
+    dev->pointRing = ring;
+}
+
+/***************************************************************************//**
+ * @brief Stores a sweep point in the buffer (if it has arrays) and publishes
+ *        it to the point callback and ring.
+ *
+ * @param dev      - Device context.
+ * @param buffer   - Sweep buffer; its count is the index of the point.
+ * @param realData - Real data.
+ * @param imagData - Imaginary data.
+ * @param status   - Status register read with the point.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_PublishPoint(AD5933_Device *dev,
+                                AD5933_SweepBuffer *buffer,
+                                signed short realData,
+                                signed short imagData,
+                                unsigned char status)
+{
+    AD5933_Point point;
+    
+    if((buffer->realData != 0) && (buffer->imagData != 0))
+    {
+        buffer->realData[buffer->count] = realData;
+        buffer->imagData[buffer->count] = imagData;
+    }
+    if((dev->pointCallback != 0) || (dev->pointRing != 0))
+    {
+        point.index    = buffer->count;
+        point.status   = status;
+        point.realData = realData;
+        point.imagData = imagData;
+        if(dev->pointCallback != 0)
+        {
+            dev->pointCallback(dev->pointContext, &point);
+        }
+        if(dev->pointRing != 0)
+        {
+            AD5933_RingPush(dev->pointRing, &point);
+        }
+    }
+    buffer->count++;
+}
+
+/***************************************************************************//**
+ * @brief Checks if a write to a register is a command rather than a setting.
+ *        Commands (sweep functions, temperature measure and reset) have an
+ *        effect each time they are written, so they are never skipped.
+ *
+ * @param registerAddress - Address of the register.
+ * @param value           - Byte to write.
+ *
+ * @return true if the write triggers an operation in the device.
+*******************************************************************************/
+static bool AD5933_IsCommandWrite(unsigned char registerAddress,
+                                  unsigned char value)
+{
+    unsigned char function = value >> 4;
+    
+    if(registerAddress == AD5933_REG_CONTROL_HB)
+    {
+        return (function != AD5933_FUNCTION_NOP) &&
+               (function != AD5933_FUNCTION_STANDBY) &&
+               (function != AD5933_FUNCTION_POWER_DOWN);
+    }
+    if(registerAddress == AD5933_REG_CONTROL_LB)
+    {
+        return (value & AD5933_CONTROL_RESET) != 0;
+    }
+    
+    return false;
+}
+
+/***************************************************************************//**
+ * @brief Checks if a register already holds a value, according to the shadow
+ *        copy of the writable registers.
+ *
+ * @param dev             - Device context.
+ * @param registerAddress - Address of the register.
+ * @param value           - Byte to write.
+ *
+ * @return true if the write can be skipped.
+*******************************************************************************/
+static bool AD5933_IsRedundantWrite(AD5933_Device *dev,
+                                    unsigned char registerAddress,
+                                    unsigned char value)
+{
+    unsigned char index = registerAddress - AD5933_REG_CONTROL_HB;
+    
+    if((registerAddress < AD5933_REG_CONTROL_HB) ||
+       (index >= AD5933_SHADOW_SIZE) ||
+       ((dev->shadowValid & (1u << index)) == 0))
+    {
+        return false;
+    }
+    
+    return (dev->shadowRegs[index] == value) &&
+           !AD5933_IsCommandWrite(registerAddress, value);
+}
+
+/***************************************************************************//**
+ * @brief Records a write in the shadow copy of the writable registers.
+ *
+ * @param dev             - Device context.
+ * @param registerAddress - Address of the register.
+ * @param value           - Byte written.
+ * @param written         - false if the write failed and the register content
+ *                          is unknown.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_UpdateShadow(AD5933_Device *dev,
+                                unsigned char registerAddress,
+                                unsigned char value,
+                                bool written)
+{
+    unsigned char index = registerAddress - AD5933_REG_CONTROL_HB;
+    
+    if((registerAddress < AD5933_REG_CONTROL_HB) ||
+       (index >= AD5933_SHADOW_SIZE))
+    {
+        return;
+    }
+    dev->shadowRegs[index] = value;
+    if(written)
+    {
+        dev->shadowValid |= (1u << index);
+    }
+    else
+    {
+        dev->shadowValid &= ~(1u << index);
+    }
+    // After a reset the function in the control register is not known.
+    if((registerAddress == AD5933_REG_CONTROL_LB) &&
+       (value & AD5933_CONTROL_RESET))
+    {
+        dev->shadowValid &= ~(1u << 0);
+    }
+}
+
+/***************************************************************************//**
+ * @brief Writes data into a register. Bytes that the device already holds
+ *        are not written again, except for commands.
+ *
+ * @param dev             - Device context.
+ * @param registerAddress - Address of the register.
+ * @param registerValue   - Data value to write.
+ * @param bytesNumber     - Number of bytes.
+ *
+ * @return true if all the bytes are in the register.
+*******************************************************************************/
+bool AD5933_SetRegisterValue(AD5933_Device *dev,
+                             unsigned char registerAddress,
+                             unsigned long registerValue,
+                             unsigned char bytesNumber)
+{
+    unsigned char byte          = 0;
+    unsigned char writeData[2]  = {0, 0};
+    AD5933_BusOp  ops[4];
+    bool          own           = (bytesNumber > 1) &&
+                                  AD5933_OpenCallBatch(dev, ops, 4);
+    bool          written       = false;
+    bool          result        = true;
+
+    for(byte = 0;byte < bytesNumber; byte++)
+    {
+        writeData[0] = registerAddress + bytesNumber - byte - 1;
+        writeData[1] = (unsigned char)((registerValue >> (byte * 8)) & 0xFF);
+        if(AD5933_IsRedundantWrite(dev, writeData[0], writeData[1]))
+        {
+            AD5933_STATS_COUNT(dev->stats, AD5933_COUNTER_REDUNDANT_WRITES, 1);
+            continue;
+        }
+        written = AD5933_BusOperation(dev, AD5933_BUS_WRITE_REG8, writeData[0],
+                                      &writeData[1], 0, 1);
+        if(!written)
+        {
+            AD5933_LOG_ERROR(dev->log, AD5933_EVENT_BUS_ERROR, writeData[0], 0, 0);
+        }
+        AD5933_UpdateShadow(dev, writeData[0], writeData[1], written);
+        result = result && written;
+    }
+    if(own)
+    {
+        result = AD5933_SubmitBatch(dev) && result;
+    }
+    
+    return result;
+}
+
+/***************************************************************************//**
+ * @brief Reads the value of a register and reports whether the bus delivered
+ *        it. A failed transfer is logged and the value is left unset, so a
+ *        bus error never reads as a register holding 0.
+ *
+ * @param dev             - Device context.
+ * @param registerAddress - Address of the register.
+ * @param bytesNumber     - Number of bytes, at most 4.
+ * @param registerValue   - Value of the register.
+ *
+ * @return false if a byte could not be read.
+*******************************************************************************/
+bool AD5933_ReadRegisterValue(AD5933_Device *dev,
+                              unsigned char registerAddress,
+                              unsigned char bytesNumber,
+                              unsigned long *registerValue)
+{
+    unsigned long value         = 0;
+    unsigned char byte          = 0;
+    unsigned char readData[4]   = {0, 0, 0, 0};
+    AD5933_BusOp  ops[4];
+    bool          batched       = (dev->batchOps != 0) ||
+                                  (dev->transport->submit != 0);
+    bool          own           = AD5933_OpenCallBatch(dev, ops, 4);
+    bool          result        = true;
+    int tmp = 0;
+    
+    bytesNumber = (bytesNumber > sizeof(readData)) ? sizeof(readData) :
+                                                     bytesNumber;
+    if(batched)
+    {
+        // The queued operations and the byte reads go in one submit
+        for(byte = 0; byte < bytesNumber; byte++)
+        {
+            AD5933_BusOperation(dev, AD5933_BUS_READ_REG8, registerAddress + byte,
+                                0, &readData[byte], 1);
+        }
+        result = AD5933_FlushBatch(dev);
+        dev->batchOps = own ? 0 : dev->batchOps;
+    }
+    // Byte reads go through the register address, so the address pointer
+    // can no longer be trusted for the next block read.
+    dev->addrPointer = ADDR_POINTER_UNKNOWN;
+    if(!result)
+    {
+        AD5933_LOG_ERROR(dev->log, AD5933_EVENT_BUS_ERROR, registerAddress, 0, 0);
+        return false;
+    }
+    for(byte = 0;byte < bytesNumber;byte ++)
+    {
+        // Read byte from specified registerAddress memory place
+		if(!batched)
+		{
+		    AD5933_STATS_COUNT(dev->stats, AD5933_COUNTER_BUS_READS, 1);
+		}
+		tmp = batched ? readData[byte] :
+		      dev->transport->readReg8(dev->i2cdevice,registerAddress);
+		if(tmp < 0)
+		{
+		    AD5933_LOG_ERROR(dev->log, AD5933_EVENT_BUS_ERROR,
+		                     registerAddress, 0, 0);
+		    return false;
+		}
+		AD5933_LOG_DEBUG(dev->log, AD5933_EVENT_REG_READ, registerAddress, tmp, 0);
+		// Add this temporal value to our registerValue (remembering that
+		// we are reading bytes that have location value, which means that
+		// each measure we have we not only have to add it to the previous
+		// register value but we also but do a bitwise shift (<< 8) by 1 byte
+		value = value << 8;
+        value += tmp;
+        // Update value from registerAddress to read next memory position byte
+        registerAddress = registerAddress + 1;
+    }
+    *registerValue = value;
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Reads the value of a register.
+ *
+ * @param dev             - Device context.
+ * @param registerAddress - Address of the register.
+ * @param bytesNumber     - Number of bytes.
+ *
+ * @return registerValue  - Value of the register, 0 on a bus error (use
+ *                          AD5933_ReadRegisterValue to tell them apart).
+*******************************************************************************/
+unsigned long AD5933_GetRegisterValue(AD5933_Device *dev,
+                                      unsigned char registerAddress,
+                                      unsigned char bytesNumber)
+{
+    unsigned long registerValue = 0;
+    
+    AD5933_ReadRegisterValue(dev, registerAddress, bytesNumber, &registerValue);
+    
+    return registerValue;
+}
+
+/***************************************************************************//**
+ * @brief Sets the address pointer used by the block commands. The pointer is
+ *        only written when it differs from the last one set, so consecutive
+ *        block reads of the same registers cost a single transaction each.
+ *
+ * @param dev             - Device context.
+ * @param registerAddress - Address of the first register of the block.
+ *
+ * @return true if the pointer is set.
+*******************************************************************************/
+bool AD5933_SetAddressPointer(AD5933_Device *dev,
+                              unsigned char registerAddress)
+{
+    if(dev->addrPointer == registerAddress)
+    {
+        return true;
+    }
+    if(!AD5933_BusOperation(dev, AD5933_BUS_WRITE_REG8, AD5933_ADDR_POINTER,
+                            &registerAddress, 0, 1))
+    {
+        dev->addrPointer = ADDR_POINTER_UNKNOWN;
+        return false;
+    }
+    dev->addrPointer = registerAddress;
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Reads consecutive registers with a single block read command.
+ *
+ * @param dev             - Device context.
+ * @param registerAddress - Address of the first register.
+ * @param data            - Buffer for the register bytes, in address order.
+ * @param bytesNumber     - Number of bytes.
+ *
+ * @return true if all the bytes were read.
+*******************************************************************************/
+bool AD5933_GetRegisterBlock(AD5933_Device *dev,
+                             unsigned char registerAddress,
+                             unsigned char *data,
+                             unsigned char bytesNumber)
+{
+    AD5933_BusOp ops[2];
+    bool         own    = AD5933_OpenCallBatch(dev, ops, 2);
+    bool         result = false;
+    
+    if(dev->batchOps != 0)
+    {
+        // Pointer write and block read (and anything queued) in one submit
+        result = AD5933_QueueRegisterBlock(dev, registerAddress, data,
+                                           bytesNumber) &&
+                 AD5933_FlushBatch(dev);
+        dev->batchOps = own ? 0 : dev->batchOps;
+        if(result)
+        {
+            AD5933_LOG_DEBUG(dev->log, AD5933_EVENT_BLOCK_READ, registerAddress,
+                             bytesNumber, 0);
+        }
+        return result;
+    }
+    if(!AD5933_SetAddressPointer(dev, registerAddress))
+    {
+        AD5933_LOG_ERROR(dev->log, AD5933_EVENT_BUS_ERROR, AD5933_ADDR_POINTER, 0, 0);
+        return false;
+    }
+    AD5933_STATS_COUNT(dev->stats, AD5933_COUNTER_BUS_READS, 1);
+    if(dev->transport->readBlock(dev->i2cdevice, AD5933_BLOCK_READ,
+                                 data, bytesNumber) != bytesNumber)
+    {
+        AD5933_LOG_ERROR(dev->log, AD5933_EVENT_BUS_ERROR, registerAddress, 0, 0);
+        return false;
+    }
+    AD5933_LOG_DEBUG(dev->log, AD5933_EVENT_BLOCK_READ, registerAddress,
+                     bytesNumber, 0);
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Queues a block read of consecutive registers into the open batch,
+ *        behind an address pointer write if one is needed. The data is valid
+ *        once the batch has been submitted successfully.
+ *
+ * @param dev             - Device context with an open batch.
+ * @param registerAddress - Address of the first register.
+ * @param data            - Buffer for the register bytes, in address order.
+ * @param bytesNumber     - Number of bytes.
+ *
+ * @return false if no batch is open or a full batch failed to run.
+*******************************************************************************/
+bool AD5933_QueueRegisterBlock(AD5933_Device *dev,
+                               unsigned char registerAddress,
+                               unsigned char *data,
+                               unsigned char bytesNumber)
+{
+    if(dev->batchOps == 0)
+    {
+        return false;
+    }
+    
+    return AD5933_SetAddressPointer(dev, registerAddress) &&
+           AD5933_BusOperation(dev, AD5933_BUS_READ_BLOCK, AD5933_BLOCK_READ,
+                               0, data, bytesNumber);
+}
+
+/***************************************************************************//**
+ * @brief Writes consecutive registers with a single block write command.
+ *
+ * @param dev             - Device context.
+ * @param registerAddress - Address of the first register.
+ * @param data            - Register bytes, in address order.
+ * @param bytesNumber     - Number of bytes.
+ *
+ * @return true if the block was written.
+*******************************************************************************/
+bool AD5933_SetRegisterBlock(AD5933_Device *dev,
+                             unsigned char registerAddress,
+                             const unsigned char *data,
+                             unsigned char bytesNumber)
+{
+    unsigned char byte    = 0;
+    bool          written = false;
+    
+    // Nothing to do if the device already holds the whole block
+    while((byte < bytesNumber) &&
+          AD5933_IsRedundantWrite(dev, registerAddress + byte, data[byte]))
+    {
+        byte++;
+    }
+    if(byte == bytesNumber)
+    {
+        AD5933_STATS_COUNT(dev->stats, AD5933_COUNTER_REDUNDANT_WRITES, 1);
+        return true;
+    }
+    if(!AD5933_SetAddressPointer(dev, registerAddress))
+    {
+        return false;
+    }
+    written = (bytesNumber <= AD5933_BUS_MAX_DATA) &&
+              AD5933_BusOperation(dev, AD5933_BUS_WRITE_BLOCK, AD5933_BLOCK_WRITE,
+                                  data, 0, bytesNumber);
+    if(!written)
+    {
+        AD5933_LOG_ERROR(dev->log, AD5933_EVENT_BUS_ERROR, registerAddress, 0, 0);
+    }
+    for(byte = 0; byte < bytesNumber; byte++)
+    {
+        AD5933_UpdateShadow(dev, registerAddress + byte, data[byte], written);
+    }
+    
+    return written;
+}
+
+/***************************************************************************//**
+ * @brief Reads the real and imaginary data with one block read. When status
+ *        is requested the block starts at the status register, so the poll
+ *        and the data fetch are the same transaction.
+ *
+ * @param dev      - Device context.
+ * @param realData - Real part of the DFT result.
+ * @param imagData - Imaginary part of the DFT result.
+ * @param status   - Status register value, or NULL to read only the data.
+ *
+ * @return true if the block was read.
+*******************************************************************************/
+bool AD5933_GetData(AD5933_Device *dev,
+                    signed short *realData,
+                    signed short *imagData,
+                    unsigned char *status)
+{
+    unsigned char data[AD5933_STATUS_BLOCK_SIZE] = {0};
+    unsigned char offset = 0;
+    
+    if(status != 0)
+    {
+        if(!AD5933_GetRegisterBlock(dev, AD5933_REG_STATUS, data,
+                                    AD5933_STATUS_BLOCK_SIZE))
+        {
+            return false;
+        }
+        *status = data[0];
+        offset = AD5933_REG_REAL_DATA - AD5933_REG_STATUS;
+    }
+    else if(!AD5933_GetRegisterBlock(dev, AD5933_REG_REAL_DATA, data,
+                                     AD5933_DATA_BLOCK_SIZE))
+    {
+        return false;
+    }
+    *realData = (signed short)((data[offset] << 8) | data[offset + 1]);
+    *imagData = (signed short)((data[offset + 2] << 8) | data[offset + 3]);
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Resets the device.
+ *
+ * @param dev - Device context.
+ *
+ * @return true if the command was sent.
+*******************************************************************************/
+bool AD5933_Reset(AD5933_Device *dev)
+{
+    return AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_LB, 
+                                   AD5933_CONTROL_RESET | dev->clockSource,
+                                   1);
+}
+
+/***************************************************************************//**
+ * @brief Writes again every register recorded in the shadow copy, e.g. after
+ *        a power cycle of the device. The control register is left in
+ *        standby unless it held a setting (NOP, standby or power-down).
+ *
+ * @param dev - Device context.
+ *
+ * @return true if all the registers were written.
+*******************************************************************************/
+bool AD5933_RestoreRegisters(AD5933_Device *dev)
+{
+    unsigned char  image[AD5933_SHADOW_SIZE];
+    unsigned short valid  = dev->shadowValid;
+    unsigned short config = ((1u << AD5933_PROFILE_SIZE) - 1) <<
+                            (AD5933_REG_FREQ_START - AD5933_REG_CONTROL_HB);
+    unsigned char  index  = 0;
+    bool           result = true;
+    
+    for(index = 0; index < AD5933_SHADOW_SIZE; index++)
+    {
+        image[index] = dev->shadowRegs[index];
+    }
+    // The device content is unknown, nothing can be skipped
+    dev->shadowValid = 0;
+    dev->addrPointer = ADDR_POINTER_UNKNOWN;
+    
+    if((valid & config) == config)
+    {
+        result = AD5933_SetRegisterBlock(dev, AD5933_REG_FREQ_START,
+                        &image[AD5933_REG_FREQ_START - AD5933_REG_CONTROL_HB],
+                        AD5933_PROFILE_SIZE);
+    }
+    else
+    {
+        for(index = AD5933_REG_FREQ_START - AD5933_REG_CONTROL_HB;
+            index < AD5933_SHADOW_SIZE; index++)
+        {
+            if(valid & (1u << index))
+            {
+                result &= AD5933_SetRegisterValue(dev,
+                                                  AD5933_REG_CONTROL_HB + index,
+                                                  image[index], 1);
+            }
+        }
+    }
+    result &= AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_LB,
+                                      dev->clockSource, 1);
+    if((valid & 1u) && !AD5933_IsCommandWrite(AD5933_REG_CONTROL_HB, image[0]))
+    {
+        result &= AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
+                                          image[0], 1);
+    }
+    else
+    {
+        result &= AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
+                            AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_STANDBY) |
+                            AD5933_CONTROL_RANGE(dev->range) | 
+                            AD5933_CONTROL_PGA_GAIN(dev->gain),
+                            1);
+    }
+    
+    return result;
+}
+
+/***************************************************************************//**
+ * @brief Selects the source of the system clock.
+ *
+ * @param dev        - Device context.
+ * @param clkSource  - Selects the source of the system clock.
+ *                     Example: AD5933_CONTROL_INT_SYSCLK
+ *                              AD5933_CONTROL_EXT_SYSCLK
+ * @param extClkFreq - Frequency value of the external clock, if used.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_SetSystemClk(AD5933_Device *dev,
+                         char clkSource,
+                         unsigned long extClkFreq)
+{
+    dev->clockSource = clkSource;
+    if(clkSource == AD5933_CONTROL_EXT_SYSCLK)
+    {
+        dev->sysClk = extClkFreq;                 // External clock frequency
+    }
+    else
+    {
+        dev->sysClk = AD5933_INTERNAL_SYS_CLK;    // 16 MHz
+    }
+    AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_LB, dev->clockSource, 1);
+}
+
+
+/***************************************************************************//**
+ * @brief Selects the range and gain of the device.
+ *  
+ * @param dev   - Device context.
+ * @param range - Range option.
+ *                Example: AD5933_RANGE_2000mVpp
+ *                         AD5933_RANGE_200mVpp
+ *                         AD5933_RANGE_400mVpp
+
+ *                         AD5933_RANGE_1000mVpp
+ * @param gain  - Gain option.
+ *                Example: AD5933_GAIN_X5
+ *                         AD5933_GAIN_X1
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_SetRangeAndGain(AD5933_Device *dev, char range, char gain)
+{
+    AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
+                         AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_NOP) |
+                         AD5933_CONTROL_RANGE(range) | 
+                         AD5933_CONTROL_PGA_GAIN(gain),
+                         1);
+    /* Store the last settings made to range and gain. */
+    dev->range = range;
+    dev->gain = gain;
+}
+
+/***************************************************************************//**
+ * @brief Sets the number of output cycles the device waits after each
+ *        frequency change before the DFT starts.
+ *
+ * @param dev        - Device context.
+ * @param cycles     - Number of settling cycles. Maximum value is 511.
+ * @param multiplier - Settling cycles multiplier.
+ *                     Example: AD5933_SETTLING_X1
+ *                              AD5933_SETTLING_X2
+ *                              AD5933_SETTLING_X4
+ *
+ * @return true if the register was written.
+*******************************************************************************/
+bool AD5933_SetSettlingCycles(AD5933_Device *dev,
+                              unsigned short cycles,
+                              unsigned char multiplier)
+{
+    if(cycles > AD5933_MAX_SETTLING_CYCLES)
+    {
+        cycles = AD5933_MAX_SETTLING_CYCLES;
+    }
+    
+    return AD5933_SetRegisterValue(dev, AD5933_REG_SETTLING_CYCLES,
+                                   cycles |
+                                   AD5933_SETTLING_MULTIPLIER(multiplier & 0x3),
+                                   2);
+}
+
+/***************************************************************************//**
+ * @brief Encodes a number of settling cycles into the settling register,
+ *        with the smallest multiplier that reaches it.
+ *
+ * @param cycles - Settling cycles wanted, up to 4 * 511.
+ *
+ * @return Value of the settling cycles register (at least cycles).
+*******************************************************************************/
+unsigned short AD5933_EncodeSettlingCycles(unsigned long cycles)
+{
+    if(cycles <= AD5933_MAX_SETTLING_CYCLES)
+    {
+        return (unsigned short)cycles;
+    }
+    if(cycles <= 2 * AD5933_MAX_SETTLING_CYCLES)
+    {
+        return ((cycles + 1) / 2) |
+               AD5933_SETTLING_MULTIPLIER(AD5933_SETTLING_X2);
+    }
+    cycles = (cycles + 3) / 4;
+    
+    return ((cycles > AD5933_MAX_SETTLING_CYCLES) ? AD5933_MAX_SETTLING_CYCLES :
+                                                    cycles) |
+           AD5933_SETTLING_MULTIPLIER(AD5933_SETTLING_X4);
+}
+
+/***************************************************************************//**
+ * @brief Reads the temperature from the part and returns the data in
+ *        degrees Celsius.
+ *
+ * @param dev    - Device context.
+ * @param status - Last status read. If TEMP_VALID is already set the wait
+ *                 for the measurement is skipped.
+ *
+ * @return temperature - Temperature, or NAN if the device did not answer.
+*******************************************************************************/
+float AD5933_GetTemperature(AD5933_Device *dev, unsigned char status)
+{
+    AD5933_PollResult result = AD5933_POLL_PENDING;
+    
+    if(!AD5933_BeginTemperature(dev))
+    {
+        return NAN;
+    }
+    if(status & AD5933_STAT_TEMP_VALID)
+    {
+        result = AD5933_POLL_READY;
+    }
+    while(result == AD5933_POLL_PENDING)
+    {
+        result = AD5933_Poll(dev);
+    }
+    if(result != AD5933_POLL_READY)
+    {
+        return NAN;
+    }
+    
+    return AD5933_CollectTemperature(dev);
+}
+
+/***************************************************************************//**
+ * @brief Converts a frequency into the code of the frequency registers, with
+ *        exact integer arithmetic and rounding to the nearest code.
+ *
+ * @param frequency - Frequency in Hz.
+ * @param sysClk    - System clock frequency in Hz.
+ *
+ * @return Frequency code, limited to 24 bits (0 if sysClk is 0).
+*******************************************************************************/
+unsigned long AD5933_FrequencyToCode(unsigned long frequency,
+                                     unsigned long sysClk)
+{
+    unsigned long long code = 0;
+    
+    if(sysClk == 0)
+    {
+        return 0;
+    }
+    code = AD5933_FREQ_CODE(frequency, sysClk);
+    
+    return (code > AD5933_FREQ_CODE_MAX) ? AD5933_FREQ_CODE_MAX :
+                                           (unsigned long)code;
+}
+
+/***************************************************************************//**
+ * @brief Returns the frequency actually produced by a frequency code.
+ *
+ * @param code   - Frequency code (24 bits).
+ * @param sysClk - System clock frequency in Hz.
+ *
+ * @return Frequency in mHz, rounded to the nearest mHz.
+*******************************************************************************/
+unsigned long AD5933_CodeToFrequency(unsigned long code,
+                                     unsigned long sysClk)
+{
+    unsigned long long millihertz = (unsigned long long)code * sysClk * 1000;
+    
+    millihertz += 1ull << (AD5933_FREQ_CODE_SHIFT - 1);
+    
+    return (unsigned long)(millihertz >> AD5933_FREQ_CODE_SHIFT);
+}
+
+/***************************************************************************//**
+ * @brief Returns the frequency the device excites at a point of a sweep
+ *        profile: start code plus point times increment code.
+ *
+ * @param profile - Profile built by AD5933_CompileSweepProfile.
+ * @param point   - Point of the sweep (0 is the start frequency).
+ *
+ * @return Frequency in mHz.
+*******************************************************************************/
+unsigned long AD5933_GetPointFrequency(const AD5933_SweepProfile *profile,
+                                       unsigned short point)
+{
+    unsigned long  startCode   = 0;
+    unsigned long  incCode     = 0;
+    unsigned short incNum      = 0;
+    unsigned short settlingReg = 0;
+    
+    AD5933_DecodeSweepProfile(profile, &startCode, &incCode, &incNum,
+                              &settlingReg);
+    
+    return AD5933_CodeToFrequency(startCode + (unsigned long)point * incCode,
+                                  profile->sysClk);
+}
+
+/***************************************************************************//**
+ * @brief Encodes a sweep profile from frequency, increment and settling codes.
+ *        This is the only place that knows the register layout of 0x82-0x8B
+ *        (MSB first): 24-bit start code, 24-bit increment code, 9-bit number
+ *        of increments and the settling register.
  *
- * @return status - The result of the initialization procedure.
- *                  Example: -1 - I2C peripheral was not initialized.
- *                            0 - I2C peripheral was initialized.
+ * @param profile     - Profile to fill.
+ * @param startCode   - Start frequency code.
+ * @param incCode     - Frequency increment code.
+ * @param incNum      - Number of increments. Maximum value is 511.
+ * @param settlingReg - Settling register (cycles and multiplier).
+ * @param sysClk      - System clock the codes were computed for.
+ *
+ * @return None.
 *******************************************************************************/
-bool AD5933_Init(int status)
+void AD5933_CompileCodeProfile(AD5933_SweepProfile *profile,
+                               unsigned long  startCode,
+                               unsigned long  incCode,
+                               unsigned short incNum,
+                               unsigned short settlingReg,
+                               unsigned long  sysClk)
 {
-    if(status)
+    // Ensure that incNum is a valid data. 
+    if(incNum > AD5933_MAX_INC_NUM)
     {
-        adress = 0x30;    
-        return true;
+        incNum = AD5933_MAX_INC_NUM;
     }
-    return false;
+    profile->image[0] = (unsigned char)(startCode >> 16);
+    profile->image[1] = (unsigned char)(startCode >> 8);
+    profile->image[2] = (unsigned char)(startCode);
+    profile->image[3] = (unsigned char)(incCode >> 16);
+    profile->image[4] = (unsigned char)(incCode >> 8);
+    profile->image[5] = (unsigned char)(incCode);
+    profile->image[6] = (unsigned char)(incNum >> 8);
+    profile->image[7] = (unsigned char)(incNum);
+    profile->image[8] = (unsigned char)(settlingReg >> 8);
+    profile->image[9] = (unsigned char)(settlingReg);
+    profile->sysClk   = sysClk;
 }
 
 /***************************************************************************//**
- * @brief Writes data into a register.
+ * @brief Decodes the codes of a sweep profile, the reverse of
+ *        AD5933_CompileCodeProfile.
  *
- * @param registerAddress - Address of the register.
- * @param registerValue   - Data value to write.
- * @param bytesNumber     - Number of bytes.
+ * @param profile     - Sweep profile.
+ * @param startCode   - Start frequency code.
+ * @param incCode     - Frequency increment code.
+ * @param incNum      - Number of increments (points - 1).
+ * @param settlingReg - Settling register (cycles and multiplier).
  *
  * @return None.
 *******************************************************************************/
-bool AD5933_SetRegisterValue(unsigned char registerAddress,
-                             unsigned long registerValue,
-                             unsigned char bytesNumber)
+void AD5933_DecodeSweepProfile(const AD5933_SweepProfile *profile,
+                               unsigned long  *startCode,
+                               unsigned long  *incCode,
+                               unsigned short *incNum,
+                               unsigned short *settlingReg)
 {
-    unsigned char byte          = 0;
-    unsigned char writeData[2]  = {0, 0};
-	int status;
+    const unsigned char *image = profile->image;
+    
+    *startCode   = ((unsigned long)image[0] << 16) |
+                   ((unsigned long)image[1] << 8) | image[2];
+    *incCode     = ((unsigned long)image[3] << 16) |
+                   ((unsigned long)image[4] << 8) | image[5];
+    *incNum      = ((image[6] << 8) | image[7]) & AD5933_MAX_INC_NUM;
+    *settlingReg = (unsigned short)((image[8] << 8) | image[9]);
+}
 
-    for(byte = 0;byte < bytesNumber; byte++)
+/***************************************************************************//**
+ * @brief Configures the sweep parameters: Start frequency, Frequency increment
+ *        and Number of increments.
+ *
+ * @param dev       - Device context.
+ * @param startFreq - Start frequency in Hz;
+ * @param incFreq   - Frequency increment in Hz;
+ * @param incNum    - Number of increments. Maximum value is 511(0x1FF).
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_ConfigSweep(AD5933_Device *dev,
+                        unsigned long  startFreq,
+                        unsigned long  incFreq,
+                        unsigned short incNum)
+{
+    AD5933_SweepProfile profile;
+#if AD5933_STATS
+    unsigned long long  start = AD5933_STATS_NOW(dev->stats);
+#endif
+    
+    AD5933_CompileCodeProfile(&profile,
+                              AD5933_FrequencyToCode(startFreq, dev->sysClk),
+                              AD5933_FrequencyToCode(incFreq, dev->sysClk),
+                              incNum, 0, dev->sysClk);
+    
+    AD5933_LOG_INFO(dev->log, AD5933_EVENT_SWEEP_CONFIG,
+                    AD5933_FrequencyToCode(startFreq, dev->sysClk),
+                    AD5933_FrequencyToCode(incFreq, dev->sysClk),
+                    incNum);
+    
+    // Configure the device with the sweep parameters. //
+    AD5933_SetRegisterBlock(dev, AD5933_REG_FREQ_START,
+                            profile.image,
+                            AD5933_SWEEP_BLOCK_SIZE);
+    AD5933_STATS_LATENCY(dev->stats, AD5933_LATENCY_CONFIG, start);
+}
+
+/***************************************************************************//**
+ * @brief Encodes a sweep profile: the register image of start frequency,
+ *        frequency increment, number of increments and settling cycles.
+ *        The codes are computed for the current system clock.
+ *
+ * @param dev                - Device context.
+ * @param profile            - Profile to fill.
+ * @param startFreq          - Start frequency in Hz;
+ * @param incFreq            - Frequency increment in Hz;
+ * @param incNum             - Number of increments. Maximum value is 511.
+ * @param settlingCycles     - Number of settling cycles. Maximum value is 511.
+ * @param settlingMultiplier - Settling cycles multiplier.
+ *                             Example: AD5933_SETTLING_X1
+ *                                      AD5933_SETTLING_X2
+ *                                      AD5933_SETTLING_X4
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_CompileSweepProfile(AD5933_Device *dev,
+                                AD5933_SweepProfile *profile,
+                                unsigned long  startFreq,
+                                unsigned long  incFreq,
+                                unsigned short incNum,
+                                unsigned short settlingCycles,
+                                unsigned char  settlingMultiplier)
+{
+    unsigned short settlingReg = 0;
+    
+    if(settlingCycles > AD5933_MAX_SETTLING_CYCLES)
     {
-        writeData[0] = registerAddress + bytesNumber - byte - 1;
-        writeData[1] = (unsigned char)((registerValue >> (byte * 8)) & 0xFF);
-        wiringPiI2CWriteReg8(i2cdevice,writeData[0],writeData[1]);
+        settlingCycles = AD5933_MAX_SETTLING_CYCLES;
     }
+    settlingReg = settlingCycles |
+                  AD5933_SETTLING_MULTIPLIER(settlingMultiplier & 0x3);
+    
+    AD5933_CompileCodeProfile(profile,
+                              AD5933_FrequencyToCode(startFreq, dev->sysClk),
+                              AD5933_FrequencyToCode(incFreq, dev->sysClk),
+                              incNum, settlingReg, dev->sysClk);
 }
 
 /***************************************************************************//**
- * @brief Reads the value of a register.
+ * @brief Loads a precompiled sweep profile with one block write.
  *
- * @param registerAddress - Address of the register.
- * @param bytesNumber     - Number of bytes.
+ * @param dev     - Device context.
+ * @param profile - Profile built by AD5933_CompileSweepProfile.
  *
- * @return registerValue  - Value of the register.
+ * @return false if the profile was compiled for another system clock or the
+ *         write failed.
 *******************************************************************************/
-unsigned long AD5933_GetRegisterValue(unsigned char registerAddress, unsigned char bytesNumber)
+bool AD5933_LoadSweepProfile(AD5933_Device *dev,
+                             const AD5933_SweepProfile *profile)
 {
-    unsigned long registerValue = 0;
-    unsigned char byte          = 0;
-    unsigned char writeData[2]  = {0, 0};
-    unsigned char readData[2]   = {0, 0};
-    int tmp = 0;
+#if AD5933_STATS
+    unsigned long long start  = AD5933_STATS_NOW(dev->stats);
+#endif
+    bool               result = false;
     
-    for(byte = 0;byte < bytesNumber;byte ++)
+    if(profile->sysClk != dev->sysClk)
     {
-        // Read byte from specified registerAddress memory place
-		tmp = wiringPiI2CReadReg8(i2cdevice,registerAddress);
-		//printf("\t\tReading from Register Address: 0x%02x...0x%02x\n",registerAddress,tmp);
-		// Add this temporal value to our registerValue (remembering that
-		// we are reading bytes that have location value, which means that
-		// each measure we have we not only have to add it to the previous
-		// register value but we also but do a bitwise shift (<< 8) by 1 byte
-		registerValue = registerValue << 8;
-        registerValue += tmp;
-        // Update value from registerAddress to read next memory position byte
-        registerAddress = registerAddress + 1;
+        return false;
     }
+    result = AD5933_SetRegisterBlock(dev, AD5933_REG_FREQ_START,
+                                     profile->image,
+                                     AD5933_PROFILE_SIZE);
+    AD5933_STATS_LATENCY(dev->stats, AD5933_LATENCY_CONFIG, start);
     
-    return registerValue;
+    return result;
 }
 
 /***************************************************************************//**
- * @brief Resets the device.
+ * @brief Sends the command sequence that starts a sweep: standby, reset,
+ *        initialize with start frequency and start sweep. A backend with a
+ *        submit call gets the four commands at once.
  *
- * @return None.
+ * @param dev - Device context.
+ *
+ * @return true if all the commands were sent.
 *******************************************************************************/
-void AD5933_Reset(void)
+static bool AD5933_IssueSweepStart(AD5933_Device *dev)
 {
-    AD5933_SetRegisterValue(AD5933_REG_CONTROL_LB, 
-                            AD5933_CONTROL_RESET | currentClockSource,
+    AD5933_BusOp ops[4];
+    bool         own    = AD5933_OpenCallBatch(dev, ops, 4);
+    bool         result = true;
+    
+    // put AD5933 in standby mode (required, see datasheet)
+    result &= AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
+                            AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_STANDBY) |
+                            AD5933_CONTROL_RANGE(dev->range) | 
+                            AD5933_CONTROL_PGA_GAIN(dev->gain),
                             1);
+	// Reset device
+    result &= AD5933_Reset(dev);
+    
+    // Initialize sweep with start frequency (this does not start the sweep,
+    // just initializes some parameters)
+    result &= AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
+                       AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_INIT_START_FREQ)|
+                       AD5933_CONTROL_RANGE(dev->range) | 
+                       AD5933_CONTROL_PGA_GAIN(dev->gain),
+                       1);
+    
+    // Start the Sweep
+    result &= AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
+                       AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_START_SWEEP) | 
+                       AD5933_CONTROL_RANGE(dev->range) | 
+                       AD5933_CONTROL_PGA_GAIN(dev->gain),
+                       1);
+    if(own)
+    {
+        result = AD5933_SubmitBatch(dev) && result;
+    }
+    
+    return result;
 }
 
 /***************************************************************************//**
- * @brief Selects the source of the system clock.
+ * @brief Sets how many polls an operation may stay pending before it times
+ *        out. The caller's poll rate gives the equivalent time.
  *
- * @param clkSource  - Selects the source of the system clock.
- *                     Example: AD5933_CONTROL_INT_SYSCLK
- *                              AD5933_CONTROL_EXT_SYSCLK
- * @param extClkFreq - Frequency value of the external clock, if used.
+ * @param dev       - Device context.
+ * @param pollLimit - Number of polls. 0 waits forever.
  *
  * @return None.
 *******************************************************************************/
-void AD5933_SetSystemClk(char clkSource, unsigned long extClkFreq)
+void AD5933_SetPollLimit(AD5933_Device *dev, unsigned long pollLimit)
 {
-    currentClockSource = clkSource;
-    if(clkSource == AD5933_CONTROL_EXT_SYSCLK)
+    dev->pollLimit = pollLimit;
+}
+
+/***************************************************************************//**
+ * @brief Starts a temperature measurement without waiting for it.
+ *
+ * @param dev - Device context.
+ *
+ * @return true if the command was sent.
+*******************************************************************************/
+bool AD5933_BeginTemperature(AD5933_Device *dev)
+{
+    dev->pendingStatus = 0;
+    if(!AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
+                         AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_MEASURE_TEMP) |
+                         AD5933_CONTROL_RANGE(dev->range) | 
+                         AD5933_CONTROL_PGA_GAIN(dev->gain),
+                         1))
     {
-        currentSysClk = extClkFreq;                 // External clock frequency
+        return false;
     }
-    else
+    dev->pendingStatus = AD5933_STAT_TEMP_VALID;
+    dev->pollCount     = 0;
+#if AD5933_STATS
+    dev->pendingSinceNs = AD5933_STATS_NOW(dev->stats);
+#endif
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Starts a sweep without waiting for the first point.
+ *
+ * @param dev - Device context.
+ *
+ * @return true if the commands were sent.
+*******************************************************************************/
+bool AD5933_BeginSweep(AD5933_Device *dev)
+{
+    dev->pendingStatus = 0;
+    if(!AD5933_IssueSweepStart(dev))
     {
-        currentSysClk = AD5933_INTERNAL_SYS_CLK;    // 16 MHz
+        return false;
     }
-    AD5933_SetRegisterValue(AD5933_REG_CONTROL_LB, currentClockSource, 1);
+    dev->pendingStatus = AD5933_STAT_DATA_VALID;
+    dev->pollCount     = 0;
+#if AD5933_STATS
+    dev->pendingSinceNs = AD5933_STATS_NOW(dev->stats);
+#endif
+    
+    return true;
 }
 
-
 /***************************************************************************//**
- * @brief Selects the range and gain of the device.
- *  
- * @param range - Range option.
- *                Example: AD5933_RANGE_2000mVpp
- *                         AD5933_RANGE_200mVpp
- *                         AD5933_RANGE_400mVpp
+ * @brief Measures the next point of a sweep without waiting for it.
+ *
+ * @param dev          - Device context.
+ * @param freqFunction - AD5933_FUNCTION_INC_FREQ or AD5933_FUNCTION_REPEAT_FREQ.
+ *
+ * @return true if the command was sent.
+*******************************************************************************/
+bool AD5933_BeginPoint(AD5933_Device *dev, char freqFunction)
+{
+    dev->pendingStatus = 0;
+    if(!AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
+                                AD5933_CONTROL_FUNCTION(freqFunction) |
+                                AD5933_CONTROL_RANGE(dev->range) | 
+                                AD5933_CONTROL_PGA_GAIN(dev->gain),
+                                1))
+    {
+        return false;
+    }
+    dev->pendingStatus = AD5933_STAT_DATA_VALID;
+    dev->pollCount     = 0;
+#if AD5933_STATS
+    dev->pendingSinceNs = AD5933_STATS_NOW(dev->stats);
+#endif
+    
+    return true;
+}
 
- *                         AD5933_RANGE_1000mVpp
- * @param gain  - Gain option.
- *                Example: AD5933_GAIN_X5
- *                         AD5933_GAIN_X1
+/***************************************************************************//**
+ * @brief Checks once if the pending operation has finished. Polls are block
+ *        reads from STATUS, so a ready point already holds its data and a
+ *        bus error is never mistaken for a status.
  *
- * @return None.
+ * @param dev - Device context.
+ *
+ * @return AD5933_POLL_PENDING - Not finished, poll again later.
+ *         AD5933_POLL_READY   - Finished, the result can be collected.
+ *         AD5933_POLL_TIMEOUT - The poll limit was reached.
+ *         AD5933_POLL_ERROR   - Bus error or no operation pending.
 *******************************************************************************/
-void AD5933_SetRangeAndGain(char range, char gain)
+AD5933_PollResult AD5933_Poll(AD5933_Device *dev)
 {
-    AD5933_SetRegisterValue(AD5933_REG_CONTROL_HB,
-                         AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_NOP) |
-                         AD5933_CONTROL_RANGE(range) | 
-                         AD5933_CONTROL_PGA_GAIN(gain),
-                         1);
-    /* Store the last settings made to range and gain. */
-    currentRange = range;
-    currentGain = gain;
+    if(dev->pendingStatus == 0)
+    {
+        return AD5933_POLL_ERROR;
+    }
+    if(dev->pendingStatus == AD5933_STAT_TEMP_VALID)
+    {
+        if(!AD5933_GetRegisterBlock(dev, AD5933_REG_STATUS, &dev->lastStatus, 1))
+        {
+            dev->pendingStatus = 0;
+            return AD5933_POLL_ERROR;
+        }
+    }
+    else if(!AD5933_GetData(dev, &dev->lastReal, &dev->lastImag,
+                            &dev->lastStatus))
+    {
+        dev->pendingStatus = 0;
+        return AD5933_POLL_ERROR;
+    }
+    if(dev->lastStatus & dev->pendingStatus)
+    {
+        if(dev->pendingStatus == AD5933_STAT_TEMP_VALID)
+        {
+            AD5933_STATS_COUNT(dev->stats, AD5933_COUNTER_TEMP_POLLS,
+                               dev->pollCount + 1);
+            AD5933_STATS_COUNT(dev->stats, AD5933_COUNTER_TEMP_WAITS, 1);
+        }
+        else
+        {
+            AD5933_STATS_COUNT(dev->stats, AD5933_COUNTER_DATA_POLLS,
+                               dev->pollCount + 1);
+            AD5933_STATS_COUNT(dev->stats, AD5933_COUNTER_DATA_WAITS, 1);
+            AD5933_STATS_LATENCY(dev->stats, AD5933_LATENCY_POINT,
+                                 dev->pendingSinceNs);
+        }
+        dev->pendingStatus = 0;
+        return AD5933_POLL_READY;
+    }
+    dev->pollCount++;
+    if((dev->pollLimit != 0) && (dev->pollCount >= dev->pollLimit))
+    {
+        AD5933_LOG_WARN(dev->log, AD5933_EVENT_POLL_TIMEOUT, dev->pollCount, 0, 0);
+        dev->pendingStatus = 0;
+        return AD5933_POLL_TIMEOUT;
+    }
+    
+    return AD5933_POLL_PENDING;
 }
 
 /***************************************************************************//**
- * @brief Reads the temperature from the part and returns the data in
- *        degrees Celsius.
+ * @brief Reads the result of a finished temperature measurement.
+ *
+ * @param dev - Device context.
  *
- * @return temperature - Temperature.
+ * @return temperature - Temperature in degrees Celsius, NAN on a bus error.
 *******************************************************************************/
-float AD5933_GetTemperature(unsigned char status)
+float AD5933_CollectTemperature(AD5933_Device *dev)
 {
     float         temperature = 0;
-    //unsigned char status      = 0;
+    unsigned long code        = 0;
     
-    AD5933_SetRegisterValue(AD5933_REG_CONTROL_HB,
-                         AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_MEASURE_TEMP) |
-                         AD5933_CONTROL_RANGE(currentRange) | 
-                         AD5933_CONTROL_PGA_GAIN(currentGain),                             
-                         1);
-    while((status & AD5933_STAT_TEMP_VALID) == 0)
+    dev->pendingStatus = 0;
+    if(!AD5933_ReadRegisterValue(dev, AD5933_REG_TEMP_DATA, 2, &code))
     {
-        status = AD5933_GetRegisterValue(AD5933_REG_STATUS,1);
+        return NAN;
     }
-    
-    temperature = AD5933_GetRegisterValue(AD5933_REG_TEMP_DATA,2);
+    temperature = code;
+    AD5933_STATS_LATENCY(dev->stats, AD5933_LATENCY_TEMPERATURE,
+                         dev->pendingSinceNs);
     if(temperature < 8192)
     {
         temperature /= 32;
@@ -208,262 +1551,343 @@ float AD5933_GetTemperature(unsigned char status)
 }
 
 /***************************************************************************//**
- * @brief Configures the sweep parameters: Start frequency, Frequency increment
- *        and Number of increments.
+ * @brief Returns the point read by the poll that found it ready.
  *
- * @param startFreq - Start frequency in Hz;
- * @param incFreq   - Frequency increment in Hz;
- * @param incNum    - Number of increments. Maximum value is 511(0x1FF).
+ * @param dev      - Device context.
+ * @param realData - Real part of the DFT result.
+ * @param imagData - Imaginary part of the DFT result.
+ * @param status   - Status register of that poll (e.g. AD5933_STAT_SWEEP_DONE).
  *
  * @return None.
 *******************************************************************************/
-void AD5933_ConfigSweep(unsigned long  startFreq,
-                        unsigned long  incFreq,
-                        unsigned short incNum)
+void AD5933_CollectData(AD5933_Device *dev,
+                        signed short *realData,
+                        signed short *imagData,
+                        unsigned char *status)
+{
+    *realData = dev->lastReal;
+    *imagData = dev->lastImag;
+    *status   = dev->lastStatus;
+}
+
+/***************************************************************************//**
+ * @brief Polls the pending operation until it is no longer pending.
+ *
+ * @param dev - Device context.
+ *
+ * @return The last poll result.
+*******************************************************************************/
+static AD5933_PollResult AD5933_WaitReady(AD5933_Device *dev)
 {
-    unsigned long  startFreqReg = 0;
-    unsigned long  incFreqReg   = 0;
-    unsigned short incNumReg    = 0;
+    AD5933_PollResult result = AD5933_POLL_PENDING;
     
-    // Ensure that incNum is a valid data. 
-    if(incNum > AD5933_MAX_INC_NUM)
+    while(result == AD5933_POLL_PENDING)
     {
-        incNumReg = AD5933_MAX_INC_NUM;
+        result = AD5933_Poll(dev);
     }
-    else
+    
+    return result;
+}
+
+/***************************************************************************//**
+ * @brief Starts the sweep operation.
+ *
+ * @param dev - Device context.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_StartSweep(AD5933_Device *dev)
+{
+    if(AD5933_BeginSweep(dev))
     {
-        incNumReg = incNum;
+        AD5933_WaitReady(dev);
     }
+}
+
+/***************************************************************************//**
+ * @brief Runs a complete sweep with the last configured parameters and stores
+ *        the raw real and imaginary data of every point in the buffer.
+ *        Each poll is a single block read that returns the status and the
+ *        data together, so a point costs its polls plus one INC_FREQ write.
+ *        Each point also goes to the point callback and ring as soon as it
+ *        is read, so consumers can work while the sweep goes on.
+ *
+ * @param dev    - Device context.
+ * @param buffer - Caller-owned result buffer. Its capacity should be at least
+ *                 the number of increments + 1 (AD5933_MAX_POINTS). Its
+ *                 arrays may be NULL if the points are only streamed.
+ *
+ * @return true if the sweep completed; buffer->count holds the number of
+ *         points read in any case.
+*******************************************************************************/
+bool AD5933_RunSweep(AD5933_Device *dev, AD5933_SweepBuffer *buffer)
+{
+    unsigned char      status   = 0;
+    signed short       realData = 0;
+    signed short       imagData = 0;
+#if AD5933_STATS
+    unsigned long long start    = AD5933_STATS_NOW(dev->stats);
+#endif
     
-    // Convert users start frequency to binary code. //
-    startFreqReg = (unsigned long)((double)startFreq * 4 / currentSysClk *
-                                   POW_2_27);
-   
-    // Convert users increment frequency to binary code. //
-    incFreqReg = (unsigned long)((double)incFreq * 4 / currentSysClk * 
-                                 POW_2_27);
-    
-    
-    printf("\tNumber of Points = %d (0x%04x)\n",incNum,incNum);
+    buffer->count = 0;
+    if(!AD5933_BeginSweep(dev))
+    {
+        return false;
+    }
+    while(buffer->count < buffer->capacity)
+    {
+        if(AD5933_WaitReady(dev) != AD5933_POLL_READY)
+        {
+            return false;
+        }
+        AD5933_CollectData(dev, &realData, &imagData, &status);
+        AD5933_PublishPoint(dev, buffer, realData, imagData, status);
+        if(status & AD5933_STAT_SWEEP_DONE)
+        {
+            AD5933_STATS_LATENCY(dev->stats, AD5933_LATENCY_SWEEP, start);
+            return true;
+        }
+        // Move on to the next frequency point
+        if(!AD5933_BeginPoint(dev, AD5933_FUNCTION_INC_FREQ))
+        {
+            return false;
+        }
+    }
     
-    // Configure the device with the sweep parameters. //
-    AD5933_SetRegisterValue(AD5933_REG_FREQ_START,
-                            startFreqReg,
-                            3);
-    AD5933_SetRegisterValue(AD5933_REG_FREQ_INC,
-                            incFreqReg,
-                            3);
-    AD5933_SetRegisterValue(AD5933_REG_INC_NUM,
-                            incNumReg,
-                            2);
+    return false;
 }
 
 /***************************************************************************//**
- * @brief Starts the sweep operation.
+ * @brief Adds a sample to a running mean and sum of squared deviations
+ *        (Welford), so no sample has to be stored.
+ *
+ * @param count - Samples including this one.
+ * @param mean  - Running mean.
+ * @param m2    - Running sum of squared deviations from the mean.
+ * @param value - New sample.
  *
  * @return None.
 *******************************************************************************/
-void AD5933_StartSweep(void)
+static void AD5933_WelfordUpdate(unsigned short count,
+                                 double *mean,
+                                 double *m2,
+                                 double value)
 {
-    unsigned char status = 0;
-    
-    // put AD5933 in standby mode (required, see datasheet)
-    AD5933_SetRegisterValue(AD5933_REG_CONTROL_HB,
-                            AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_STANDBY) |
-                            AD5933_CONTROL_RANGE(currentRange) | 
-                            AD5933_CONTROL_PGA_GAIN(currentGain),
-                            1);
-	// Reset device
-    AD5933_Reset();
+    double delta = value - *mean;
     
-    // Initialize sweep with start frequency (this does not start the sweep,
-    // just initializes some parameters)
-    AD5933_SetRegisterValue(AD5933_REG_CONTROL_HB,
-                       AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_INIT_START_FREQ)|
-                       AD5933_CONTROL_RANGE(currentRange) | 
-                       AD5933_CONTROL_PGA_GAIN(currentGain),
-                       1);
+    *mean += delta / count;
+    *m2   += delta * (value - *mean);
+}
+
+/***************************************************************************//**
+ * @brief Runs a sweep that measures each point up to maxSamples times with
+ *        REPEAT_FREQ before moving on with INC_FREQ, so settling and setup
+ *        are paid once per sweep. Mean and variance are accumulated in a
+ *        single pass. A point stops early once both standard errors are at
+ *        or below targetStdErr (after AD5933_AVERAGE_MIN_SAMPLES samples).
+ *        The mean of each point is published like in AD5933_RunSweep.
+ *
+ * @param dev          - Device context.
+ * @param buffer       - Caller-owned buffer for the rounded mean of each point.
+ * @param averages     - Mean, standard error and samples of each point, with
+ *                       room for buffer->capacity points; NULL if not needed.
+ * @param maxSamples   - DFT results per point (1 behaves as AD5933_RunSweep).
+ * @param targetStdErr - Standard error (in DFT counts) that ends a point
+ *                       early; 0 always takes maxSamples.
+ *
+ * @return true if the sweep completed; buffer->count holds the number of
+ *         points stored in any case.
+*******************************************************************************/
+bool AD5933_RunAveragedSweep(AD5933_Device *dev,
+                             AD5933_SweepBuffer *buffer,
+                             AD5933_PointAverage *averages,
+                             unsigned short maxSamples,
+                             float targetStdErr)
+{
+    unsigned char  status   = 0;
+    bool           done     = false;
+    unsigned short samples  = 0;
+    signed short   realData = 0;
+    signed short   imagData = 0;
+    double         meanReal = 0;
+    double         meanImag = 0;
+    double         m2Real   = 0;
+    double         m2Imag   = 0;
+    double         varLimit = (double)targetStdErr * targetStdErr;
+#if AD5933_STATS
+    unsigned long long start = AD5933_STATS_NOW(dev->stats);
+#endif
     
-    // Start the Sweep
-    AD5933_SetRegisterValue(AD5933_REG_CONTROL_HB,
-                       AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_START_SWEEP) | 
-                       AD5933_CONTROL_RANGE(currentRange) | 
-                       AD5933_CONTROL_PGA_GAIN(currentGain),
-                       1);
-    status = 0;
-    while((status & AD5933_STAT_DATA_VALID) == 0)
+    buffer->count = 0;
+    maxSamples    = (maxSamples == 0) ? 1 : maxSamples;
+    if(!AD5933_BeginSweep(dev))
+    {
+        return false;
+    }
+    while(buffer->count < buffer->capacity)
     {
-        status = AD5933_GetRegisterValue(AD5933_REG_STATUS,1);
-    };
+        samples  = 0;
+        meanReal = meanImag = m2Real = m2Imag = 0;
+        done     = false;
+        while(true)
+        {
+            if(AD5933_WaitReady(dev) != AD5933_POLL_READY)
+            {
+                return false;
+            }
+            AD5933_CollectData(dev, &realData, &imagData, &status);
+            done |= (status & AD5933_STAT_SWEEP_DONE) != 0;
+            samples++;
+            AD5933_WelfordUpdate(samples, &meanReal, &m2Real, realData);
+            AD5933_WelfordUpdate(samples, &meanImag, &m2Imag, imagData);
+            // Variance of the mean: m2 / (n - 1) / n
+            if((samples >= maxSamples) ||
+               ((targetStdErr > 0) && (samples >= AD5933_AVERAGE_MIN_SAMPLES) &&
+                (m2Real <= varLimit * (samples - 1) * samples) &&
+                (m2Imag <= varLimit * (samples - 1) * samples)))
+            {
+                break;
+            }
+            if(!AD5933_BeginPoint(dev, AD5933_FUNCTION_REPEAT_FREQ))
+            {
+                return false;
+            }
+        }
+        if(averages != 0)
+        {
+            averages[buffer->count].meanReal   = (float)meanReal;
+            averages[buffer->count].meanImag   = (float)meanImag;
+            averages[buffer->count].stdErrReal = (samples > 1) ?
+                (float)sqrt(m2Real / (samples - 1) / samples) : 0;
+            averages[buffer->count].stdErrImag = (samples > 1) ?
+                (float)sqrt(m2Imag / (samples - 1) / samples) : 0;
+            averages[buffer->count].samples    = samples;
+        }
+        AD5933_PublishPoint(dev, buffer, (signed short)lround(meanReal),
+                            (signed short)lround(meanImag),
+                            done ? AD5933_STAT_SWEEP_DONE | status : status);
+        if(done)
+        {
+            AD5933_STATS_LATENCY(dev->stats, AD5933_LATENCY_SWEEP, start);
+            return true;
+        }
+        if(!AD5933_BeginPoint(dev, AD5933_FUNCTION_INC_FREQ))
+        {
+            return false;
+        }
+    }
+    
+    return false;
 }
 
 /******************************************************************************
 * @brief Calculate gain factor
 *
+* @param dev                  - Device context.
+*
 * @param calibrationImpedance - Known value of connected impedance for calibration.
 *
 * @param freqFunction - Select Repeat Frequency Sweep.
 *
-* @return gainFactor.
+* @return gainFactor, or 0 if the device returned no signal.
 ******************************************************************************/
-double AD5933_CalculateGainFactor(unsigned long calibrationImpedance,char freqFunction)
+double AD5933_CalculateGainFactor(AD5933_Device *dev,
+                                  unsigned long calibrationImpedance,
+                                  char freqFunction)
 {
 	double       gainFactor = 0;
 	double       magnitude  = 0;
-	int          status     = 0;
-	signed short realData   = 0;
-	signed short imgData    = 0;
 
 	// Repeat frequency sweep with last set parameters
-	AD5933_SetRegisterValue(AD5933_REG_CONTROL_HB,
+	AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
 							AD5933_CONTROL_FUNCTION(freqFunction)|
-                            AD5933_CONTROL_RANGE(currentRange) | 
-                            AD5933_CONTROL_PGA_GAIN(currentGain),
+                            AD5933_CONTROL_RANGE(dev->range) | 
+                            AD5933_CONTROL_PGA_GAIN(dev->gain),
 							1);
 
 	// Get real and imaginary reg parts
 	signed short RealPart = 0;
 	signed short ImagPart = 0;
-	unsigned char byte = 0;
-	int tmp = 0;
-	
-	unsigned char registerAddress = AD5933_REG_REAL_DATA;
-	for(byte = 0;byte < 2;byte ++)
-	{
-		// Read byte from specified registerAddress memory place
-		tmp = wiringPiI2CReadReg8(i2cdevice,registerAddress);
-		printf("\t\tReading from Register Address: 0x%02x...0x%02x\n",registerAddress,tmp);
-		// Add this temporal value to our registerValue (remembering that
-		// we are reading bytes that have location value, which means that
-		// each measure we have we not only have to add it to the previous
-		// register value but we also but do a bitwise shift (<< 8) by 1 byte
-		RealPart = RealPart << 8;
-		RealPart += tmp;
-		// Update value from registerAddress to read next memory position byte
-		registerAddress = registerAddress + 1;
-	}
+	AD5933_GetData(dev, &RealPart, &ImagPart, 0);
 	
 	
-	registerAddress = AD5933_REG_IMAG_DATA;
-	for(byte = 0;byte < 2;byte ++)
+	AD5933_LOG_INFO(dev->log, AD5933_EVENT_CALIBRATION_STEP,
+	                RealPart, ImagPart, 0);
+	magnitude = sqrt(((double)RealPart * RealPart) +
+	                 ((double)ImagPart * ImagPart));
+	if(magnitude == 0)
 	{
-		// Read byte from specified registerAddress memory place
-		tmp = wiringPiI2CReadReg8(i2cdevice,registerAddress);
-		printf("\t\tReading from Register Address: 0x%02x...0x%02x\n",registerAddress,tmp);
-		// Add this temporal value to our registerValue (remembering that
-		// we are reading bytes that have location value, which means that
-		// each measure we have we not only have to add it to the previous
-		// register value but we also but do a bitwise shift (<< 8) by 1 byte
-		ImagPart = ImagPart << 8;
-		ImagPart += tmp;
-		// Update value from registerAddress to read next memory position byte
-		registerAddress = registerAddress + 1;
+		return 0;
 	}
 	
-	
-	//magnitude = sqrt((RealPart * RealPart) + (ImagPart * ImagPart));
-	magnitude = 2;
-	
 	// Calculate gain factor
 	gainFactor = 1 / (magnitude * calibrationImpedance);
 
-	printf("Calibration Step:\n\tR=%hi\n\tI=%hi\n\t|Z|=%f\n",realData,imgData,magnitude);
-
 	return(gainFactor);
 }
 
 /******************************************************************************
 * @brief Calculate impedance.
 *
+* @param dev        - Device context.
+*
 * @param gainFactor - Gain factor calculated using a known impedance.
 *
 * @param freqFunction - Select Repeat Frequency Sweep.
 *
-* @return impedance.
+* @return impedance magnitude in ohms, or 0 if there was no valid point.
 ******************************************************************************/
-double AD5933_CalculateImpedance(double gainFactor,
-								 char freqFunction)
+double AD5933_CalculateImpedance(AD5933_Device *dev,
+                                 double gainFactor,
+                                 char freqFunction)
 {
-	signed short realData   = 0;
-	signed short imgData    = 0;
 	double       magnitude  = 0;
 	double       impedance  = 0;
-	int          status     = 0;
 
 	// Repeat frequency sweep with last set parameters
-	AD5933_SetRegisterValue(AD5933_REG_CONTROL_HB,
-							AD5933_CONTROL_FUNCTION(freqFunction)|
-                            AD5933_CONTROL_RANGE(currentRange) | 
-                            AD5933_CONTROL_PGA_GAIN(currentGain),
-							1);
-
-
-
-	// Wait for data received to be valid
-	while((status & AD5933_STAT_DATA_VALID) == 0)
+	if(!AD5933_BeginPoint(dev, freqFunction))
 	{
-		status = AD5933_GetRegisterValue(AD5933_REG_STATUS,1);
+		return 0;
 	}
-	
-	
-	// Get real and imaginary reg parts
+
+	// Wait for data received to be valid. The status and the data come in
+	// the same block read.
 	signed short RealPart = 0;
 	signed short ImagPart = 0;
-	unsigned char byte          = 0;
-	int tmp = 0;
-	
-	unsigned char registerAddress = AD5933_REG_REAL_DATA;
-	for(byte = 0;byte < 2;byte ++)
+	unsigned char dataStatus = 0;
+	if(AD5933_WaitReady(dev) != AD5933_POLL_READY)
 	{
-		// Read byte from specified registerAddress memory place
-		tmp = wiringPiI2CReadReg8(i2cdevice,registerAddress);
-		//printf("\t\tReading from Register Address: 0x%02x...0x%02x\n",registerAddress,tmp);
-		// Add this temporal value to our registerValue (remembering that
-		// we are reading bytes that have location value, which means that
-		// each measure we have we not only have to add it to the previous
-		// register value but we also but do a bitwise shift (<< 8) by 1 byte
-		RealPart = RealPart << 8;
-		RealPart += tmp;
-		// Update value from registerAddress to read next memory position byte
-		registerAddress = registerAddress + 1;
+		return 0;
 	}
+	AD5933_CollectData(dev, &RealPart, &ImagPart, &dataStatus);
 	
-	
-	registerAddress = AD5933_REG_IMAG_DATA;
-	for(byte = 0;byte < 2;byte ++)
+	magnitude = sqrt(((double)RealPart * RealPart) +
+	                 ((double)ImagPart * ImagPart));
+	if((magnitude == 0) || (gainFactor == 0))
 	{
-		// Read byte from specified registerAddress memory place
-		tmp = wiringPiI2CReadReg8(i2cdevice,registerAddress);
-		//printf("\t\tReading from Register Address: 0x%02x...0x%02x\n",registerAddress,tmp);
-		// Add this temporal value to our registerValue (remembering that
-		// we are reading bytes that have location value, which means that
-		// each measure we have we not only have to add it to the previous
-		// register value but we also but do a bitwise shift (<< 8) by 1 byte
-		ImagPart = ImagPart << 8;
-		ImagPart += tmp;
-		// Update value from registerAddress to read next memory position byte
-		registerAddress = registerAddress + 1;
+		return 0;
 	}
+	impedance = 1 / (gainFactor * magnitude);
 	
-	magnitude = 2;
-	
-	return magnitude;
+	return impedance;
 }
 
 
 /**************************************************************************//**
  * @brief Set AD5933 to standby mode
  * 
+ * @param dev - Device context.
+ *
  * @return none
  * 
 *******************************************************************************/
-bool AD5933_SetToStandBy(void)
+bool AD5933_SetToStandBy(AD5933_Device *dev)
 {
 	bool resultado;
-    resultado = AD5933_SetRegisterValue(AD5933_REG_CONTROL_HB,
+    resultado = AD5933_SetRegisterValue(dev, AD5933_REG_CONTROL_HB,
 								AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_STANDBY) |
-								AD5933_CONTROL_RANGE(currentRange) | 
-								AD5933_CONTROL_PGA_GAIN(currentGain),
+								AD5933_CONTROL_RANGE(dev->range) | 
+								AD5933_CONTROL_PGA_GAIN(dev->gain),
 								1);
     return resultado;
 }
@@ -10,6 +10,8 @@
 #define __AD5933_H__
 
 #include "stdbool.h"
+#include "AD5933_Log.h"
+#include "AD5933_Stats.h"
 /******************************************************************************/
 /************************** AD5933 Definitions ********************************/
 /******************************************************************************/
@@ -56,6 +58,14 @@
 #define AD5933_GAIN_X5              0
 #define AD5933_GAIN_X1              1
 
+/* AD5933_REG_SETTLING_CYCLES Bits */
+#define AD5933_SETTLING_MULTIPLIER(x)   ((x) << 9)
+
+/* AD5933_SETTLING_MULTIPLIER(x) options */
+#define AD5933_SETTLING_X1          0x0
+#define AD5933_SETTLING_X2          0x1
+#define AD5933_SETTLING_X4          0x3
+
 /* AD5933_REG_STATUS Bits */
 #define AD5933_STAT_TEMP_VALID      (0x1 << 0)
 #define AD5933_STAT_DATA_VALID      (0x1 << 1)
@@ -69,53 +79,360 @@
 #define AD5933_BLOCK_READ           0xA1
 #define AD5933_ADDR_POINTER         0xB0
 
+/* AD5933 Bus operations, the entries of a batch */
+#define AD5933_BUS_WRITE_REG8       0x0     // Byte write (register or pointer)
+#define AD5933_BUS_READ_REG8        0x1     // Byte read of a register
+#define AD5933_BUS_WRITE_BLOCK      0x2     // Block write command
+#define AD5933_BUS_READ_BLOCK       0x3     // Block read command
+#define AD5933_BUS_MAX_DATA         16      // Bytes written by one operation
+
+/* AD5933 Block Read sizes */
+#define AD5933_DATA_BLOCK_SIZE      4       // REAL_DATA to IMAG_DATA (0x94-0x97)
+#define AD5933_STATUS_BLOCK_SIZE    9       // STATUS to IMAG_DATA (0x8F-0x97)
+
+/* AD5933 Block Write sizes */
+#define AD5933_SWEEP_BLOCK_SIZE     8       // FREQ_START to INC_NUM (0x82-0x89)
+#define AD5933_PROFILE_SIZE         10      // FREQ_START to SETTLING (0x82-0x8B)
+
+/* AD5933 Writable registers */
+#define AD5933_SHADOW_SIZE          12      // CONTROL_HB to SETTLING (0x80-0x8B)
+
 /* AD5933 Specifications */
 #define AD5933_INTERNAL_SYS_CLK     16000000ul      // 16MHz
 #define AD5933_MAX_INC_NUM          511             // Maximum increment number
+#define AD5933_MAX_POINTS           (AD5933_MAX_INC_NUM + 1)    // Points per sweep
+#define AD5933_MAX_SETTLING_CYCLES  511             // Maximum settling cycles
+#define AD5933_DFT_SAMPLES          1024            // ADC samples of each DFT
+#define AD5933_ADC_DIVIDER          16              // ADC sample rate is MCLK / 16
+#define AD5933_DEFAULT_POLL_LIMIT   10000           // Polls before a timeout
+#define AD5933_AVERAGE_MIN_SAMPLES  3               // Samples before an early stop
 #define AD5933_CALIBRATION_RFB		20000			// Calibration voltage-to-current gain feedback resistor is 20k for the pmodIA board
 
+/* AD5933 Frequency codes */
+#define AD5933_FREQ_CODE_MAX        0xFFFFFFul      // 24-bit frequency registers
+#define AD5933_FREQ_CODE_SHIFT      29              // code = freq * 2^27 / (clk / 4)
+
+/* Frequency code of freq (Hz) with the system clock clk (Hz), rounded to the
+   nearest code. Integer only, so constant arguments are folded by the
+   compiler and can initialize tables. */
+#define AD5933_FREQ_CODE(freq, clk) \
+    ((unsigned long)((((unsigned long long)(freq) << AD5933_FREQ_CODE_SHIFT) + \
+                      ((clk) / 2)) / (clk)))
+
+/* Frequency code of freq (Hz) with the internal system clock */
+#define AD5933_INT_FREQ_CODE(freq)  AD5933_FREQ_CODE(freq, AD5933_INTERNAL_SYS_CLK)
+
+
+/******************************************************************************/
+/************************** AD5933 Types **************************************/
+/******************************************************************************/
+
+/* One sweep point, published as soon as it is read. */
+typedef struct {
+    unsigned short index;           // Point of the sweep, 0 = start frequency
+    unsigned char  status;          // Status register (AD5933_STAT_SWEEP_DONE)
+    signed short   realData;        // Real data
+    signed short   imagData;        // Imaginary data
+} AD5933_Point;
+
+/* Receives each sweep point in the acquisition thread. */
+typedef void (*AD5933_PointCallback)(void *context, const AD5933_Point *point);
+
+/* One bus operation, queued in a batch. Reads land in readData. */
+typedef struct {
+    unsigned char  type;                        // AD5933_BUS_*
+    unsigned char  command;                     // Register or block command
+    unsigned char  size;                        // Bytes written or read
+    unsigned char  data[AD5933_BUS_MAX_DATA];   // Bytes written
+    unsigned char *readData;                    // Bytes read, NULL for writes
+} AD5933_BusOp;
 
+/* I2C backend of a device. The byte and block functions have the i2c.h
+   signatures; submit runs a batch at once, or is NULL and the batch runs
+   one call per operation. */
+typedef struct {
+    bool (*writeReg8)(int i2cdevice, unsigned char command, unsigned char data);
+    int  (*readReg8)(int i2cdevice, unsigned char command);
+    bool (*writeBlock)(int i2cdevice, unsigned char command,
+                       const unsigned char *values, unsigned char size);
+    int  (*readBlock)(int i2cdevice, unsigned char command,
+                      unsigned char *values, unsigned char size);
+    bool (*submit)(int i2cdevice, const AD5933_BusOp *ops, unsigned char count);
+} AD5933_Transport;
+
+/* AD5933 device context. Each device has its own; no state is shared. */
+typedef struct {
+    int            i2cdevice;       // I2C handle of the device
+    const AD5933_Transport *transport;  // I2C backend, wiringPi by default
+    AD5933_BusOp  *batchOps;        // Open batch, NULL = immediate writes
+    unsigned char  batchCapacity;   // Entries in batchOps
+    unsigned char  batchCount;      // Operations queued
+    unsigned long  sysClk;          // System clock frequency
+    unsigned char  clockSource;     // AD5933_CONTROL_INT_SYSCLK/EXT_SYSCLK
+    unsigned char  gain;            // Last PGA gain set
+    unsigned char  range;           // Last output range set
+    unsigned char  addrPointer;     // Last address pointer set
+    unsigned char  shadowRegs[AD5933_SHADOW_SIZE];  // Last values written
+    unsigned short shadowValid;     // One bit per shadowRegs entry
+    unsigned char  pendingStatus;   // Status bit awaited, 0 if idle
+    unsigned char  lastStatus;      // Status of the last poll
+    signed short   lastReal;        // Real data of the last poll
+    signed short   lastImag;        // Imaginary data of the last poll
+    unsigned long  pollCount;       // Polls of the pending operation
+    unsigned long  pollLimit;       // Polls before a timeout, 0 = no limit
+    AD5933_Ring   *log;             // Log records, NULL = not logged
+#if AD5933_STATS
+    AD5933_Stats  *stats;           // Statistics, NULL = not kept
+    unsigned long long pendingSinceNs;  // Start of the pending operation
+#endif
+    AD5933_PointCallback pointCallback; // Per-point callback, NULL = none
+    void          *pointContext;    // Argument of pointCallback
+    AD5933_Ring   *pointRing;       // Per-point ring, NULL = none
+} AD5933_Device;
+
+/* Result of a non-blocking poll */
+typedef enum {
+    AD5933_POLL_PENDING,            // Operation still in progress
+    AD5933_POLL_READY,              // Result ready to be collected
+    AD5933_POLL_TIMEOUT,            // Poll limit reached
+    AD5933_POLL_ERROR               // Bus error or nothing pending
+} AD5933_PollResult;
+
+/* Precompiled sweep configuration, loaded with a single block write. */
+typedef struct {
+    unsigned char image[AD5933_PROFILE_SIZE];   // Register image of 0x82-0x8B
+    unsigned long sysClk;                       // Clock used for the codes
+} AD5933_SweepProfile;
+
+/* Caller-owned sweep results, stored as separate real and imaginary arrays.
+   The arrays may be NULL when the points are only streamed. */
+typedef struct {
+    signed short   *realData;   // Real part of each point
+    signed short   *imagData;   // Imaginary part of each point
+    unsigned short  capacity;   // Number of entries in each array
+    unsigned short  count;      // Number of points stored
+} AD5933_SweepBuffer;
+
+/* Mean and spread of the repeated DFT results of one sweep point. */
+typedef struct {
+    float          meanReal;    // Mean of the real data
+    float          meanImag;    // Mean of the imaginary data
+    float          stdErrReal;  // Standard error of meanReal
+    float          stdErrImag;  // Standard error of meanImag
+    unsigned short samples;     // DFT results averaged
+} AD5933_PointAverage;
+
+/******************************************************************************/
+/************************ Variables Declarations ******************************/
+/******************************************************************************/
+
+/*! Backend on the wiringPi calls of i2c.h (the CMock mock in the tests). */
+extern const AD5933_Transport AD5933_WIRINGPI_TRANSPORT;
 
 /******************************************************************************/
 /************************ Functions Declarations ******************************/
 /******************************************************************************/
 
-bool AD5933_SetToStandBy(void);
+bool AD5933_SetToStandBy(AD5933_Device *dev);
+
+/*! Initializes the device context. */
+bool AD5933_Init(AD5933_Device *dev, int i2cdevice);
+
+#if AD5933_STATS
+/*! Attaches statistics to the device. */
+void AD5933_SetStats(AD5933_Device *dev, AD5933_Stats *stats);
+#endif
+
+/*! Selects the I2C backend of the device. */
+void AD5933_SetTransport(AD5933_Device *dev, const AD5933_Transport *transport);
+
+/*! Starts queueing the bus operations of the device into a batch. */
+void AD5933_BeginBatch(AD5933_Device *dev,
+                       AD5933_BusOp *ops,
+                       unsigned char capacity);
+
+/*! Queues a block read whose data is valid once the batch is submitted. */
+bool AD5933_QueueRegisterBlock(AD5933_Device *dev,
+                               unsigned char registerAddress,
+                               unsigned char *data,
+                               unsigned char bytesNumber);
+
+/*! Submits the queued operations and closes the batch. */
+bool AD5933_SubmitBatch(AD5933_Device *dev);
 
-/*! Initializes the communication peripheral. */
-bool AD5933_Init(int status);
+/*! Attaches a log ring to the device. */
+void AD5933_SetLog(AD5933_Device *dev, AD5933_Ring *ring);
+
+/*! Registers a callback that receives each sweep point as it is read. */
+void AD5933_SetPointCallback(AD5933_Device *dev,
+                             AD5933_PointCallback callback,
+                             void *context);
+
+/*! Initializes a ring of sweep points over caller-owned storage. */
+bool AD5933_InitPointRing(AD5933_Ring *ring,
+                          AD5933_Point *points,
+                          unsigned long capacity);
+
+/*! Attaches a ring that receives each sweep point as it is read. */
+void AD5933_SetPointRing(AD5933_Device *dev, AD5933_Ring *ring);
 
 /*! Writes data into a register. */
-bool AD5933_SetRegisterValue(unsigned char registerAddress,
+bool AD5933_SetRegisterValue(AD5933_Device *dev,
+                             unsigned char registerAddress,
                              unsigned long registerValue,
                              unsigned char bytesNumber);
 
+/*! Reads the value of a register, reporting bus errors. */
+bool AD5933_ReadRegisterValue(AD5933_Device *dev,
+                              unsigned char registerAddress,
+                              unsigned char bytesNumber,
+                              unsigned long *registerValue);
+
 /*! Reads the value of a register. */
-unsigned long AD5933_GetRegisterValue(unsigned char registerAddress,
+unsigned long AD5933_GetRegisterValue(AD5933_Device *dev,
+                                      unsigned char registerAddress,
                                       unsigned char bytesNumber);
 
+/*! Sets the address pointer used by the block commands. */
+bool AD5933_SetAddressPointer(AD5933_Device *dev,
+                              unsigned char registerAddress);
+
+/*! Reads consecutive registers with a single block read. */
+bool AD5933_GetRegisterBlock(AD5933_Device *dev,
+                             unsigned char registerAddress,
+                             unsigned char *data,
+                             unsigned char bytesNumber);
+
+/*! Writes consecutive registers with a single block write. */
+bool AD5933_SetRegisterBlock(AD5933_Device *dev,
+                             unsigned char registerAddress,
+                             const unsigned char *data,
+                             unsigned char bytesNumber);
+
+/*! Reads the real and imaginary data (and the status) in one block read. */
+bool AD5933_GetData(AD5933_Device *dev,
+                    signed short *realData,
+                    signed short *imagData,
+                    unsigned char *status);
+
 /*! Resets the device. */
-void AD5933_Reset(void);
+bool AD5933_Reset(AD5933_Device *dev);
+
+/*! Writes again every register recorded in the shadow copy. */
+bool AD5933_RestoreRegisters(AD5933_Device *dev);
 
 /*! Selects the source of the system clock. */
-void AD5933_SetSystemClk(char clkSource, unsigned long extClkFreq);
+void AD5933_SetSystemClk(AD5933_Device *dev,
+                         char clkSource,
+                         unsigned long extClkFreq);
 
 /*! Selects the range and gain of the device. */
-void AD5933_SetRangeAndGain(char range, char gain);
+void AD5933_SetRangeAndGain(AD5933_Device *dev,
+                            char range,
+                            char gain);
+
+/*! Sets the settling cycles and their multiplier. */
+bool AD5933_SetSettlingCycles(AD5933_Device *dev,
+                              unsigned short cycles,
+                              unsigned char multiplier);
+
+/*! Encodes a number of settling cycles into the settling register. */
+unsigned short AD5933_EncodeSettlingCycles(unsigned long cycles);
 
 /*! Reads the temp. from the part and returns the data in degrees Celsius. */
-float AD5933_GetTemperature(unsigned char status);
+float AD5933_GetTemperature(AD5933_Device *dev,
+                            unsigned char status);
+
+/*! Converts a frequency in Hz into a 24-bit frequency code. */
+unsigned long AD5933_FrequencyToCode(unsigned long frequency,
+                                     unsigned long sysClk);
+
+/*! Returns the frequency in mHz produced by a frequency code. */
+unsigned long AD5933_CodeToFrequency(unsigned long code,
+                                     unsigned long sysClk);
+
+/*! Returns the actual frequency in mHz of a point of a sweep profile. */
+unsigned long AD5933_GetPointFrequency(const AD5933_SweepProfile *profile,
+                                       unsigned short point);
+
+/*! Encodes frequency, increment and settling codes into a profile. */
+void AD5933_CompileCodeProfile(AD5933_SweepProfile *profile,
+                               unsigned long  startCode,
+                               unsigned long  incCode,
+                               unsigned short incNum,
+                               unsigned short settlingReg,
+                               unsigned long  sysClk);
+
+/*! Decodes the frequency, increment and settling codes of a profile. */
+void AD5933_DecodeSweepProfile(const AD5933_SweepProfile *profile,
+                               unsigned long  *startCode,
+                               unsigned long  *incCode,
+                               unsigned short *incNum,
+                               unsigned short *settlingReg);
 
 /*! Configures the sweep parameters. */
-void AD5933_ConfigSweep(unsigned long  startFreq,
+void AD5933_ConfigSweep(AD5933_Device *dev,
+                        unsigned long  startFreq,
                         unsigned long  incFreq,
                         unsigned short incNum);
 
+/*! Encodes the sweep and settling registers into a profile. */
+void AD5933_CompileSweepProfile(AD5933_Device *dev,
+                                AD5933_SweepProfile *profile,
+                                unsigned long  startFreq,
+                                unsigned long  incFreq,
+                                unsigned short incNum,
+                                unsigned short settlingCycles,
+                                unsigned char  settlingMultiplier);
+
+/*! Loads a precompiled sweep profile into the device. */
+bool AD5933_LoadSweepProfile(AD5933_Device *dev,
+                             const AD5933_SweepProfile *profile);
+
 /*! Starts the sweep operation. */
-void AD5933_StartSweep(void);
+void AD5933_StartSweep(AD5933_Device *dev);
+
+/*! Sets how many polls an operation may stay pending. */
+void AD5933_SetPollLimit(AD5933_Device *dev, unsigned long pollLimit);
+
+/*! Starts a temperature measurement without waiting for it. */
+bool AD5933_BeginTemperature(AD5933_Device *dev);
+
+/*! Starts a sweep without waiting for the first point. */
+bool AD5933_BeginSweep(AD5933_Device *dev);
+
+/*! Measures the next point of a sweep without waiting for it. */
+bool AD5933_BeginPoint(AD5933_Device *dev, char freqFunction);
+
+/*! Checks once if the pending operation has finished. */
+AD5933_PollResult AD5933_Poll(AD5933_Device *dev);
+
+/*! Reads the result of a finished temperature measurement. */
+float AD5933_CollectTemperature(AD5933_Device *dev);
+
+/*! Returns the point read by the poll that found it ready. */
+void AD5933_CollectData(AD5933_Device *dev,
+                        signed short *realData,
+                        signed short *imagData,
+                        unsigned char *status);
+
+/*! Runs a complete sweep and stores every point in the buffer. */
+bool AD5933_RunSweep(AD5933_Device *dev,
+                     AD5933_SweepBuffer *buffer);
+
+/*! Runs a sweep averaging repeated DFT results at each point. */
+bool AD5933_RunAveragedSweep(AD5933_Device *dev,
+                             AD5933_SweepBuffer *buffer,
+                             AD5933_PointAverage *averages,
+                             unsigned short maxSamples,
+                             float targetStdErr);
 
-double AD5933_CalculateGainFactor(unsigned long calibrationImpedance,char freqFunction);
-double AD5933_CalculateImpedance(double gainFactor,char freqFunction);
+double AD5933_CalculateGainFactor(AD5933_Device *dev,
+                                  unsigned long calibrationImpedance,
+                                  char freqFunction);
+double AD5933_CalculateImpedance(AD5933_Device *dev,
+                                 double gainFactor,
+                                 char freqFunction);
 
 
 #endif /* __AD5933_H__ */
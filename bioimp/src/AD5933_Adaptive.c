@@ -0,0 +1,212 @@
+/***************************************************************************//**
+ *   @file   AD5933_Adaptive.c
+ *   @brief  Adaptive sweep: a coarse pass, then refinement sub-sweeps only
+ *           where the impedance changes fast.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Adaptive.h"
+#include "math.h"
+#include "string.h"
+
+/******************************************************************************/
+/************************** Constants Definitions *****************************/
+/******************************************************************************/
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Builds a sweep profile straight from frequency codes, so the points
+ *        of a sub-sweep land exactly on the codes of the segment.
+ *
+ * @param dev       - Device context.
+ * @param plan      - Adaptive sweep parameters (settling).
+ * @param startCode - Start frequency code.
+ * @param incCode   - Frequency increment code.
+ * @param incNum    - Number of increments.
+ * @param profile   - Profile to fill.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_CodeProfile(const AD5933_Device *dev,
+                               const AD5933_AdaptivePlan *plan,
+                               unsigned long startCode,
+                               unsigned long incCode,
+                               unsigned short incNum,
+                               AD5933_SweepProfile *profile)
+{
+    unsigned short settlingReg = (plan->settlingCycles > AD5933_MAX_SETTLING_CYCLES) ?
+                                 AD5933_MAX_SETTLING_CYCLES : plan->settlingCycles;
+
+    settlingReg |= AD5933_SETTLING_MULTIPLIER(plan->settlingMultiplier & 0x3);
+    AD5933_CompileCodeProfile(profile, startCode, incCode, incNum, settlingReg,
+                              dev->sysClk);
+}
+
+/***************************************************************************//**
+ * @brief Checks if the raw data change too much between two neighbouring
+ *        points. The gain factor and the system phase vary slowly, so the
+ *        change of the raw data follows the change of the impedance.
+ *
+ * @param plan  - Adaptive sweep parameters (thresholds, 0 = not checked).
+ * @param real0 - Real data of the lower point.
+ * @param imag0 - Imaginary data of the lower point.
+ * @param real1 - Real data of the upper point.
+ * @param imag1 - Imaginary data of the upper point.
+ *
+ * @return true if the segment between the points must be refined.
+*******************************************************************************/
+static bool AD5933_SegmentFlagged(const AD5933_AdaptivePlan *plan,
+                                  signed short real0,
+                                  signed short imag0,
+                                  signed short real1,
+                                  signed short imag1)
+{
+    double magnitude0 = sqrt((double)real0 * real0 + (double)imag0 * imag0);
+    double magnitude1 = sqrt((double)real1 * real1 + (double)imag1 * imag1);
+    double largest    = (magnitude0 > magnitude1) ? magnitude0 : magnitude1;
+    double phase      = 0;
+
+    if(largest == 0)
+    {
+        return false;
+    }
+    if((plan->magnitudeStep > 0) &&
+       (fabs(magnitude1 - magnitude0) > plan->magnitudeStep * largest))
+    {
+        return true;
+    }
+    phase = atan2(imag1, real1) - atan2(imag0, real0);
+    if(phase > M_PI)
+    {
+        phase -= 2 * M_PI;
+    }
+    else if(phase <= -M_PI)
+    {
+        phase += 2 * M_PI;
+    }
+
+    return (plan->phaseStep > 0) && (fabs(phase) > plan->phaseStep);
+}
+
+/***************************************************************************//**
+ * @brief Runs a coarse linear sweep from startFreq to stopFreq, then, for up
+ *        to maxDepth passes, measures refinePoints more points inside every
+ *        segment whose magnitude or phase changes faster than the thresholds.
+ *        Each refinement is one short sweep over the codes of the segment,
+ *        so flat parts of the spectrum cost only their coarse points. The
+ *        result stays sorted by frequency. Points are published by each
+ *        sub-sweep with their index inside that sub-sweep.
+ *        Refinement stops early when the buffer is full or a segment is
+ *        too narrow to split.
+ *
+ * @param dev    - Device context.
+ * @param plan   - Adaptive sweep parameters.
+ * @param buffer - Caller-owned buffer for the raw data of all the points.
+ * @param codes  - Frequency code of each point, with room for
+ *                 buffer->capacity entries (AD5933_CodeToFrequency gives Hz).
+ *
+ * @return false if the plan is invalid or a sub-sweep failed;
+ *         buffer->count holds the points stored in any case.
+*******************************************************************************/
+bool AD5933_RunAdaptiveSweep(AD5933_Device *dev,
+                             const AD5933_AdaptivePlan *plan,
+                             AD5933_SweepBuffer *buffer,
+                             unsigned long *codes)
+{
+    signed short        realData[AD5933_ADAPTIVE_MAX_REFINE];
+    signed short        imagData[AD5933_ADAPTIVE_MAX_REFINE];
+    AD5933_SweepBuffer  segment   = {realData, imagData, 0, 0};
+    AD5933_SweepProfile profile;
+    unsigned long       startCode = AD5933_FrequencyToCode(plan->startFreq,
+                                                           dev->sysClk);
+    unsigned long       stopCode  = AD5933_FrequencyToCode(plan->stopFreq,
+                                                           dev->sysClk);
+    unsigned long       incCode   = 0;
+    unsigned short      refine    = plan->refinePoints;
+    unsigned short      point     = 0;
+    unsigned short      moved     = 0;
+    unsigned char       depth     = 0;
+    bool                added     = true;
+
+    buffer->count = 0;
+    if((plan->coarsePoints < 2) || (plan->coarsePoints > AD5933_MAX_POINTS) ||
+       (plan->coarsePoints > buffer->capacity) || (stopCode <= startCode) ||
+       (buffer->realData == 0) || (buffer->imagData == 0))
+    {
+        return false;
+    }
+    incCode = (stopCode - startCode) / (plan->coarsePoints - 1);
+    if(incCode == 0)
+    {
+        return false;
+    }
+    AD5933_CodeProfile(dev, plan, startCode, incCode, plan->coarsePoints - 1,
+                       &profile);
+    if(!AD5933_LoadSweepProfile(dev, &profile) || !AD5933_RunSweep(dev, buffer))
+    {
+        return false;
+    }
+    for(point = 0; point < buffer->count; point++)
+    {
+        codes[point] = startCode + point * incCode;
+    }
+    refine           = (refine > AD5933_ADAPTIVE_MAX_REFINE) ?
+                       AD5933_ADAPTIVE_MAX_REFINE : refine;
+    segment.capacity = refine;
+    for(depth = 0; (depth < plan->maxDepth) && (refine > 0) && added; depth++)
+    {
+        added = false;
+        // Right to left, so the points inserted are not looked at again
+        for(point = buffer->count - 1; point-- > 0;)
+        {
+            if(buffer->count + refine > buffer->capacity)
+            {
+                return true;
+            }
+            incCode = (codes[point + 1] - codes[point]) / (refine + 1);
+            if((incCode == 0) ||
+               !AD5933_SegmentFlagged(plan,
+                                      buffer->realData[point],
+                                      buffer->imagData[point],
+                                      buffer->realData[point + 1],
+                                      buffer->imagData[point + 1]))
+            {
+                continue;
+            }
+            AD5933_CodeProfile(dev, plan, codes[point] + incCode, incCode,
+                               refine - 1, &profile);
+            if(!AD5933_LoadSweepProfile(dev, &profile) ||
+               !AD5933_RunSweep(dev, &segment) || (segment.count != refine))
+            {
+                return false;
+            }
+            moved = buffer->count - (point + 1);
+            memmove(&buffer->realData[point + 1 + refine],
+                    &buffer->realData[point + 1], moved * sizeof(signed short));
+            memmove(&buffer->imagData[point + 1 + refine],
+                    &buffer->imagData[point + 1], moved * sizeof(signed short));
+            memmove(&codes[point + 1 + refine], &codes[point + 1],
+                    moved * sizeof(unsigned long));
+            memcpy(&buffer->realData[point + 1], realData,
+                   refine * sizeof(signed short));
+            memcpy(&buffer->imagData[point + 1], imagData,
+                   refine * sizeof(signed short));
+            for(moved = 0; moved < refine; moved++)
+            {
+                codes[point + 1 + moved] = codes[point] + (moved + 1) * incCode;
+            }
+            buffer->count += refine;
+            added          = true;
+        }
+    }
+
+    return true;
+}
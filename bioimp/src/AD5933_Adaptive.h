@@ -0,0 +1,48 @@
+/***************************************************************************//**
+ *   @file   AD5933_Adaptive.h
+ *   @brief  Adaptive sweep: a coarse pass, then refinement sub-sweeps only
+ *           where the impedance changes fast.
+*******************************************************************************/
+
+#ifndef __AD5933_ADAPTIVE_H__
+#define __AD5933_ADAPTIVE_H__
+
+#include "stdbool.h"
+#include "AD5933.h"
+
+/******************************************************************************/
+/************************** Adaptive Definitions ******************************/
+/******************************************************************************/
+
+#define AD5933_ADAPTIVE_MAX_REFINE  16      // Points added inside a segment
+
+/******************************************************************************/
+/**************************** Adaptive Types **********************************/
+/******************************************************************************/
+
+/* Parameters of an adaptive sweep */
+typedef struct {
+    unsigned long  startFreq;           // First frequency (Hz)
+    unsigned long  stopFreq;            // Last frequency (Hz)
+    unsigned short coarsePoints;        // Points of the first pass, >= 2
+    unsigned short refinePoints;        // Points added inside a flagged segment
+    unsigned char  maxDepth;            // Refinement passes after the first
+    float          magnitudeStep;       // Relative magnitude change that
+                                        // flags a segment (e.g. 0.05)
+    float          phaseStep;           // Phase change (radians) that flags
+                                        // a segment
+    unsigned short settlingCycles;      // Settling cycles of every sub-sweep
+    unsigned char  settlingMultiplier;  // AD5933_SETTLING_Xn
+} AD5933_AdaptivePlan;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Runs a coarse sweep and refines it where magnitude or phase change fast. */
+bool AD5933_RunAdaptiveSweep(AD5933_Device *dev,
+                             const AD5933_AdaptivePlan *plan,
+                             AD5933_SweepBuffer *buffer,
+                             unsigned long *codes);
+
+#endif /* __AD5933_ADAPTIVE_H__ */
@@ -0,0 +1,502 @@
+/***************************************************************************//**
+ *   @file   AD5933_AutoRange.c
+ *   @brief  Automatic selection of output range and PGA gain per frequency
+ *           band, cached for the next sweep of the same profile.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_AutoRange.h"
+#include "string.h"
+
+/******************************************************************************/
+/************************** Constants Definitions *****************************/
+/******************************************************************************/
+
+/* Range and gain of each level, from the weakest to the strongest signal.
+   200 mVpp x5 is left out: it gives the same signal as 1 Vpp x1. */
+static const unsigned char AUTORANGE_RANGE[AD5933_AUTORANGE_LEVELS] = {
+    AD5933_RANGE_200mVpp, AD5933_RANGE_400mVpp, AD5933_RANGE_1000mVpp,
+    AD5933_RANGE_2000mVpp, AD5933_RANGE_1000mVpp, AD5933_RANGE_2000mVpp
+};
+static const unsigned char AUTORANGE_GAIN[AD5933_AUTORANGE_LEVELS] = {
+    AD5933_GAIN_X1, AD5933_GAIN_X1, AD5933_GAIN_X1,
+    AD5933_GAIN_X1, AD5933_GAIN_X5, AD5933_GAIN_X5
+};
+/* Relative signal of each level (excitation times PGA gain, 0.1 V units) */
+static const unsigned char AUTORANGE_SCALE[AD5933_AUTORANGE_LEVELS] = {
+    2, 4, 10, 20, 50, 100
+};
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Clears a range cache, so the next sweep starts every band at
+ *        AD5933_AUTORANGE_START_LEVEL.
+ *
+ * @param cache      - Range cache.
+ * @param bandPoints - Points of each band. It is raised when a profile would
+ *                     need more than AD5933_AUTORANGE_MAX_BANDS bands; 0 uses
+ *                     the smallest bands possible.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_InitRangeCache(AD5933_RangeCache *cache, unsigned short bandPoints)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->bandPoints = bandPoints;
+}
+
+/***************************************************************************//**
+ * @brief Returns the number of points of a sweep profile.
+ *
+ * @param profile - Sweep profile.
+ *
+ * @return Number of increments + 1.
+*******************************************************************************/
+static unsigned short AD5933_ProfilePoints(const AD5933_SweepProfile *profile)
+{
+    unsigned long  startCode   = 0;
+    unsigned long  incCode     = 0;
+    unsigned short incNum      = 0;
+    unsigned short settlingReg = 0;
+
+    AD5933_DecodeSweepProfile(profile, &startCode, &incCode, &incNum,
+                              &settlingReg);
+
+    return incNum + 1;
+}
+
+/***************************************************************************//**
+ * @brief Makes the cache belong to a profile. The levels of another profile
+ *        are discarded.
+ *
+ * @param cache   - Range cache.
+ * @param profile - Sweep profile.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_BindRangeCache(AD5933_RangeCache *cache,
+                                  const AD5933_SweepProfile *profile)
+{
+    unsigned short points  = AD5933_ProfilePoints(profile);
+    unsigned short minimum = (points + AD5933_AUTORANGE_MAX_BANDS - 1) /
+                             AD5933_AUTORANGE_MAX_BANDS;
+
+    if(cache->valid && (cache->sysClk == profile->sysClk) &&
+       (memcmp(cache->image, profile->image, AD5933_PROFILE_SIZE) == 0))
+    {
+        return;
+    }
+    memcpy(cache->image, profile->image, AD5933_PROFILE_SIZE);
+    cache->sysClk = profile->sysClk;
+    if(cache->bandPoints < minimum)
+    {
+        cache->bandPoints = minimum;
+    }
+    cache->bands = (points + cache->bandPoints - 1) / cache->bandPoints;
+    memset(cache->level, AD5933_AUTORANGE_START_LEVEL, sizeof(cache->level));
+    cache->valid = true;
+}
+
+/***************************************************************************//**
+ * @brief Applies the range and gain of a band to the device context. They
+ *        reach the part with the next control command.
+ *
+ * @param dev   - Device context.
+ * @param cache - Range cache.
+ * @param point - Point about to be measured.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_SelectPointLevel(AD5933_Device *dev,
+                                    const AD5933_RangeCache *cache,
+                                    unsigned short point)
+{
+    unsigned char level = cache->level[point / cache->bandPoints];
+
+    dev->range = AUTORANGE_RANGE[level];
+    dev->gain  = AUTORANGE_GAIN[level];
+}
+
+/***************************************************************************//**
+ * @brief Measures consecutive points of the profile as one sweep, switching
+ *        range and gain with the INC_FREQ command that enters a new band.
+ *        A span that does not start at point 0 is swept from its own start
+ *        code with the increment code of the profile.
+ *
+ * @param dev     - Device context.
+ * @param profile - Sweep profile.
+ * @param cache   - Range cache bound to the profile.
+ * @param first   - First point of the span.
+ * @param count   - Points of the span.
+ * @param buffer  - Buffer that receives the points at their index.
+ *
+ * @return false on a bus error or a timeout.
+*******************************************************************************/
+static bool AD5933_MeasureSpan(AD5933_Device *dev,
+                               const AD5933_SweepProfile *profile,
+                               const AD5933_RangeCache *cache,
+                               unsigned short first,
+                               unsigned short count,
+                               AD5933_SweepBuffer *buffer)
+{
+    AD5933_SweepProfile span        = *profile;
+    unsigned long       startCode   = 0;
+    unsigned long       incCode     = 0;
+    unsigned short      incNum      = 0;
+    unsigned short      settlingReg = 0;
+    unsigned short      point       = 0;
+    unsigned char       status      = 0;
+    AD5933_PollResult   result      = AD5933_POLL_PENDING;
+
+    if((first != 0) || (count != AD5933_ProfilePoints(profile)))
+    {
+        AD5933_DecodeSweepProfile(profile, &startCode, &incCode, &incNum,
+                                  &settlingReg);
+        startCode = (startCode + (unsigned long)first * incCode) &
+                    AD5933_FREQ_CODE_MAX;
+        AD5933_CompileCodeProfile(&span, startCode, incCode, count - 1,
+                                  settlingReg, profile->sysClk);
+    }
+    if(!AD5933_SetRegisterBlock(dev, AD5933_REG_FREQ_START, span.image,
+                                AD5933_PROFILE_SIZE))
+    {
+        return false;
+    }
+    AD5933_SelectPointLevel(dev, cache, first);
+    if(!AD5933_BeginSweep(dev))
+    {
+        return false;
+    }
+    for(point = first; point < first + count; point++)
+    {
+        result = AD5933_POLL_PENDING;
+        while(result == AD5933_POLL_PENDING)
+        {
+            result = AD5933_Poll(dev);
+        }
+        if(result != AD5933_POLL_READY)
+        {
+            return false;
+        }
+        AD5933_CollectData(dev, &buffer->realData[point],
+                           &buffer->imagData[point], &status);
+        if(point + 1 < first + count)
+        {
+            AD5933_SelectPointLevel(dev, cache, point + 1);
+            if(!AD5933_BeginPoint(dev, AD5933_FUNCTION_INC_FREQ))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Finds the largest component and the largest squared magnitude of
+ *        the raw data of a band.
+ *
+ * @param realData  - Real data of the band.
+ * @param imagData  - Imaginary data of the band.
+ * @param count     - Points of the band.
+ * @param magnitude - Largest real^2 + imag^2.
+ *
+ * @return Largest absolute value of a real or imaginary part.
+*******************************************************************************/
+static unsigned long AD5933_BandPeak(const signed short *realData,
+                                     const signed short *imagData,
+                                     unsigned short count,
+                                     unsigned long long *magnitude)
+{
+    unsigned long      peak  = 0;
+    unsigned long long power = 0;
+    unsigned short     point = 0;
+    unsigned long      real  = 0;
+    unsigned long      imag  = 0;
+
+    *magnitude = 0;
+    for(point = 0; point < count; point++)
+    {
+        real  = (realData[point] < 0) ? -(long)realData[point] : realData[point];
+        imag  = (imagData[point] < 0) ? -(long)imagData[point] : imagData[point];
+        peak  = (real > peak) ? real : peak;
+        peak  = (imag > peak) ? imag : peak;
+        power = (unsigned long long)real * real + (unsigned long long)imag * imag;
+        *magnitude = (power > *magnitude) ? power : *magnitude;
+    }
+
+    return peak;
+}
+
+/***************************************************************************//**
+ * @brief Chooses the level of a band from its peaks. A saturated band steps
+ *        one level down (its true size is unknown); a band below the noise
+ *        floor jumps to the strongest level that keeps the predicted peak
+ *        under the target. Anything in between keeps its level, so the
+ *        choice does not flip between sweeps.
+ *
+ * @param level     - Level the band was measured with.
+ * @param peak      - Largest component of the band.
+ * @param magnitude - Largest squared magnitude of the band.
+ *
+ * @return Level for the band.
+*******************************************************************************/
+static unsigned char AD5933_ChooseLevel(unsigned char level,
+                                        unsigned long peak,
+                                        unsigned long long magnitude)
+{
+    unsigned long long limit = 0;
+    unsigned char      next  = level;
+
+    if(peak >= AD5933_AUTORANGE_CLIP)
+    {
+        return (level > 0) ? level - 1 : level;
+    }
+    if(magnitude >= (unsigned long long)AD5933_AUTORANGE_FLOOR *
+                    AD5933_AUTORANGE_FLOOR)
+    {
+        return level;
+    }
+    // Predicted peak at level L: magnitude * scale[L] / scale[level]
+    limit = (unsigned long long)AD5933_AUTORANGE_TARGET * AD5933_AUTORANGE_TARGET *
+            AUTORANGE_SCALE[level] * AUTORANGE_SCALE[level];
+    while((next + 1 < AD5933_AUTORANGE_LEVELS) &&
+          (magnitude * AUTORANGE_SCALE[next + 1] * AUTORANGE_SCALE[next + 1] <=
+           limit))
+    {
+        next++;
+    }
+
+    return next;
+}
+
+/***************************************************************************//**
+ * @brief Runs a sweep choosing range and gain band by band. The first pass
+ *        uses the levels cached for this profile; each band that saturates
+ *        or sits near the noise floor gets a new level and only those bands
+ *        are measured again (neighbouring ones as one sub-sweep), for up to
+ *        AD5933_AUTORANGE_MAX_RETRIES rounds. The levels stay in the cache,
+ *        so the next sweep of the same profile usually needs no retries.
+ *        Points are not published to the point callback or ring, since a
+ *        band may be measured more than once. Raw data of different bands
+ *        have different scales: AD5933_ApplyRangedCalibration converts the
+ *        sweep into impedance with the levels left in the cache.
+ *
+ * @param dev     - Device context. Its range and gain are kept.
+ * @param profile - Sweep profile, compiled for the current system clock.
+ * @param cache   - Range cache of the profile.
+ * @param buffer  - Caller-owned result buffer (arrays are required).
+ *
+ * @return false on a bus error or a timeout, or if a band still saturates;
+ *         buffer->count holds the points measured.
+*******************************************************************************/
+bool AD5933_RunAutoRangedSweep(AD5933_Device *dev,
+                               const AD5933_SweepProfile *profile,
+                               AD5933_RangeCache *cache,
+                               AD5933_SweepBuffer *buffer)
+{
+    unsigned char      range     = dev->range;
+    unsigned char      gain      = dev->gain;
+    unsigned short     points    = AD5933_ProfilePoints(profile);
+    unsigned char      level[AD5933_AUTORANGE_MAX_BANDS];
+    unsigned long      peak[AD5933_AUTORANGE_MAX_BANDS];
+    unsigned long long magnitude = 0;
+    bool               pending   = true;
+    bool               result    = true;
+    unsigned char      round     = 0;
+    unsigned char      band      = 0;
+    unsigned char      last      = 0;
+    unsigned char      bands     = 0;
+    unsigned short     first     = 0;
+    unsigned short     count     = 0;
+
+    buffer->count = 0;
+    if((profile->sysClk != dev->sysClk) || (buffer->realData == 0) ||
+       (buffer->imagData == 0))
+    {
+        return false;
+    }
+    AD5933_BindRangeCache(cache, profile);
+    cache->changed = 0;
+    points = (points < buffer->capacity) ? points : buffer->capacity;
+    bands  = (points + cache->bandPoints - 1) / cache->bandPoints;
+    result = AD5933_MeasureSpan(dev, profile, cache, 0, points, buffer);
+    for(round = 0; result && pending; round++)
+    {
+        pending = false;
+        for(band = 0; band < bands; band++)
+        {
+            first       = band * cache->bandPoints;
+            count       = ((points - first) < cache->bandPoints) ?
+                          (points - first) : cache->bandPoints;
+            peak[band]  = AD5933_BandPeak(&buffer->realData[first],
+                                          &buffer->imagData[first], count,
+                                          &magnitude);
+            level[band] = AD5933_ChooseLevel(cache->level[band], peak[band],
+                                             magnitude);
+            pending    |= (level[band] != cache->level[band]);
+        }
+        if(!pending || (round == AD5933_AUTORANGE_MAX_RETRIES))
+        {
+            break;
+        }
+        // Re-measure each run of changed bands as one sub-sweep
+        for(band = 0; result && (band < bands); band++)
+        {
+            if(level[band] == cache->level[band])
+            {
+                continue;
+            }
+            for(last = band; (last + 1 < bands) &&
+                             (level[last + 1] != cache->level[last + 1]); last++)
+            {
+            }
+            memcpy(&cache->level[band], &level[band], last - band + 1);
+            first  = band * cache->bandPoints;
+            count  = (last + 1) * cache->bandPoints;
+            count  = ((count < points) ? count : points) - first;
+            result = AD5933_MeasureSpan(dev, profile, cache, first, count,
+                                        buffer);
+            cache->changed += last - band + 1;
+            band = last;
+        }
+    }
+    dev->range = range;
+    dev->gain  = gain;
+    if(!result)
+    {
+        return false;
+    }
+    buffer->count = points;
+    for(band = 0; band < bands; band++)
+    {
+        result &= (peak[band] < AD5933_AUTORANGE_CLIP);
+    }
+
+    return result;
+}
+
+/***************************************************************************//**
+ * @brief Returns the level a point of the last sweep of the cached profile
+ *        was measured with.
+ *
+ * @param cache - Range cache.
+ * @param point - Point of the sweep.
+ *
+ * @return Level of the band of the point, the start level if it has none.
+*******************************************************************************/
+static unsigned char AD5933_PointLevel(const AD5933_RangeCache *cache,
+                                       unsigned short point)
+{
+    if(cache->valid && (point / cache->bandPoints < cache->bands))
+    {
+        return cache->level[point / cache->bandPoints];
+    }
+
+    return AD5933_AUTORANGE_START_LEVEL;
+}
+
+/***************************************************************************//**
+ * @brief Returns the range and gain a point of the last sweep of the cached
+ *        profile was measured with.
+ *
+ * @param cache - Range cache.
+ * @param point - Point of the sweep.
+ * @param range - AD5933_RANGE_x of the point.
+ * @param gain  - AD5933_GAIN_x of the point.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_GetPointRange(const AD5933_RangeCache *cache,
+                          unsigned short point,
+                          unsigned char *range,
+                          unsigned char *gain)
+{
+    unsigned char level = AD5933_PointLevel(cache, point);
+
+    *range = AUTORANGE_RANGE[level];
+    *gain  = AUTORANGE_GAIN[level];
+}
+
+/***************************************************************************//**
+ * @brief Fills the level gains with their nominal values: the output range
+ *        amplitude times the PGA gain.
+ *
+ * @param gains - Level gains.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_InitLevelGains(AD5933_LevelGains *gains)
+{
+    unsigned char level = 0;
+
+    for(level = 0; level < AD5933_AUTORANGE_LEVELS; level++)
+    {
+        gains->gain[level] = AUTORANGE_SCALE[level];
+    }
+}
+
+/***************************************************************************//**
+ * @brief Converts a sweep of AD5933_RunAutoRangedSweep into impedance with a
+ *        calibration measured at a single range and gain. Each point is
+ *        converted with the calibration, then rescaled by the gain of the
+ *        level it was measured with over the gain of the calibration level,
+ *        so the whole series is in ohms. The phase does not depend on the
+ *        level.
+ *
+ * @param cal       - Calibration.
+ * @param calRange  - AD5933_RANGE_x the calibration was measured with.
+ * @param calGain   - AD5933_GAIN_x the calibration was measured with.
+ * @param cache     - Range cache of the sweep.
+ * @param gains     - Level gains (AD5933_InitLevelGains for nominal ones).
+ * @param sweep     - Raw data of the auto-ranged sweep.
+ * @param startFreq - Start frequency of the sweep in Hz.
+ * @param incFreq   - Frequency increment of the sweep in Hz.
+ * @param impedance - Impedance magnitude of each point in ohms.
+ * @param phase     - Impedance phase of each point in radians.
+ *
+ * @return false if the calibration range and gain are not one of the levels.
+*******************************************************************************/
+bool AD5933_ApplyRangedCalibration(const AD5933_Calibration *cal,
+                                   unsigned char calRange,
+                                   unsigned char calGain,
+                                   const AD5933_RangeCache *cache,
+                                   const AD5933_LevelGains *gains,
+                                   const AD5933_SweepBuffer *sweep,
+                                   unsigned long startFreq,
+                                   unsigned long incFreq,
+                                   float *impedance,
+                                   float *phase)
+{
+    unsigned char  calLevel = AD5933_AUTORANGE_LEVELS;
+    unsigned char  level    = 0;
+    unsigned short point    = 0;
+
+    for(level = 0; level < AD5933_AUTORANGE_LEVELS; level++)
+    {
+        if((AUTORANGE_RANGE[level] == calRange) &&
+           (AUTORANGE_GAIN[level] == calGain))
+        {
+            calLevel = level;
+        }
+    }
+    if(calLevel == AD5933_AUTORANGE_LEVELS)
+    {
+        return false;
+    }
+    AD5933_ApplyCalibration(cal, sweep, startFreq, incFreq, impedance, phase);
+    for(point = 0; point < sweep->count; point++)
+    {
+        level = AD5933_PointLevel(cache, point);
+        // A stronger level gives more counts, so a smaller raw impedance
+        impedance[point] *= gains->gain[level] / gains->gain[calLevel];
+    }
+
+    return true;
+}
@@ -0,0 +1,83 @@
+/***************************************************************************//**
+ *   @file   AD5933_AutoRange.h
+ *   @brief  Automatic selection of output range and PGA gain per frequency
+ *           band, cached for the next sweep of the same profile.
+*******************************************************************************/
+
+#ifndef __AD5933_AUTORANGE_H__
+#define __AD5933_AUTORANGE_H__
+
+#include "stdbool.h"
+#include "AD5933.h"
+#include "AD5933_Calibration.h"
+
+/******************************************************************************/
+/************************** Auto-Range Definitions ****************************/
+/******************************************************************************/
+
+#define AD5933_AUTORANGE_MAX_BANDS      16      // Bands of a profile
+#define AD5933_AUTORANGE_LEVELS         6       // Range and gain combinations
+#define AD5933_AUTORANGE_START_LEVEL    3       // 2 Vpp x1, the driver default
+#define AD5933_AUTORANGE_CLIP           30000   // Component treated as saturated
+#define AD5933_AUTORANGE_FLOOR          1000    // Magnitude too close to noise
+#define AD5933_AUTORANGE_TARGET         16000   // Magnitude aimed for on a change
+#define AD5933_AUTORANGE_MAX_RETRIES    4       // Re-measure rounds per sweep
+
+/******************************************************************************/
+/**************************** Auto-Range Types ********************************/
+/******************************************************************************/
+
+/* Level chosen for each band of one sweep profile. Levels go from the
+   weakest signal (200 mVpp x1) to the strongest (2 Vpp x5). */
+typedef struct {
+    unsigned char  image[AD5933_PROFILE_SIZE];  // Profile the levels belong to
+    unsigned long  sysClk;                      // Clock of that profile
+    bool           valid;                       // Levels belong to the profile
+    unsigned short bandPoints;                  // Points per band
+    unsigned char  bands;                       // Bands of the profile
+    unsigned char  level[AD5933_AUTORANGE_MAX_BANDS];   // Level of each band
+    unsigned char  changed;                     // Bands re-measured last sweep
+} AD5933_RangeCache;
+
+/* Relative DFT magnitude of each level for the same load. Nominal values
+   follow the output range and the PGA gain; measured ones may replace them
+   to take in the tolerances of the part. */
+typedef struct {
+    float gain[AD5933_AUTORANGE_LEVELS];        // Magnitude per level
+} AD5933_LevelGains;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Clears a range cache and sets the points of each band. */
+void AD5933_InitRangeCache(AD5933_RangeCache *cache, unsigned short bandPoints);
+
+/*! Runs a sweep choosing range and gain band by band. */
+bool AD5933_RunAutoRangedSweep(AD5933_Device *dev,
+                               const AD5933_SweepProfile *profile,
+                               AD5933_RangeCache *cache,
+                               AD5933_SweepBuffer *buffer);
+
+/*! Returns the range and gain a point of the last sweep was measured with. */
+void AD5933_GetPointRange(const AD5933_RangeCache *cache,
+                          unsigned short point,
+                          unsigned char *range,
+                          unsigned char *gain);
+
+/*! Fills the level gains with their nominal values. */
+void AD5933_InitLevelGains(AD5933_LevelGains *gains);
+
+/*! Converts an auto-ranged sweep into impedance with one calibration. */
+bool AD5933_ApplyRangedCalibration(const AD5933_Calibration *cal,
+                                   unsigned char calRange,
+                                   unsigned char calGain,
+                                   const AD5933_RangeCache *cache,
+                                   const AD5933_LevelGains *gains,
+                                   const AD5933_SweepBuffer *sweep,
+                                   unsigned long startFreq,
+                                   unsigned long incFreq,
+                                   float *impedance,
+                                   float *phase);
+
+#endif /* __AD5933_AUTORANGE_H__ */
@@ -0,0 +1,326 @@
+/***************************************************************************//**
+ *   @file   AD5933_Calibration.c
+ *   @brief  Per-frequency gain factor and system phase calibration.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Calibration.h"
+#include "AD5933_Kernel.h"
+#include "math.h"
+
+/******************************************************************************/
+/************************** Constants Definitions *****************************/
+/******************************************************************************/
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+#define CALIBRATION_CHUNK   64      // Points interpolated per kernel call
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Wraps a phase into the (-pi, pi] range.
+ *
+ * @param phase - Phase in radians.
+ *
+ * @return Wrapped phase.
+*******************************************************************************/
+static double AD5933_WrapPhase(double phase)
+{
+    while(phase > M_PI)
+    {
+        phase -= 2 * M_PI;
+    }
+    while(phase <= -M_PI)
+    {
+        phase += 2 * M_PI;
+    }
+    
+    return phase;
+}
+
+/***************************************************************************//**
+ * @brief Builds the calibration from a sweep measured on a known resistor:
+ *        one gain factor and one system phase for every point.
+ *
+ * @param cal                  - Calibration to fill.
+ * @param sweep                - Raw data of the calibration sweep.
+ * @param calibrationImpedance - Value of the calibration resistor in ohms.
+ * @param startFreq            - Start frequency of the sweep in Hz.
+ * @param incFreq              - Frequency increment of the sweep in Hz.
+ *
+ * @return false if a point had no signal (open circuit or saturated input).
+*******************************************************************************/
+bool AD5933_BuildCalibration(AD5933_Calibration *cal,
+                             const AD5933_SweepBuffer *sweep,
+                             unsigned long calibrationImpedance,
+                             unsigned long startFreq,
+                             unsigned long incFreq)
+{
+    unsigned short point     = 0;
+    double         magnitude = 0;
+    
+    cal->startFreq   = startFreq;
+    cal->incFreq     = incFreq;
+    cal->points      = 0;
+    cal->temperature = NAN;
+    cal->gainTempCo  = 0;
+    for(point = 0; (point < sweep->count) && (point < AD5933_MAX_POINTS);
+        point++)
+    {
+        magnitude = sqrt((double)sweep->realData[point] * sweep->realData[point] +
+                         (double)sweep->imagData[point] * sweep->imagData[point]);
+        if(magnitude == 0)
+        {
+            return false;
+        }
+        cal->gainFactor[point]  = (float)(1 / (magnitude * calibrationImpedance));
+        cal->systemPhase[point] = (float)atan2(sweep->imagData[point],
+                                               sweep->realData[point]);
+        cal->points++;
+    }
+    
+    return cal->points > 0;
+}
+
+/***************************************************************************//**
+ * @brief Configures and runs a calibration sweep with a known resistor
+ *        connected, then builds the calibration from it.
+ *
+ * @param dev                  - Device context.
+ * @param cal                  - Calibration to fill.
+ * @param buffer               - Buffer for the raw calibration sweep.
+ * @param calibrationImpedance - Value of the calibration resistor in ohms.
+ * @param startFreq            - Start frequency in Hz.
+ * @param incFreq              - Frequency increment in Hz.
+ * @param incNum               - Number of increments.
+ *
+ * @return true if the sweep completed and every point had signal.
+*******************************************************************************/
+bool AD5933_RunCalibration(AD5933_Device *dev,
+                           AD5933_Calibration *cal,
+                           AD5933_SweepBuffer *buffer,
+                           unsigned long  calibrationImpedance,
+                           unsigned long  startFreq,
+                           unsigned long  incFreq,
+                           unsigned short incNum)
+{
+    AD5933_ConfigSweep(dev, startFreq, incFreq, incNum);
+    if(!AD5933_RunSweep(dev, buffer))
+    {
+        return false;
+    }
+    
+    return AD5933_BuildCalibration(cal, buffer, calibrationImpedance,
+                                   startFreq, incFreq);
+}
+
+/***************************************************************************//**
+ * @brief Interpolates linearly the gain factor and system phase at any
+ *        frequency. Outside the calibrated range the nearest point is used.
+ *
+ * @param cal         - Calibration.
+ * @param frequency   - Frequency in Hz.
+ * @param gainFactor  - Interpolated gain factor.
+ * @param systemPhase - Interpolated system phase in radians.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_InterpolateCalibration(const AD5933_Calibration *cal,
+                                   double frequency,
+                                   float *gainFactor,
+                                   float *systemPhase)
+{
+    double         position = 0;
+    double         fraction = 0;
+    unsigned short point    = 0;
+    
+    if(cal->points == 0)
+    {
+        *gainFactor  = 0;
+        *systemPhase = 0;
+        return;
+    }
+    if(cal->incFreq != 0)
+    {
+        position = (frequency - (double)cal->startFreq) / cal->incFreq;
+    }
+    if(position <= 0)
+    {
+        *gainFactor  = cal->gainFactor[0];
+        *systemPhase = cal->systemPhase[0];
+        return;
+    }
+    if(position >= cal->points - 1)
+    {
+        *gainFactor  = cal->gainFactor[cal->points - 1];
+        *systemPhase = cal->systemPhase[cal->points - 1];
+        return;
+    }
+    point    = (unsigned short)position;
+    fraction = position - point;
+    *gainFactor  = (float)(cal->gainFactor[point] + fraction *
+                   (cal->gainFactor[point + 1] - cal->gainFactor[point]));
+    // Interpolate along the short way around the circle
+    *systemPhase = (float)AD5933_WrapPhase(cal->systemPhase[point] + fraction *
+                   AD5933_WrapPhase((double)cal->systemPhase[point + 1] -
+                                    cal->systemPhase[point]));
+}
+
+/***************************************************************************//**
+ * @brief Converts a whole sweep into impedance magnitude and phase with the
+ *        calibration, interpolating when the sweep grid differs from the
+ *        calibration grid.
+ *
+ * @param cal       - Calibration.
+ * @param sweep     - Raw data of the measured sweep.
+ * @param startFreq - Start frequency of the sweep in Hz.
+ * @param incFreq   - Frequency increment of the sweep in Hz.
+ * @param impedance - Impedance magnitude of each point in ohms.
+ * @param phase     - Impedance phase of each point in radians.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_ApplyCalibration(const AD5933_Calibration *cal,
+                             const AD5933_SweepBuffer *sweep,
+                             unsigned long startFreq,
+                             unsigned long incFreq,
+                             float *impedance,
+                             float *phase)
+{
+    float          gainFactor[CALIBRATION_CHUNK];
+    float          systemPhase[CALIBRATION_CHUNK];
+    unsigned short first = 0;
+    unsigned short size  = 0;
+    unsigned short point = 0;
+    
+    if((startFreq == cal->startFreq) && (incFreq == cal->incFreq) &&
+       (sweep->count <= cal->points))
+    {
+        // Same grid as the calibration: no interpolation needed
+        AD5933_ProcessSweep(sweep->realData, sweep->imagData,
+                            cal->gainFactor, cal->systemPhase, sweep->count,
+                            0, phase, impedance);
+    }
+    else
+    {
+        for(first = 0; first < sweep->count; first += size)
+        {
+            size = sweep->count - first;
+            size = (size > CALIBRATION_CHUNK) ? CALIBRATION_CHUNK : size;
+            for(point = 0; point < size; point++)
+            {
+                AD5933_InterpolateCalibration(cal,
+                                              (double)startFreq +
+                                              (double)(first + point) * incFreq,
+                                              &gainFactor[point],
+                                              &systemPhase[point]);
+            }
+            AD5933_ProcessSweep(&sweep->realData[first], &sweep->imagData[first],
+                                gainFactor, systemPhase, size,
+                                0, &phase[first], &impedance[first]);
+        }
+    }
+    // Points without signal or calibration have no phase either
+    for(point = 0; point < sweep->count; point++)
+    {
+        phase[point] = (impedance[point] > 0) ? phase[point] : 0.0f;
+    }
+}
+
+/***************************************************************************//**
+ * @brief Records the temperature a calibration was measured at and the
+ *        relative drift of its gain factor with temperature.
+ *
+ * @param cal         - Calibration.
+ * @param temperature - Temperature of the calibration sweep in degrees C.
+ * @param gainTempCo  - Relative change of the gain factor per degree C.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_SetCalibrationTemperature(AD5933_Calibration *cal,
+                                      float temperature,
+                                      float gainTempCo)
+{
+    cal->temperature = temperature;
+    cal->gainTempCo  = gainTempCo;
+}
+
+/***************************************************************************//**
+ * @brief Estimates the gain drift from two calibrations of the same grid
+ *        and resistor taken at different temperatures: the mean over the
+ *        points of (other / reference - 1) / (Tother - Treference).
+ *
+ * @param reference - Calibration with its temperature.
+ * @param other     - Calibration of the same grid at another temperature.
+ *
+ * @return Relative change of the gain factor per degree C, 0 if the
+ *         calibrations cannot be compared.
+*******************************************************************************/
+float AD5933_EstimateGainTempCo(const AD5933_Calibration *reference,
+                                const AD5933_Calibration *other)
+{
+    double         delta = (double)other->temperature - reference->temperature;
+    double         drift = 0;
+    unsigned short point = 0;
+    
+    if(isnan(delta) || (fabs(delta) < 0.5) ||
+       (reference->startFreq != other->startFreq) ||
+       (reference->incFreq != other->incFreq) ||
+       (reference->points != other->points) || (reference->points == 0))
+    {
+        return 0;
+    }
+    for(point = 0; point < reference->points; point++)
+    {
+        drift += (double)other->gainFactor[point] / reference->gainFactor[point] - 1;
+    }
+    
+    return (float)(drift / reference->points / delta);
+}
+
+/***************************************************************************//**
+ * @brief Converts a whole sweep like AD5933_ApplyCalibration, correcting the
+ *        gain factor for the difference between the temperature of the
+ *        measurement and that of the calibration, so a warmer enclosure
+ *        does not need a new calibration.
+ *
+ * @param cal         - Calibration with its temperature and gain drift.
+ * @param sweep       - Raw data of the measured sweep.
+ * @param startFreq   - Start frequency of the sweep in Hz.
+ * @param incFreq     - Frequency increment of the sweep in Hz.
+ * @param temperature - Temperature of the measurement (e.g. the cached value
+ *                      of the temperature service); NAN skips the correction.
+ * @param impedance   - Impedance magnitude of each point in ohms.
+ * @param phase       - Impedance phase of each point in radians.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_ApplyCalibrationAt(const AD5933_Calibration *cal,
+                               const AD5933_SweepBuffer *sweep,
+                               unsigned long startFreq,
+                               unsigned long incFreq,
+                               float temperature,
+                               float *impedance,
+                               float *phase)
+{
+    float          scale = 1;
+    unsigned short point = 0;
+    
+    AD5933_ApplyCalibration(cal, sweep, startFreq, incFreq, impedance, phase);
+    scale = 1 + cal->gainTempCo * (temperature - cal->temperature);
+    if(isnan(scale) || (scale <= 0))
+    {
+        return;
+    }
+    // The impedance is inversely proportional to the gain factor
+    scale = 1 / scale;
+    for(point = 0; point < sweep->count; point++)
+    {
+        impedance[point] *= scale;
+    }
+}
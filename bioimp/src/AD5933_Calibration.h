@@ -0,0 +1,82 @@
+/***************************************************************************//**
+ *   @file   AD5933_Calibration.h
+ *   @brief  Per-frequency gain factor and system phase calibration.
+*******************************************************************************/
+
+#ifndef __AD5933_CALIBRATION_H__
+#define __AD5933_CALIBRATION_H__
+
+#include "stdbool.h"
+#include "AD5933.h"
+
+/******************************************************************************/
+/************************** Calibration Types *********************************/
+/******************************************************************************/
+
+/* Calibration of one sweep grid. Frequencies are not stored: point i is at
+   startFreq + i * incFreq. At a temperature T the gain factor is
+   gainFactor * (1 + gainTempCo * (T - temperature)). */
+typedef struct {
+    float          gainFactor[AD5933_MAX_POINTS];   // 1 / (|Zcal| * magnitude)
+    float          systemPhase[AD5933_MAX_POINTS];  // Phase of the DFT, radians
+    unsigned long  startFreq;                       // Frequency of point 0 (Hz)
+    unsigned long  incFreq;                         // Step between points (Hz)
+    unsigned short points;                          // Number of valid points
+    float          temperature;                     // At calibration (C), NAN
+                                                    // if unknown
+    float          gainTempCo;                      // Relative gain drift (1/C)
+} AD5933_Calibration;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Builds the calibration from a sweep measured on a known resistor. */
+bool AD5933_BuildCalibration(AD5933_Calibration *cal,
+                             const AD5933_SweepBuffer *sweep,
+                             unsigned long calibrationImpedance,
+                             unsigned long startFreq,
+                             unsigned long incFreq);
+
+/*! Configures and runs a calibration sweep, then builds the calibration. */
+bool AD5933_RunCalibration(AD5933_Device *dev,
+                           AD5933_Calibration *cal,
+                           AD5933_SweepBuffer *buffer,
+                           unsigned long  calibrationImpedance,
+                           unsigned long  startFreq,
+                           unsigned long  incFreq,
+                           unsigned short incNum);
+
+/*! Interpolates gain factor and system phase at any frequency. */
+void AD5933_InterpolateCalibration(const AD5933_Calibration *cal,
+                                   double frequency,
+                                   float *gainFactor,
+                                   float *systemPhase);
+
+/*! Converts a whole sweep into impedance magnitude and phase. */
+void AD5933_ApplyCalibration(const AD5933_Calibration *cal,
+                             const AD5933_SweepBuffer *sweep,
+                             unsigned long startFreq,
+                             unsigned long incFreq,
+                             float *impedance,
+                             float *phase);
+
+/*! Records the temperature of a calibration and its gain drift. */
+void AD5933_SetCalibrationTemperature(AD5933_Calibration *cal,
+                                      float temperature,
+                                      float gainTempCo);
+
+/*! Estimates the gain drift from two calibrations at different temperatures. */
+float AD5933_EstimateGainTempCo(const AD5933_Calibration *reference,
+                                const AD5933_Calibration *other);
+
+/*! Converts a whole sweep measured at a known temperature. */
+void AD5933_ApplyCalibrationAt(const AD5933_Calibration *cal,
+                               const AD5933_SweepBuffer *sweep,
+                               unsigned long startFreq,
+                               unsigned long incFreq,
+                               float temperature,
+                               float *impedance,
+                               float *phase);
+
+#endif /* __AD5933_CALIBRATION_H__ */
@@ -0,0 +1,243 @@
+/***************************************************************************//**
+ *   @file   AD5933_I2cDev.c
+ *   @brief  Linux i2c-dev backend: each batch of bus operations is a single
+ *           I2C_RDWR system call.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_I2cDev.h"
+#include "stdio.h"
+#include "fcntl.h"
+#include "unistd.h"
+#include "sys/ioctl.h"
+#include "linux/i2c-dev.h"
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Opens an I2C bus adapter. The AD5933 has a fixed address, so the
+ *        descriptor is the handle of the device on that bus.
+ *
+ * @param bus - Adapter number, N of /dev/i2c-N.
+ *
+ * @return File descriptor, or -1 if the adapter cannot be opened.
+*******************************************************************************/
+int AD5933_I2cDevOpen(unsigned char bus)
+{
+    char path[16];
+
+    snprintf(path, sizeof(path), "/dev/i2c-%u", bus);
+
+    return open(path, O_RDWR);
+}
+
+/***************************************************************************//**
+ * @brief Builds the I2C_RDWR messages of as many operations as fit in one
+ *        call: one message for each write and a write plus a repeated-start
+ *        read for each read, so a pointer write and the block read behind it
+ *        always share one call. No file descriptor is involved, so the
+ *        frames can be checked without an adapter.
+ *
+ * @param ops      - Operations.
+ * @param count    - Number of operations.
+ * @param transfer - Messages and write frames built.
+ *
+ * @return Number of operations taken, or -1 if the first one carries more
+ *         than AD5933_BUS_MAX_DATA bytes.
+*******************************************************************************/
+int AD5933_I2cDevBuildMessages(const AD5933_BusOp *ops,
+                               unsigned char count,
+                               AD5933_I2cDevTransfer *transfer)
+{
+    const AD5933_BusOp *op    = 0;
+    struct i2c_msg     *msg   = 0;
+    unsigned char      *frame = 0;
+    unsigned char       index = 0;
+    unsigned char       byte  = 0;
+
+    transfer->count = 0;
+    // Room for the two messages of a read
+    for(index = 0; (index < count) &&
+                   (transfer->count + 2 <= AD5933_I2CDEV_MAX_MSGS); index++)
+    {
+        op = &ops[index];
+        if(op->size > AD5933_BUS_MAX_DATA)
+        {
+            return (index == 0) ? -1 : index;
+        }
+        msg        = &transfer->msgs[transfer->count];
+        frame      = transfer->frames[transfer->count];
+        frame[0]   = op->command;
+        msg->addr  = AD5933_ADDRESS;
+        msg->flags = 0;
+        msg->buf   = frame;
+        switch(op->type)
+        {
+            case AD5933_BUS_WRITE_REG8:
+                frame[1] = op->data[0];
+                msg->len = 2;
+                break;
+            case AD5933_BUS_WRITE_BLOCK:
+                frame[1] = op->size;
+                for(byte = 0; byte < op->size; byte++)
+                {
+                    frame[2 + byte] = op->data[byte];
+                }
+                msg->len = 2 + op->size;
+                break;
+            case AD5933_BUS_READ_REG8:
+                msg->len = 1;
+                break;
+            default:
+                frame[1] = op->size;
+                msg->len = 2;
+                break;
+        }
+        transfer->count++;
+        if((op->type == AD5933_BUS_READ_REG8) ||
+           (op->type == AD5933_BUS_READ_BLOCK))
+        {
+            msg        = &transfer->msgs[transfer->count];
+            msg->addr  = AD5933_ADDRESS;
+            msg->flags = I2C_M_RD;
+            msg->len   = op->size;
+            msg->buf   = op->readData;
+            transfer->count++;
+        }
+    }
+
+    return index;
+}
+
+/***************************************************************************//**
+ * @brief Runs bus operations as combined I2C_RDWR transfers built by
+ *        AD5933_I2cDevBuildMessages. Only batches of more than
+ *        AD5933_I2CDEV_MAX_MSGS messages take more than one call.
+ *
+ * @param i2cdevice - File descriptor of the adapter.
+ * @param ops       - Operations.
+ * @param count     - Number of operations.
+ *
+ * @return false if a transfer failed; the operations after it are not run.
+*******************************************************************************/
+bool AD5933_I2cDevSubmit(int i2cdevice,
+                         const AD5933_BusOp *ops,
+                         unsigned char count)
+{
+    AD5933_I2cDevTransfer      transfer;
+    struct i2c_rdwr_ioctl_data data  = {transfer.msgs, 0};
+    int                        taken = 0;
+
+    while(count > 0)
+    {
+        taken = AD5933_I2cDevBuildMessages(ops, count, &transfer);
+        if(taken < 0)
+        {
+            return false;
+        }
+        data.nmsgs = transfer.count;
+        if(ioctl(i2cdevice, I2C_RDWR, &data) < 0)
+        {
+            return false;
+        }
+        ops   += taken;
+        count -= taken;
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Byte write through one I2C_RDWR call.
+ *
+ * @param i2cdevice - File descriptor of the adapter.
+ * @param command   - Register address or AD5933_ADDR_POINTER.
+ * @param data      - Byte to write.
+ *
+ * @return true if the transfer succeeded.
+*******************************************************************************/
+static bool AD5933_I2cDevWriteReg8(int i2cdevice,
+                                   unsigned char command,
+                                   unsigned char data)
+{
+    AD5933_BusOp op = {AD5933_BUS_WRITE_REG8, command, 1, {data}, 0};
+
+    return AD5933_I2cDevSubmit(i2cdevice, &op, 1);
+}
+
+/***************************************************************************//**
+ * @brief Byte read of a register through one I2C_RDWR call.
+ *
+ * @param i2cdevice - File descriptor of the adapter.
+ * @param command   - Register address.
+ *
+ * @return Register value, or -1 if the transfer failed.
+*******************************************************************************/
+static int AD5933_I2cDevReadReg8(int i2cdevice, unsigned char command)
+{
+    unsigned char value = 0;
+    AD5933_BusOp  op    = {AD5933_BUS_READ_REG8, command, 1, {0}, &value};
+
+    return AD5933_I2cDevSubmit(i2cdevice, &op, 1) ? value : -1;
+}
+
+/***************************************************************************//**
+ * @brief Block write through one I2C_RDWR call.
+ *
+ * @param i2cdevice - File descriptor of the adapter.
+ * @param command   - AD5933_BLOCK_WRITE.
+ * @param values    - Bytes to write.
+ * @param size      - Number of bytes, at most AD5933_BUS_MAX_DATA.
+ *
+ * @return true if the transfer succeeded.
+*******************************************************************************/
+static bool AD5933_I2cDevWriteBlock(int i2cdevice,
+                                    unsigned char command,
+                                    const unsigned char *values,
+                                    unsigned char size)
+{
+    AD5933_BusOp  op   = {AD5933_BUS_WRITE_BLOCK, command, size, {0}, 0};
+    unsigned char byte = 0;
+
+    for(byte = 0; (byte < size) && (byte < AD5933_BUS_MAX_DATA); byte++)
+    {
+        op.data[byte] = values[byte];
+    }
+
+    return AD5933_I2cDevSubmit(i2cdevice, &op, 1);
+}
+
+/***************************************************************************//**
+ * @brief Block read through one I2C_RDWR call.
+ *
+ * @param i2cdevice - File descriptor of the adapter.
+ * @param command   - AD5933_BLOCK_READ.
+ * @param values    - Buffer for the bytes read.
+ * @param size      - Number of bytes.
+ *
+ * @return Number of bytes read, or -1 if the transfer failed.
+*******************************************************************************/
+static int AD5933_I2cDevReadBlock(int i2cdevice,
+                                  unsigned char command,
+                                  unsigned char *values,
+                                  unsigned char size)
+{
+    AD5933_BusOp op = {AD5933_BUS_READ_BLOCK, command, size, {0}, values};
+
+    return AD5933_I2cDevSubmit(i2cdevice, &op, 1) ? size : -1;
+}
+
+/******************************************************************************/
+/************************** Variables Definitions *****************************/
+/******************************************************************************/
+const AD5933_Transport AD5933_I2CDEV_TRANSPORT = {
+    AD5933_I2cDevWriteReg8,
+    AD5933_I2cDevReadReg8,
+    AD5933_I2cDevWriteBlock,
+    AD5933_I2cDevReadBlock,
+    AD5933_I2cDevSubmit
+};
@@ -0,0 +1,58 @@
+/***************************************************************************//**
+ *   @file   AD5933_I2cDev.h
+ *   @brief  Linux i2c-dev backend: each batch of bus operations is a single
+ *           I2C_RDWR system call.
+*******************************************************************************/
+
+#ifndef __AD5933_I2CDEV_H__
+#define __AD5933_I2CDEV_H__
+
+#include "stdbool.h"
+#include "linux/i2c.h"
+#include "AD5933.h"
+
+/******************************************************************************/
+/*************************** I2cDev Definitions *******************************/
+/******************************************************************************/
+
+#define AD5933_I2CDEV_MAX_MSGS      42      // Messages of one I2C_RDWR call
+#define AD5933_I2CDEV_FRAME_SIZE    (2 + AD5933_BUS_MAX_DATA)   // Command,
+                                            // count, data
+
+/******************************************************************************/
+/****************************** I2cDev Types **********************************/
+/******************************************************************************/
+
+/* Messages of one I2C_RDWR call. Write messages point into frames; read
+   messages point at the readData buffers of the operations. */
+typedef struct {
+    struct i2c_msg msgs[AD5933_I2CDEV_MAX_MSGS];
+    unsigned char  frames[AD5933_I2CDEV_MAX_MSGS][AD5933_I2CDEV_FRAME_SIZE];
+    unsigned char  count;               // Messages used
+} AD5933_I2cDevTransfer;
+
+/******************************************************************************/
+/************************ Variables Declarations ******************************/
+/******************************************************************************/
+
+/*! Backend on /dev/i2c-N; the device handle is the file descriptor. */
+extern const AD5933_Transport AD5933_I2CDEV_TRANSPORT;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Opens an I2C bus adapter and returns its file descriptor. */
+int AD5933_I2cDevOpen(unsigned char bus);
+
+/*! Builds the messages of the operations that fit in one I2C_RDWR call. */
+int AD5933_I2cDevBuildMessages(const AD5933_BusOp *ops,
+                               unsigned char count,
+                               AD5933_I2cDevTransfer *transfer);
+
+/*! Runs bus operations with as few I2C_RDWR calls as possible. */
+bool AD5933_I2cDevSubmit(int i2cdevice,
+                         const AD5933_BusOp *ops,
+                         unsigned char count);
+
+#endif /* __AD5933_I2CDEV_H__ */
@@ -0,0 +1,280 @@
+/***************************************************************************//**
+ *   @file   AD5933_Kernel.c
+ *   @brief  Batch computation of magnitude, phase and impedance of a sweep.
+ *
+ *   The floating point loops have no calls and no data dependent branches, so
+ *   the compiler can vectorize them (SSE/AVX/NEON) at -O3 with
+ *   -fno-math-errno -fno-trapping-math (or -ffast-math). The integer kernel
+ *   needs no FPU at all.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Kernel.h"
+#include "math.h"
+
+/******************************************************************************/
+/************************** Constants Definitions *****************************/
+/******************************************************************************/
+#define KERNEL_PI           3.14159265f
+#define KERNEL_HALF_PI      1.57079633f
+#define CORDIC_STEPS        14
+#define CORDIC_SHIFT        14      // Extra resolution of the CORDIC vectors
+
+/* atan(2^-i) as binary angles (pi = 32768) */
+static const long CORDIC_ANGLES[CORDIC_STEPS] = {
+    8192, 4836, 2555, 1297, 651, 326, 163, 81, 41, 20, 10, 5, 3, 1
+};
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Branch-free atan2 approximation (max. error 1e-6 rad), so the phase
+ *        loop vectorizes instead of calling atan2f for every point.
+ *
+ * @param y - Imaginary part.
+ * @param x - Real part.
+ *
+ * @return Phase in radians, in [-pi, pi].
+*******************************************************************************/
+static inline float AD5933_FastAtan2(float y, float x)
+{
+    float ax    = fabsf(x);
+    float ay    = fabsf(y);
+    float high  = (ax > ay) ? ax : ay;
+    float low   = (ax > ay) ? ay : ax;
+    float ratio = low / ((high > 0) ? high : 1.0f);
+    float sq    = ratio * ratio;
+    // Odd minimax polynomial of atan on [0, 1], degree 13
+    float angle = ratio * (0.999996112f + sq * (-0.333173693f +
+                  sq * (0.198078245f + sq * (-0.132333715f +
+                  sq * (0.079624148f + sq * (-0.033604593f +
+                  sq * 0.006811906f))))));
+    
+    angle = (ay > ax) ? (KERNEL_HALF_PI - angle) : angle;
+    angle = (x < 0) ? (KERNEL_PI - angle) : angle;
+    
+    return (y < 0) ? -angle : angle;
+}
+
+/***************************************************************************//**
+ * @brief Computes magnitude, phase and impedance of every point of a sweep
+ *        in one pass, with a gain factor and system phase per point.
+ *
+ * @param realData    - Raw real data of each point.
+ * @param imagData    - Raw imaginary data of each point.
+ * @param gainFactor  - Gain factor of each point.
+ * @param systemPhase - System phase of each point in radians.
+ * @param count       - Number of points.
+ * @param magnitude   - DFT magnitude of each point, or NULL if not needed.
+ * @param phase       - Impedance phase of each point in radians.
+ * @param impedance   - Impedance magnitude of each point in ohms (0 if the
+ *                      point had no signal).
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_ProcessSweep(const signed short *restrict realData,
+                         const signed short *restrict imagData,
+                         const float *restrict gainFactor,
+                         const float *restrict systemPhase,
+                         unsigned short count,
+                         float *restrict magnitude,
+                         float *restrict phase,
+                         float *restrict impedance)
+{
+    int point;
+    
+    for(point = 0; point < count; point++)
+    {
+        float r     = realData[point];
+        float i     = imagData[point];
+        float scale = gainFactor[point] * sqrtf(r * r + i * i);
+        float inv   = 1.0f / ((scale > 0) ? scale : 1.0f);
+        
+        impedance[point] = (scale > 0) ? inv : 0.0f;
+    }
+    if(magnitude != 0)
+    {
+        for(point = 0; point < count; point++)
+        {
+            float r = realData[point];
+            float i = imagData[point];
+            
+            magnitude[point] = sqrtf(r * r + i * i);
+        }
+    }
+    for(point = 0; point < count; point++)
+    {
+        float angle = AD5933_FastAtan2(imagData[point], realData[point]) -
+                      systemPhase[point];
+        
+        angle = (angle > KERNEL_PI)   ? (angle - 2 * KERNEL_PI) : angle;
+        angle = (angle <= -KERNEL_PI) ? (angle + 2 * KERNEL_PI) : angle;
+        phase[point] = angle;
+    }
+}
+
+/***************************************************************************//**
+ * @brief Integer square root, rounded down (bit by bit, no division).
+ *
+ * @param value - Radicand.
+ *
+ * @return Square root of value.
+*******************************************************************************/
+unsigned short AD5933_Isqrt(unsigned long value)
+{
+    unsigned long root = 0;
+    unsigned long bit  = 1ul << 30;
+    
+    value &= 0xFFFFFFFFul;
+    while(bit > value)
+    {
+        bit >>= 2;
+    }
+    while(bit != 0)
+    {
+        if(value >= root + bit)
+        {
+            value -= root + bit;
+            root   = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    
+    return (unsigned short)root;
+}
+
+/***************************************************************************//**
+ * @brief Phase of the vector (x, y) computed with CORDIC in vectoring mode.
+ *
+ * @param y - Imaginary part.
+ * @param x - Real part.
+ *
+ * @return Phase as a binary angle (AD5933_ANGLE_PI is pi).
+*******************************************************************************/
+signed short AD5933_Atan2Cordic(signed short y, signed short x)
+{
+    long          vx    = (long)x * (1l << CORDIC_SHIFT);
+    long          vy    = (long)y * (1l << CORDIC_SHIFT);
+    long          angle = 0;
+    long          tmp   = 0;
+    unsigned char step  = 0;
+    
+    // Rotate by +-90 degrees into the right half plane
+    if(vx < 0)
+    {
+        tmp = vx;
+        if(vy >= 0)
+        {
+            vx    = vy;
+            vy    = -tmp;
+            angle = AD5933_ANGLE_PI / 2;
+        }
+        else
+        {
+            vx    = -vy;
+            vy    = tmp;
+            angle = -AD5933_ANGLE_PI / 2;
+        }
+    }
+    for(step = 0; step < CORDIC_STEPS; step++)
+    {
+        tmp = vx;
+        if(vy > 0)
+        {
+            vx    += vy >> step;
+            vy    -= tmp >> step;
+            angle += CORDIC_ANGLES[step];
+        }
+        else
+        {
+            vx    -= vy >> step;
+            vy    += tmp >> step;
+            angle -= CORDIC_ANGLES[step];
+        }
+    }
+    
+    return (signed short)angle;
+}
+
+/***************************************************************************//**
+ * @brief Integer-only version of AD5933_ProcessSweep for targets without FPU.
+ *
+ * @param realData    - Raw real data of each point.
+ * @param imagData    - Raw imaginary data of each point.
+ * @param calScale    - 1 / gain factor of each point (ohms x DFT counts).
+ * @param systemPhase - System phase of each point as a binary angle.
+ * @param count       - Number of points.
+ * @param magnitude   - DFT magnitude of each point, or NULL if not needed.
+ * @param phase       - Impedance phase of each point as a binary angle.
+ * @param impedance   - Impedance magnitude of each point in ohms (0 if the
+ *                      point had no signal).
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_ProcessSweepFixed(const signed short *realData,
+                              const signed short *imagData,
+                              const unsigned long long *calScale,
+                              const signed short *systemPhase,
+                              unsigned short count,
+                              unsigned short *magnitude,
+                              signed short *phase,
+                              unsigned long *impedance)
+{
+    unsigned short     point = 0;
+    unsigned short     mag   = 0;
+    unsigned long long z     = 0;
+    
+    for(point = 0; point < count; point++)
+    {
+        mag = AD5933_Isqrt((unsigned long)((long)realData[point] * realData[point]) +
+                           (unsigned long)((long)imagData[point] * imagData[point]));
+        if(magnitude != 0)
+        {
+            magnitude[point] = mag;
+        }
+        z = (mag != 0) ? ((calScale[point] + mag / 2) / mag) : 0;
+        impedance[point] = (z > 0xFFFFFFFFull) ? 0xFFFFFFFFul : (unsigned long)z;
+        // Binary angles wrap around by themselves
+        phase[point] = (signed short)(unsigned short)
+                       (AD5933_Atan2Cordic(imagData[point], realData[point]) -
+                        systemPhase[point]);
+    }
+}
+
+/***************************************************************************//**
+ * @brief Converts a floating point calibration (gain factor and system phase
+ *        in radians) into the inputs of AD5933_ProcessSweepFixed.
+ *
+ * @param gainFactor  - Gain factor of each point.
+ * @param systemPhase - System phase of each point in radians.
+ * @param count       - Number of points.
+ * @param calScale    - 1 / gain factor of each point, rounded.
+ * @param phaseFixed  - System phase of each point as a binary angle.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_ConvertCalibration(const float *gainFactor,
+                               const float *systemPhase,
+                               unsigned short count,
+                               unsigned long long *calScale,
+                               signed short *phaseFixed)
+{
+    unsigned short point = 0;
+    
+    for(point = 0; point < count; point++)
+    {
+        calScale[point]   = (gainFactor[point] > 0) ?
+                            (unsigned long long)(1.0 / gainFactor[point] + 0.5) :
+                            0;
+        phaseFixed[point] = (signed short)lround(systemPhase[point] *
+                                                 AD5933_ANGLE_PI / KERNEL_PI);
+    }
+}
@@ -0,0 +1,54 @@
+/***************************************************************************//**
+ *   @file   AD5933_Kernel.h
+ *   @brief  Batch computation of magnitude, phase and impedance of a sweep.
+*******************************************************************************/
+
+#ifndef __AD5933_KERNEL_H__
+#define __AD5933_KERNEL_H__
+
+/******************************************************************************/
+/**************************** Kernel Definitions ******************************/
+/******************************************************************************/
+
+/* Binary angle used by the integer kernel: a full turn is 65536, so the
+   phase wraps around by itself in 16-bit arithmetic. */
+#define AD5933_ANGLE_PI             32768l
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Computes magnitude, phase and impedance of a sweep (floating point). */
+void AD5933_ProcessSweep(const signed short *realData,
+                         const signed short *imagData,
+                         const float *gainFactor,
+                         const float *systemPhase,
+                         unsigned short count,
+                         float *magnitude,
+                         float *phase,
+                         float *impedance);
+
+/*! Computes magnitude, phase and impedance of a sweep (integer only). */
+void AD5933_ProcessSweepFixed(const signed short *realData,
+                              const signed short *imagData,
+                              const unsigned long long *calScale,
+                              const signed short *systemPhase,
+                              unsigned short count,
+                              unsigned short *magnitude,
+                              signed short *phase,
+                              unsigned long *impedance);
+
+/*! Converts a floating point calibration for the integer kernel. */
+void AD5933_ConvertCalibration(const float *gainFactor,
+                               const float *systemPhase,
+                               unsigned short count,
+                               unsigned long long *calScale,
+                               signed short *phaseFixed);
+
+/*! Integer square root, rounded down. */
+unsigned short AD5933_Isqrt(unsigned long value);
+
+/*! Phase of (x, y) as a binary angle, computed with CORDIC. */
+signed short AD5933_Atan2Cordic(signed short y, signed short x);
+
+#endif /* __AD5933_KERNEL_H__ */
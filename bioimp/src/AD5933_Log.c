@@ -0,0 +1,85 @@
+/***************************************************************************//**
+ *   @file   AD5933_Log.c
+ *   @brief  Formatting side of the driver log. Runs in the consumer thread,
+ *           never on the measurement path.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Log.h"
+#include "stdio.h"
+
+/******************************************************************************/
+/************************** Constants Definitions *****************************/
+/******************************************************************************/
+static const char *const LOG_LEVELS[] = {
+    "NONE", "ERROR", "WARN", "INFO", "DEBUG"
+};
+
+/* Format of each AD5933_LogEvent; every argument is a long */
+static const char *const LOG_FORMATS[AD5933_EVENT_COUNT] = {
+    "Read register 0x%02lx = 0x%02lx",
+    "Block read from 0x%02lx, %ld bytes",
+    "Bus error at register 0x%02lx",
+    "Sweep start code 0x%06lx, increment code 0x%06lx, %ld increments",
+    "Calibration step R=%ld I=%ld",
+    "Poll timeout after %ld polls"
+};
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Initializes a ring of log records over caller-owned storage.
+ *
+ * @param ring     - Ring to initialize.
+ * @param records  - Storage for capacity records.
+ * @param capacity - Number of records, power of 2.
+ *
+ * @return false if capacity is not a power of 2.
+*******************************************************************************/
+bool AD5933_LogInit(AD5933_Ring *ring,
+                    AD5933_LogRecord *records,
+                    unsigned long capacity)
+{
+    return AD5933_RingInit(ring, records, sizeof(AD5933_LogRecord), capacity);
+}
+
+/***************************************************************************//**
+ * @brief Pops the oldest record and formats it as "LEVEL: message". Only the
+ *        consumer thread may call it.
+ *
+ * @param ring - Ring of log records.
+ * @param text - Buffer for the text.
+ * @param size - Size of the buffer.
+ *
+ * @return false if there was no record.
+*******************************************************************************/
+bool AD5933_LogFormat(AD5933_Ring *ring,
+                      char *text,
+                      unsigned short size)
+{
+    AD5933_LogRecord record;
+    int              length = 0;
+    
+    if(!AD5933_RingPop(ring, &record))
+    {
+        return false;
+    }
+    if((record.level > AD5933_LOG_LEVEL_DEBUG) ||
+       (record.event >= AD5933_EVENT_COUNT))
+    {
+        snprintf(text, size, "Unknown record %u", record.event);
+        return true;
+    }
+    length = snprintf(text, size, "%s: ", LOG_LEVELS[record.level]);
+    if((length >= 0) && (length < size))
+    {
+        snprintf(text + length, size - length, LOG_FORMATS[record.event],
+                 record.args[0], record.args[1], record.args[2]);
+    }
+    
+    return true;
+}
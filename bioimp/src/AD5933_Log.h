@@ -0,0 +1,142 @@
+/***************************************************************************//**
+ *   @file   AD5933_Log.h
+ *   @brief  Structured logging of the driver into a lock-free ring.
+ *
+ *   Log calls below AD5933_LOG_LEVEL compile to nothing (their arguments are
+ *   not even evaluated). The others copy a small binary record into an
+ *   AD5933_Ring, never blocking the caller; a separate thread pops and
+ *   formats the records with AD5933_LogFormat.
+*******************************************************************************/
+
+#ifndef __AD5933_LOG_H__
+#define __AD5933_LOG_H__
+
+#include "stdbool.h"
+#include "AD5933_Ring.h"
+
+/******************************************************************************/
+/***************************** Log Definitions ********************************/
+/******************************************************************************/
+
+/* Log levels */
+#define AD5933_LOG_LEVEL_NONE       0
+#define AD5933_LOG_LEVEL_ERROR      1
+#define AD5933_LOG_LEVEL_WARN       2
+#define AD5933_LOG_LEVEL_INFO       3
+#define AD5933_LOG_LEVEL_DEBUG      4
+
+/* Highest level compiled in, set with -DAD5933_LOG_LEVEL=<n> */
+#ifndef AD5933_LOG_LEVEL
+#define AD5933_LOG_LEVEL            AD5933_LOG_LEVEL_NONE
+#endif
+
+/* Arguments per record */
+#define AD5933_LOG_ARGS             3
+
+/******************************************************************************/
+/****************************** Log Types *************************************/
+/******************************************************************************/
+
+/* Logged events. Each one has a fixed format in AD5933_Log.c. */
+typedef enum {
+    AD5933_EVENT_REG_READ,          // register, value
+    AD5933_EVENT_BLOCK_READ,        // first register, bytes
+    AD5933_EVENT_BUS_ERROR,         // register
+    AD5933_EVENT_SWEEP_CONFIG,      // start code, increment code, increments
+    AD5933_EVENT_CALIBRATION_STEP,  // real data, imaginary data
+    AD5933_EVENT_POLL_TIMEOUT,      // polls
+    AD5933_EVENT_COUNT
+} AD5933_LogEvent;
+
+/* Binary record stored in the ring; formatting is deferred. */
+typedef struct {
+    unsigned char  level;                   // AD5933_LOG_LEVEL_x
+    unsigned char  event;                   // AD5933_LogEvent
+    long           args[AD5933_LOG_ARGS];   // Event arguments
+} AD5933_LogRecord;
+
+/******************************************************************************/
+/****************************** Log Macros ************************************/
+/******************************************************************************/
+
+#if AD5933_LOG_LEVEL >= AD5933_LOG_LEVEL_ERROR
+#define AD5933_LOG_ERROR(ring, event, a0, a1, a2) \
+    AD5933_LogWrite(ring, AD5933_LOG_LEVEL_ERROR, event, a0, a1, a2)
+#else
+#define AD5933_LOG_ERROR(ring, event, a0, a1, a2)   ((void)0)
+#endif
+
+#if AD5933_LOG_LEVEL >= AD5933_LOG_LEVEL_WARN
+#define AD5933_LOG_WARN(ring, event, a0, a1, a2) \
+    AD5933_LogWrite(ring, AD5933_LOG_LEVEL_WARN, event, a0, a1, a2)
+#else
+#define AD5933_LOG_WARN(ring, event, a0, a1, a2)    ((void)0)
+#endif
+
+#if AD5933_LOG_LEVEL >= AD5933_LOG_LEVEL_INFO
+#define AD5933_LOG_INFO(ring, event, a0, a1, a2) \
+    AD5933_LogWrite(ring, AD5933_LOG_LEVEL_INFO, event, a0, a1, a2)
+#else
+#define AD5933_LOG_INFO(ring, event, a0, a1, a2)    ((void)0)
+#endif
+
+#if AD5933_LOG_LEVEL >= AD5933_LOG_LEVEL_DEBUG
+#define AD5933_LOG_DEBUG(ring, event, a0, a1, a2) \
+    AD5933_LogWrite(ring, AD5933_LOG_LEVEL_DEBUG, event, a0, a1, a2)
+#else
+#define AD5933_LOG_DEBUG(ring, event, a0, a1, a2)   ((void)0)
+#endif
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Stores a log record. Does nothing if no ring is attached; drops the
+ *        record (and counts it in the ring) if the ring is full.
+ *
+ * @param ring  - Ring of AD5933_LogRecord slots, or NULL.
+ * @param level - Level of the record.
+ * @param event - Event logged.
+ * @param a0    - First argument.
+ * @param a1    - Second argument.
+ * @param a2    - Third argument.
+ *
+ * @return None.
+*******************************************************************************/
+static inline void AD5933_LogWrite(AD5933_Ring *ring,
+                                   unsigned char level,
+                                   AD5933_LogEvent event,
+                                   long a0,
+                                   long a1,
+                                   long a2)
+{
+    AD5933_LogRecord record;
+    
+    if(ring == 0)
+    {
+        return;
+    }
+    record.level   = level;
+    record.event   = (unsigned char)event;
+    record.args[0] = a0;
+    record.args[1] = a1;
+    record.args[2] = a2;
+    AD5933_RingPush(ring, &record);
+}
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Initializes a ring of log records over caller-owned storage. */
+bool AD5933_LogInit(AD5933_Ring *ring,
+                    AD5933_LogRecord *records,
+                    unsigned long capacity);
+
+/*! Pops the oldest record and formats it as text. */
+bool AD5933_LogFormat(AD5933_Ring *ring,
+                      char *text,
+                      unsigned short size);
+
+#endif /* __AD5933_LOG_H__ */
@@ -0,0 +1,275 @@
+/***************************************************************************//**
+ *   @file   AD5933_Pipeline.c
+ *   @brief  Hand-off of raw sweep frames from the acquisition threads to a
+ *           pool of processing workers through lock-free queues.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Pipeline.h"
+#include "time.h"
+#include "sched.h"
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Initializes a pipeline: every frame starts free. Nothing is
+ *        allocated; the frames and cells must outlive the pipeline.
+ *
+ * @param pipeline     - Pipeline to initialize.
+ * @param frames       - Storage for capacity frames.
+ * @param cells        - Storage for 2 * capacity queue cells.
+ * @param capacity     - Number of frames, power of 2.
+ * @param calibrations - Calibration of each channel, NULL entries (or NULL)
+ *                       leave the frames of a channel raw.
+ * @param channels     - Entries in calibrations.
+ * @param handler      - Last stage of the workers, NULL for none.
+ * @param context      - Argument passed back to the handler.
+ *
+ * @return false if capacity is not a power of 2 or the semaphore failed.
+*******************************************************************************/
+bool AD5933_PipelineInit(AD5933_Pipeline *pipeline,
+                         AD5933_Frame *frames,
+                         AD5933_QueueCell *cells,
+                         unsigned long capacity,
+                         const AD5933_Calibration *const *calibrations,
+                         unsigned short channels,
+                         AD5933_FrameHandler handler,
+                         void *context)
+{
+    unsigned long index = 0;
+
+    if(!AD5933_QueueInit(&pipeline->freeFrames, cells, capacity) ||
+       !AD5933_QueueInit(&pipeline->readyFrames, &cells[capacity], capacity) ||
+       (sem_init(&pipeline->ready, 0, 0) != 0))
+    {
+        return false;
+    }
+    for(index = 0; index < capacity; index++)
+    {
+        frames[index].sweep.realData = frames[index].realData;
+        frames[index].sweep.imagData = frames[index].imagData;
+        frames[index].sweep.capacity = AD5933_MAX_POINTS;
+        frames[index].sweep.count    = 0;
+        AD5933_QueuePush(&pipeline->freeFrames, &frames[index]);
+    }
+    pipeline->workerCount  = 0;
+    pipeline->calibrations = calibrations;
+    pipeline->channels     = (calibrations != 0) ? channels : 0;
+    pipeline->handler      = handler;
+    pipeline->context      = context;
+    atomic_init(&pipeline->stopping, false);
+    atomic_init(&pipeline->published, 0);
+    atomic_init(&pipeline->processed, 0);
+    atomic_init(&pipeline->overruns, 0);
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Body of a worker: takes the ready frames, converts them with the
+ *        calibration of their channel at their temperature, runs the
+ *        handler and frees them. Sleeps while nothing is ready.
+ *
+ * @param argument - Pipeline.
+ *
+ * @return NULL.
+*******************************************************************************/
+static void *AD5933_PipelineWorker(void *argument)
+{
+    AD5933_Pipeline          *pipeline = (AD5933_Pipeline *)argument;
+    const AD5933_Calibration *cal      = 0;
+    AD5933_Frame             *frame    = 0;
+    void                     *value    = 0;
+
+    while(true)
+    {
+        while(sem_wait(&pipeline->ready) != 0)
+        {
+            // Interrupted by a signal, wait again
+        }
+        while(!AD5933_QueuePop(&pipeline->readyFrames, &value))
+        {
+            // Drained: the wake-up was a stop request, posted after the
+            // last frame. Otherwise a frame of an earlier position is still
+            // being pushed by another acquisition thread.
+            if(atomic_load_explicit(&pipeline->stopping, memory_order_acquire))
+            {
+                return 0;
+            }
+            sched_yield();
+        }
+        frame            = (AD5933_Frame *)value;
+        cal              = (frame->channel < pipeline->channels) ?
+                           pipeline->calibrations[frame->channel] : 0;
+        frame->converted = (cal != 0);
+        if(cal != 0)
+        {
+            AD5933_ApplyCalibrationAt(cal, &frame->sweep, frame->startFreq,
+                                      frame->incFreq, frame->temperature,
+                                      frame->impedance, frame->phase);
+        }
+        if(pipeline->handler != 0)
+        {
+            pipeline->handler(pipeline->context, frame);
+        }
+        atomic_fetch_add_explicit(&pipeline->processed, 1, memory_order_relaxed);
+        AD5933_QueuePush(&pipeline->freeFrames, frame);
+    }
+}
+
+/***************************************************************************//**
+ * @brief Starts the worker threads.
+ *
+ * @param pipeline - Initialized pipeline.
+ * @param workers  - Number of workers, at most AD5933_PIPELINE_MAX_WORKERS.
+ *
+ * @return false if a thread could not be created; the workers already
+ *         running keep working and are stopped by AD5933_PipelineStop.
+*******************************************************************************/
+bool AD5933_PipelineStart(AD5933_Pipeline *pipeline, unsigned char workers)
+{
+    workers = (workers > AD5933_PIPELINE_MAX_WORKERS) ?
+              AD5933_PIPELINE_MAX_WORKERS : workers;
+    while(pipeline->workerCount < workers)
+    {
+        if(pthread_create(&pipeline->workers[pipeline->workerCount], 0,
+                          AD5933_PipelineWorker, pipeline) != 0)
+        {
+            return false;
+        }
+        pipeline->workerCount++;
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Takes a free frame for an acquisition. Never blocks: when every
+ *        frame is waiting for or in a worker the claim fails and is counted
+ *        as an overrun, so the acquisition thread can decide to retry or
+ *        skip the sweep.
+ *
+ * @param pipeline - Pipeline.
+ *
+ * @return Frame to fill, or NULL if none is free.
+*******************************************************************************/
+AD5933_Frame *AD5933_PipelineClaim(AD5933_Pipeline *pipeline)
+{
+    void *value = 0;
+
+    if(!AD5933_QueuePop(&pipeline->freeFrames, &value))
+    {
+        atomic_fetch_add_explicit(&pipeline->overruns, 1, memory_order_relaxed);
+        return 0;
+    }
+
+    return (AD5933_Frame *)value;
+}
+
+/***************************************************************************//**
+ * @brief Hands a filled frame over to the workers. Numbers and timestamps
+ *        the frame; the rest of the metadata is up to the caller.
+ *
+ * @param pipeline - Pipeline.
+ * @param frame    - Frame claimed with AD5933_PipelineClaim.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_PipelinePublish(AD5933_Pipeline *pipeline, AD5933_Frame *frame)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    frame->timestampNs = (unsigned long long)now.tv_sec * 1000000000ull +
+                         now.tv_nsec;
+    frame->sequence    = atomic_fetch_add_explicit(&pipeline->published, 1,
+                                                   memory_order_relaxed);
+    // Every frame fits: the queue holds as many cells as there are frames
+    AD5933_QueuePush(&pipeline->readyFrames, frame);
+    sem_post(&pipeline->ready);
+}
+
+/***************************************************************************//**
+ * @brief Returns a claimed frame unused, e.g. after a failed acquisition.
+ *
+ * @param pipeline - Pipeline.
+ * @param frame    - Frame claimed with AD5933_PipelineClaim.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_PipelineRelease(AD5933_Pipeline *pipeline, AD5933_Frame *frame)
+{
+    AD5933_QueuePush(&pipeline->freeFrames, frame);
+}
+
+/***************************************************************************//**
+ * @brief Runs a sweep of the configured grid into a free frame and hands it
+ *        over to the workers. The acquisition thread only does bus work;
+ *        the conversion runs on the workers while it starts the next sweep.
+ *
+ * @param pipeline    - Pipeline.
+ * @param dev         - Device context, configured for the sweep.
+ * @param channel     - Channel of the sweep (index of its calibration).
+ * @param startFreq   - Start frequency of the configured grid (Hz).
+ * @param incFreq     - Frequency increment of the configured grid (Hz).
+ * @param temperature - Die temperature (C), NAN if unknown.
+ *
+ * @return false if no frame was free or the sweep failed.
+*******************************************************************************/
+bool AD5933_PipelineSweep(AD5933_Pipeline *pipeline,
+                          AD5933_Device *dev,
+                          unsigned short channel,
+                          unsigned long startFreq,
+                          unsigned long incFreq,
+                          float temperature)
+{
+    AD5933_Frame *frame = AD5933_PipelineClaim(pipeline);
+
+    if(frame == 0)
+    {
+        return false;
+    }
+    if(!AD5933_RunSweep(dev, &frame->sweep))
+    {
+        AD5933_PipelineRelease(pipeline, frame);
+        return false;
+    }
+    frame->channel     = channel;
+    frame->startFreq   = startFreq;
+    frame->incFreq     = incFreq;
+    frame->temperature = temperature;
+    AD5933_PipelinePublish(pipeline, frame);
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Lets the workers process every published frame, then stops and
+ *        joins them. Call it once the acquisition threads have stopped
+ *        publishing.
+ *
+ * @param pipeline - Pipeline.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_PipelineStop(AD5933_Pipeline *pipeline)
+{
+    unsigned char worker = 0;
+
+    atomic_store_explicit(&pipeline->stopping, true, memory_order_release);
+    // One wake-up per worker after the frames: each finds the queue drained
+    for(worker = 0; worker < pipeline->workerCount; worker++)
+    {
+        sem_post(&pipeline->ready);
+    }
+    for(worker = 0; worker < pipeline->workerCount; worker++)
+    {
+        pthread_join(pipeline->workers[worker], 0);
+    }
+    pipeline->workerCount = 0;
+    sem_destroy(&pipeline->ready);
+}
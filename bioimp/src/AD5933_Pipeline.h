@@ -0,0 +1,106 @@
+/***************************************************************************//**
+ *   @file   AD5933_Pipeline.h
+ *   @brief  Hand-off of raw sweep frames from the acquisition threads to a
+ *           pool of processing workers through lock-free queues.
+*******************************************************************************/
+
+#ifndef __AD5933_PIPELINE_H__
+#define __AD5933_PIPELINE_H__
+
+#include "stdbool.h"
+#include "stdatomic.h"
+#include "pthread.h"
+#include "semaphore.h"
+#include "AD5933.h"
+#include "AD5933_Calibration.h"
+#include "AD5933_Queue.h"
+
+/******************************************************************************/
+/************************** Pipeline Definitions ******************************/
+/******************************************************************************/
+
+#define AD5933_PIPELINE_MAX_WORKERS 16      // Worker threads of a pipeline
+
+/******************************************************************************/
+/**************************** Pipeline Types **********************************/
+/******************************************************************************/
+
+/* One sweep and its metadata. Raw data is written by the acquisition
+   thread; impedance and phase by the worker that processes the frame. */
+typedef struct {
+    unsigned short     channel;                     // Front-end of the sweep
+    unsigned long      sequence;                    // Publication number
+    unsigned long long timestampNs;                 // End of the acquisition
+                                                    // (CLOCK_MONOTONIC)
+    float              temperature;                 // Die temperature (C),
+                                                    // NAN if unknown
+    unsigned long      startFreq;                   // Frequency of point 0 (Hz)
+    unsigned long      incFreq;                     // Step between points (Hz)
+    AD5933_SweepBuffer sweep;                       // Over realData, imagData
+    signed short       realData[AD5933_MAX_POINTS]; // Raw real data
+    signed short       imagData[AD5933_MAX_POINTS]; // Raw imaginary data
+    bool               converted;                   // impedance and phase valid
+    float              impedance[AD5933_MAX_POINTS];    // Impedance (ohms)
+    float              phase[AD5933_MAX_POINTS];    // Phase (radians)
+} AD5933_Frame;
+
+/* Last stage of the workers (fitting, storage), run on each frame. */
+typedef void (*AD5933_FrameHandler)(void *context, AD5933_Frame *frame);
+
+/* Frames circulate from freeFrames to the acquisition thread, to
+   readyFrames, to a worker and back to freeFrames. */
+typedef struct {
+    AD5933_Queue        freeFrames;     // Frames to fill
+    AD5933_Queue        readyFrames;    // Frames to process
+    sem_t               ready;          // Frames (or stop requests) waiting
+    pthread_t           workers[AD5933_PIPELINE_MAX_WORKERS];
+    unsigned char       workerCount;    // Workers running
+    const AD5933_Calibration *const *calibrations;  // One per channel, NULL
+                                        // entries are not converted
+    unsigned short      channels;       // Entries in calibrations
+    AD5933_FrameHandler handler;        // Last stage, NULL = none
+    void               *context;        // Argument of handler
+    atomic_bool         stopping;       // Workers exit once drained
+    atomic_ulong        published;      // Frames published
+    atomic_ulong        processed;      // Frames processed
+    atomic_ulong        overruns;       // Claims without a free frame
+} AD5933_Pipeline;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Initializes a pipeline over caller-owned frames and queue cells. */
+bool AD5933_PipelineInit(AD5933_Pipeline *pipeline,
+                         AD5933_Frame *frames,
+                         AD5933_QueueCell *cells,
+                         unsigned long capacity,
+                         const AD5933_Calibration *const *calibrations,
+                         unsigned short channels,
+                         AD5933_FrameHandler handler,
+                         void *context);
+
+/*! Starts the worker threads. */
+bool AD5933_PipelineStart(AD5933_Pipeline *pipeline, unsigned char workers);
+
+/*! Takes a free frame for an acquisition, NULL if none is free. */
+AD5933_Frame *AD5933_PipelineClaim(AD5933_Pipeline *pipeline);
+
+/*! Hands a filled frame over to the workers. */
+void AD5933_PipelinePublish(AD5933_Pipeline *pipeline, AD5933_Frame *frame);
+
+/*! Returns a claimed frame unused. */
+void AD5933_PipelineRelease(AD5933_Pipeline *pipeline, AD5933_Frame *frame);
+
+/*! Runs a sweep into a free frame and hands it over to the workers. */
+bool AD5933_PipelineSweep(AD5933_Pipeline *pipeline,
+                          AD5933_Device *dev,
+                          unsigned short channel,
+                          unsigned long startFreq,
+                          unsigned long incFreq,
+                          float temperature);
+
+/*! Lets the workers process every published frame, then stops them. */
+void AD5933_PipelineStop(AD5933_Pipeline *pipeline);
+
+#endif /* __AD5933_PIPELINE_H__ */
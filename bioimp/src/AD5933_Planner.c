@@ -0,0 +1,240 @@
+/***************************************************************************//**
+ *   @file   AD5933_Planner.c
+ *   @brief  Splits an arbitrary list of frequencies into hardware sweeps and
+ *           runs them back to back.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Planner.h"
+#include "math.h"
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Chooses the system clock of a frequency. The internal clock is kept
+ *        while its DFT window spans minDftPeriods of the frequency; below
+ *        that a slower external clock, if any and able to reach the
+ *        frequency, gives a longer window.
+ *
+ * @param frequency - Frequency in Hz.
+ * @param config    - Planner configuration.
+ * @param sysClk    - Clock frequency chosen (Hz).
+ *
+ * @return AD5933_CONTROL_INT_SYSCLK or AD5933_CONTROL_EXT_SYSCLK.
+*******************************************************************************/
+static unsigned char AD5933_PlanClock(unsigned long frequency,
+                                      const AD5933_PlannerConfig *config,
+                                      unsigned long *sysClk)
+{
+    double periods = (double)frequency * AD5933_DFT_SAMPLES *
+                     AD5933_ADC_DIVIDER / AD5933_INTERNAL_SYS_CLK;
+
+    if((periods < config->minDftPeriods) && (config->extClk != 0) &&
+       (config->extClk < AD5933_INTERNAL_SYS_CLK) &&
+       (AD5933_FREQ_CODE(frequency, config->extClk) <= AD5933_FREQ_CODE_MAX))
+    {
+        *sysClk = config->extClk;
+        return AD5933_CONTROL_EXT_SYSCLK;
+    }
+    *sysClk = AD5933_INTERNAL_SYS_CLK;
+
+    return AD5933_CONTROL_INT_SYSCLK;
+}
+
+/***************************************************************************//**
+ * @brief Returns the settling cycles a frequency needs: the tuned cycles of
+ *        its band if the configuration has a settling table, otherwise the
+ *        cycles that last settlingTime.
+ *
+ * @param config    - Planner configuration.
+ * @param frequency - Frequency in Hz.
+ *
+ * @return Settling cycles, at least minSettlingCycles.
+*******************************************************************************/
+static unsigned long AD5933_PlanSettling(const AD5933_PlannerConfig *config,
+                                         unsigned long frequency)
+{
+    double        wanted = ceil(config->settlingTime * frequency);
+    unsigned long cycles = (wanted > 4 * AD5933_MAX_SETTLING_CYCLES) ?
+                           4 * AD5933_MAX_SETTLING_CYCLES : (unsigned long)wanted;
+
+    if(config->settlingTable != 0)
+    {
+        cycles = AD5933_GetTunedSettling(config->settlingTable, frequency);
+    }
+
+    return (cycles < config->minSettlingCycles) ? config->minSettlingCycles :
+                                                  cycles;
+}
+
+/***************************************************************************//**
+ * @brief Splits a list of frequencies into the fewest hardware sweeps. From
+ *        the first frequency not yet planned, a segment grows while one
+ *        integer increment code keeps every point within the tolerance of
+ *        its frequency, the clock stays the same and the segment has at
+ *        most AD5933_MAX_POINTS points. Any order and spacing is accepted
+ *        (log spacing, more than 512 points); only ascending runs share a
+ *        segment. Each segment gets its clock and the settling cycles of
+ *        its most demanding frequency.
+ *
+ * @param frequencies - Frequencies in Hz, in the order the results are wanted.
+ * @param count       - Number of frequencies.
+ * @param config      - Planner configuration.
+ * @param plan        - Caller-owned plan to fill.
+ *
+ * @return false if the plan has not enough segments for the list.
+*******************************************************************************/
+bool AD5933_PlanSweep(const unsigned long *frequencies,
+                      unsigned short count,
+                      const AD5933_PlannerConfig *config,
+                      AD5933_SweepPlan *plan)
+{
+    AD5933_SweepSegment *segment   = 0;
+    unsigned char        source    = 0;
+    unsigned long        sysClk    = 0;
+    unsigned long        other     = 0;
+    unsigned long        startCode = 0;
+    unsigned long        code      = 0;
+    unsigned long        settling  = 0;
+    unsigned long        incCode   = 0;
+    unsigned short       first     = 0;
+    unsigned short       points    = 0;
+    unsigned short       settlingReg = 0;
+    double               low       = 0;
+    double               high      = 0;
+    double               slack     = 0;
+    double               lower     = 0;
+    double               upper     = 0;
+
+    plan->count  = 0;
+    plan->points = 0;
+    while(first < count)
+    {
+        if(plan->count == plan->capacity)
+        {
+            return false;
+        }
+        source    = AD5933_PlanClock(frequencies[first], config, &sysClk);
+        startCode = AD5933_FrequencyToCode(frequencies[first], sysClk);
+        settling  = AD5933_PlanSettling(config, frequencies[first]);
+        low       = 1;
+        high      = AD5933_FREQ_CODE_MAX;
+        for(points = 1; (first + points < count) &&
+                        (points < AD5933_MAX_POINTS); points++)
+        {
+            if(AD5933_PlanClock(frequencies[first + points], config,
+                                &other) != source)
+            {
+                break;
+            }
+            code  = AD5933_FrequencyToCode(frequencies[first + points], sysClk);
+            slack = config->tolerance * code;
+            slack = (slack < 0.5) ? 0.5 : slack;
+            lower = (code - slack - (double)startCode) / points;
+            upper = (code + slack - (double)startCode) / points;
+            lower = (lower > low) ? lower : low;
+            upper = (upper < high) ? upper : high;
+            if(ceil(lower) > floor(upper))
+            {
+                break;
+            }
+            low     = lower;
+            high    = upper;
+            incCode = (unsigned long)((code - (double)startCode) / points + 0.5);
+            code    = AD5933_PlanSettling(config, frequencies[first + points]);
+            settling = (code > settling) ? code : settling;
+        }
+        // The increment that best fits the last point, inside the range
+        incCode  = (points == 1) ? 0 :
+                   (incCode < ceil(low)) ? (unsigned long)ceil(low) :
+                   (incCode > floor(high)) ? (unsigned long)floor(high) : incCode;
+        settlingReg = AD5933_EncodeSettlingCycles(settling);
+        segment  = &plan->segments[plan->count++];
+        AD5933_CompileCodeProfile(&segment->profile, startCode, incCode,
+                                  points - 1, settlingReg, sysClk);
+        segment->clockSource      = source;
+        segment->first            = first;
+        segment->points           = points;
+        plan->points             += points;
+        first                    += points;
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Runs every segment of a plan back to back: the segments on the
+ *        current clock first, then the rest after a single clock switch.
+ *        Each segment costs one profile block write and its sweep. The
+ *        results land at the position of their frequencies in the list.
+ *        The clock of the device is restored at the end.
+ *
+ * @param dev         - Device context.
+ * @param plan        - Plan built by AD5933_PlanSweep.
+ * @param buffer      - Caller-owned buffer with room for plan->points.
+ * @param frequencies - Frequency actually measured at each point (mHz), with
+ *                      room for plan->points entries; NULL if not needed.
+ *
+ * @return false on a bus error, a timeout or a buffer too small;
+ *         buffer->count holds the points of the plan measured so far.
+*******************************************************************************/
+bool AD5933_RunPlan(AD5933_Device *dev,
+                    const AD5933_SweepPlan *plan,
+                    AD5933_SweepBuffer *buffer,
+                    unsigned long *frequencies)
+{
+    const AD5933_SweepSegment *segment = 0;
+    AD5933_SweepBuffer         part    = {0, 0, 0, 0};
+    unsigned char              source  = dev->clockSource;
+    unsigned long              sysClk  = dev->sysClk;
+    unsigned char              pass    = 0;
+    unsigned short             index   = 0;
+    unsigned short             point   = 0;
+    bool                       result  = true;
+
+    buffer->count = 0;
+    if((plan->points > buffer->capacity) || (buffer->realData == 0) ||
+       (buffer->imagData == 0))
+    {
+        return false;
+    }
+    for(pass = 0; result && (pass < 2); pass++)
+    {
+        for(index = 0; result && (index < plan->count); index++)
+        {
+            segment = &plan->segments[index];
+            if((segment->clockSource == source) != (pass == 0))
+            {
+                continue;
+            }
+            if((segment->clockSource != dev->clockSource) ||
+               (segment->profile.sysClk != dev->sysClk))
+            {
+                AD5933_SetSystemClk(dev, segment->clockSource,
+                                    segment->profile.sysClk);
+            }
+            part.realData = &buffer->realData[segment->first];
+            part.imagData = &buffer->imagData[segment->first];
+            part.capacity = segment->points;
+            result = AD5933_LoadSweepProfile(dev, &segment->profile) &&
+                     AD5933_RunSweep(dev, &part) &&
+                     (part.count == segment->points);
+            buffer->count += part.count;
+            for(point = 0; (frequencies != 0) && (point < part.count); point++)
+            {
+                frequencies[segment->first + point] =
+                    AD5933_GetPointFrequency(&segment->profile, point);
+            }
+        }
+    }
+    if((source != dev->clockSource) || (sysClk != dev->sysClk))
+    {
+        AD5933_SetSystemClk(dev, source, sysClk);
+    }
+
+    return result;
+}
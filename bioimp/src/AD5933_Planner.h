@@ -0,0 +1,63 @@
+/***************************************************************************//**
+ *   @file   AD5933_Planner.h
+ *   @brief  Splits an arbitrary list of frequencies into hardware sweeps and
+ *           runs them back to back.
+*******************************************************************************/
+
+#ifndef __AD5933_PLANNER_H__
+#define __AD5933_PLANNER_H__
+
+#include "stdbool.h"
+#include "AD5933.h"
+#include "AD5933_Settling.h"
+
+/******************************************************************************/
+/**************************** Planner Types ***********************************/
+/******************************************************************************/
+
+/* How the list of frequencies may be turned into hardware sweeps */
+typedef struct {
+    unsigned long  extClk;              // External clock (Hz), 0 = none
+    float          tolerance;           // Relative deviation allowed from
+                                        // each frequency (0 = exact codes)
+    float          minDftPeriods;       // Periods the DFT window must span
+                                        // before the slower clock is used
+    float          settlingTime;        // Settling time of each point (s)
+    unsigned short minSettlingCycles;   // Settling cycles at least
+    const AD5933_SettlingTable *settlingTable;  // Tuned settling cycles used
+                                        // instead of settlingTime, NULL = none
+} AD5933_PlannerConfig;
+
+/* One hardware sweep of the plan */
+typedef struct {
+    AD5933_SweepProfile profile;        // Codes, settling and clock
+    unsigned char       clockSource;    // AD5933_CONTROL_INT/EXT_SYSCLK
+    unsigned short      first;          // First frequency of the list
+    unsigned short      points;         // Frequencies covered
+} AD5933_SweepSegment;
+
+/* Caller-owned list of segments */
+typedef struct {
+    AD5933_SweepSegment *segments;      // Segments of the plan
+    unsigned short       capacity;      // Number of entries in segments
+    unsigned short       count;         // Segments used
+    unsigned short       points;        // Frequencies covered by the plan
+} AD5933_SweepPlan;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Splits a list of frequencies into the fewest hardware sweeps. */
+bool AD5933_PlanSweep(const unsigned long *frequencies,
+                      unsigned short count,
+                      const AD5933_PlannerConfig *config,
+                      AD5933_SweepPlan *plan);
+
+/*! Runs every segment of a plan and merges the results in list order. */
+bool AD5933_RunPlan(AD5933_Device *dev,
+                    const AD5933_SweepPlan *plan,
+                    AD5933_SweepBuffer *buffer,
+                    unsigned long *frequencies);
+
+#endif /* __AD5933_PLANNER_H__ */
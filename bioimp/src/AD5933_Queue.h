@@ -0,0 +1,163 @@
+/***************************************************************************//**
+ *   @file   AD5933_Queue.h
+ *   @brief  Bounded lock-free multiple producer / multiple consumer queue of
+ *           pointers, used to hand frames between threads.
+*******************************************************************************/
+
+#ifndef __AD5933_QUEUE_H__
+#define __AD5933_QUEUE_H__
+
+#include "stdbool.h"
+#include "stdatomic.h"
+
+/******************************************************************************/
+/***************************** Queue Types ************************************/
+/******************************************************************************/
+
+/* One slot. Its sequence tells whose turn it is: equal to the position for
+   the producer of that position, position + 1 for its consumer. */
+typedef struct {
+    atomic_ulong  sequence;         // Turn of the slot
+    void         *value;            // Pointer stored
+} AD5933_QueueCell;
+
+/* Queue over caller-owned cells. capacity must be a power of 2. head and
+   tail count positions and never wrap back. */
+typedef struct {
+    AD5933_QueueCell *cells;        // capacity cells
+    unsigned long     capacity;     // Number of cells (power of 2)
+    atomic_ulong      head;         // Next position to push
+    atomic_ulong      tail;         // Next position to pop
+} AD5933_Queue;
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Initializes an empty queue over caller-owned cells.
+ *
+ * @param queue    - Queue to initialize.
+ * @param cells    - Storage for capacity cells.
+ * @param capacity - Number of cells, power of 2.
+ *
+ * @return false if capacity is not a power of 2.
+*******************************************************************************/
+static inline bool AD5933_QueueInit(AD5933_Queue *queue,
+                                    AD5933_QueueCell *cells,
+                                    unsigned long capacity)
+{
+    unsigned long index = 0;
+    
+    if((capacity == 0) || ((capacity & (capacity - 1)) != 0))
+    {
+        return false;
+    }
+    for(index = 0; index < capacity; index++)
+    {
+        atomic_init(&cells[index].sequence, index);
+        cells[index].value = 0;
+    }
+    queue->cells    = cells;
+    queue->capacity = capacity;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Stores a pointer. Any thread may call it; producers only contend
+ *        on the head position, never on a lock.
+ *
+ * @param queue - Queue.
+ * @param value - Pointer to store.
+ *
+ * @return false if the queue was full.
+*******************************************************************************/
+static inline bool AD5933_QueuePush(AD5933_Queue *queue, void *value)
+{
+    unsigned long     position = atomic_load_explicit(&queue->head,
+                                                      memory_order_relaxed);
+    AD5933_QueueCell *cell     = 0;
+    long              turn     = 0;
+    
+    while(true)
+    {
+        cell = &queue->cells[position & (queue->capacity - 1)];
+        turn = (long)(atomic_load_explicit(&cell->sequence,
+                                           memory_order_acquire) - position);
+        if(turn == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&queue->head, &position,
+                                                     position + 1,
+                                                     memory_order_relaxed,
+                                                     memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(turn < 0)
+        {
+            // The consumer of the previous lap has not freed the cell
+            return false;
+        }
+        else
+        {
+            position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+    cell->value = value;
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Takes the oldest pointer. Any thread may call it.
+ *
+ * @param queue - Queue.
+ * @param value - Pointer taken.
+ *
+ * @return false if the queue was empty.
+*******************************************************************************/
+static inline bool AD5933_QueuePop(AD5933_Queue *queue, void **value)
+{
+    unsigned long     position = atomic_load_explicit(&queue->tail,
+                                                      memory_order_relaxed);
+    AD5933_QueueCell *cell     = 0;
+    long              turn     = 0;
+    
+    while(true)
+    {
+        cell = &queue->cells[position & (queue->capacity - 1)];
+        turn = (long)(atomic_load_explicit(&cell->sequence,
+                                           memory_order_acquire) - (position + 1));
+        if(turn == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&queue->tail, &position,
+                                                     position + 1,
+                                                     memory_order_relaxed,
+                                                     memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(turn < 0)
+        {
+            // The producer of this position has not stored it yet
+            return false;
+        }
+        else
+        {
+            position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+    *value = cell->value;
+    atomic_store_explicit(&cell->sequence, position + queue->capacity,
+                          memory_order_release);
+    
+    return true;
+}
+
+#endif /* __AD5933_QUEUE_H__ */
@@ -0,0 +1,127 @@
+/***************************************************************************//**
+ *   @file   AD5933_Ring.h
+ *   @brief  Lock-free single producer / single consumer ring of fixed-size
+ *           slots, shared by the log and the streaming outputs.
+*******************************************************************************/
+
+#ifndef __AD5933_RING_H__
+#define __AD5933_RING_H__
+
+#include "stdbool.h"
+#include "stdatomic.h"
+#include "string.h"
+
+/******************************************************************************/
+/****************************** Ring Types ************************************/
+/******************************************************************************/
+
+/* Ring over caller-owned storage of capacity slots of slotSize bytes.
+   capacity must be a power of 2. head and tail count slots and never wrap
+   back, so full and empty are told apart without a spare slot. */
+typedef struct {
+    unsigned char         *slots;       // capacity * slotSize bytes
+    unsigned short         slotSize;    // Bytes per slot
+    unsigned long          capacity;    // Number of slots (power of 2)
+    atomic_ulong           head;        // Next slot to write (producer)
+    atomic_ulong           tail;        // Next slot to read (consumer)
+    atomic_ulong           dropped;     // Pushes lost because it was full
+} AD5933_Ring;
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Initializes an empty ring over caller-owned storage.
+ *
+ * @param ring     - Ring to initialize.
+ * @param storage  - capacity * slotSize bytes.
+ * @param slotSize - Bytes per slot.
+ * @param capacity - Number of slots, power of 2.
+ *
+ * @return false if capacity is not a power of 2.
+*******************************************************************************/
+static inline bool AD5933_RingInit(AD5933_Ring *ring,
+                                   void *storage,
+                                   unsigned short slotSize,
+                                   unsigned long capacity)
+{
+    if((capacity == 0) || ((capacity & (capacity - 1)) != 0))
+    {
+        return false;
+    }
+    ring->slots    = (unsigned char *)storage;
+    ring->slotSize = slotSize;
+    ring->capacity = capacity;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Copies one slot into the ring. Only the producer thread may call it.
+ *        Never blocks: when the ring is full the slot is dropped and counted.
+ *
+ * @param ring - Ring.
+ * @param slot - slotSize bytes to copy.
+ *
+ * @return false if the ring was full.
+*******************************************************************************/
+static inline bool AD5933_RingPush(AD5933_Ring *ring, const void *slot)
+{
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned long tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    
+    if(head - tail >= ring->capacity)
+    {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    memcpy(&ring->slots[(head & (ring->capacity - 1)) * ring->slotSize],
+           slot, ring->slotSize);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Copies the oldest slot out of the ring. Only the consumer thread may
+ *        call it.
+ *
+ * @param ring - Ring.
+ * @param slot - Buffer of slotSize bytes.
+ *
+ * @return false if the ring was empty.
+*******************************************************************************/
+static inline bool AD5933_RingPop(AD5933_Ring *ring, void *slot)
+{
+    unsigned long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    
+    if(head == tail)
+    {
+        return false;
+    }
+    memcpy(slot, &ring->slots[(tail & (ring->capacity - 1)) * ring->slotSize],
+           ring->slotSize);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Number of slots waiting to be popped.
+ *
+ * @param ring - Ring.
+ *
+ * @return Slots in the ring.
+*******************************************************************************/
+static inline unsigned long AD5933_RingCount(AD5933_Ring *ring)
+{
+    return atomic_load_explicit(&ring->head, memory_order_acquire) -
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+#endif /* __AD5933_RING_H__ */
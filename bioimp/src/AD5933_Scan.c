@@ -0,0 +1,236 @@
+/***************************************************************************//**
+ *   @file   AD5933_Scan.c
+ *   @brief  Scan of multiplexed electrode channels over one or more devices,
+ *           overlapping the conversions of a device with the bus traffic of
+ *           the others.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Scan.h"
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Describes a scan. Each channel is measured with the sweep profile
+ *        on its device and its raw data goes to its own buffer.
+ *
+ * @param scan         - Scan to initialize.
+ * @param devices      - Initialized device contexts.
+ * @param deviceCount  - Number of devices (AD5933_SCAN_MAX_DEVICES at most).
+ * @param channels     - Channels in the order they should be measured.
+ * @param channelCount - Number of channels.
+ * @param results      - One buffer per channel.
+ * @param profile      - Sweep of every channel.
+ * @param select       - Multiplexer control.
+ * @param context      - Argument of select.
+ *
+ * @return false if there are too many devices or a channel has none.
+*******************************************************************************/
+bool AD5933_InitScan(AD5933_Scan *scan,
+                     AD5933_Device * const *devices,
+                     unsigned char deviceCount,
+                     const AD5933_ScanChannel *channels,
+                     unsigned short channelCount,
+                     AD5933_SweepBuffer *results,
+                     const AD5933_SweepProfile *profile,
+                     AD5933_MuxSelect select,
+                     void *context)
+{
+    unsigned short channel = 0;
+
+    if((deviceCount == 0) || (deviceCount > AD5933_SCAN_MAX_DEVICES) ||
+       (channelCount == AD5933_SCAN_IDLE))
+    {
+        return false;
+    }
+    for(channel = 0; channel < channelCount; channel++)
+    {
+        if(channels[channel].device >= deviceCount)
+        {
+            return false;
+        }
+    }
+    scan->devices      = devices;
+    scan->deviceCount  = deviceCount;
+    scan->channels     = channels;
+    scan->channelCount = channelCount;
+    scan->results      = results;
+    scan->profile      = profile;
+    scan->select       = select;
+    scan->context      = context;
+    scan->done         = 0;
+    scan->failed       = 0;
+    scan->startUs      = 0;
+    scan->endUs        = 0;
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Starts the next channel of a device: switches the multiplexer and
+ *        starts the sweep. Channels that cannot be started are counted as
+ *        failed and skipped.
+ *
+ * @param scan   - Scan.
+ * @param device - Index of the device.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_StartNextChannel(AD5933_Scan *scan, unsigned char device)
+{
+    unsigned short channel = 0;
+
+    scan->active[device] = AD5933_SCAN_IDLE;
+    for(channel = scan->cursor[device]; channel < scan->channelCount; channel++)
+    {
+        if(scan->channels[channel].device != device)
+        {
+            continue;
+        }
+        scan->results[channel].count = 0;
+        if(((scan->select != 0) &&
+            !scan->select(scan->context, device, scan->channels[channel].mux)) ||
+           !AD5933_BeginSweep(scan->devices[device]))
+        {
+            scan->failed++;
+            continue;
+        }
+        scan->active[device] = channel;
+        break;
+    }
+    scan->cursor[device] = (channel < scan->channelCount) ? channel + 1 : channel;
+}
+
+/***************************************************************************//**
+ * @brief Loads the sweep into every device and starts the first channel of
+ *        each one.
+ *
+ * @param scan  - Scan.
+ * @param nowUs - Current time in us.
+ *
+ * @return false if a device did not take the profile.
+*******************************************************************************/
+bool AD5933_StartScan(AD5933_Scan *scan, unsigned long long nowUs)
+{
+    unsigned char device = 0;
+    bool          result = true;
+
+    scan->done    = 0;
+    scan->failed  = 0;
+    scan->startUs = nowUs;
+    scan->endUs   = nowUs;
+    for(device = 0; device < scan->deviceCount; device++)
+    {
+        scan->cursor[device] = 0;
+        scan->active[device] = AD5933_SCAN_IDLE;
+        result &= AD5933_LoadSweepProfile(scan->devices[device], scan->profile);
+    }
+    if(!result)
+    {
+        return false;
+    }
+    for(device = 0; device < scan->deviceCount; device++)
+    {
+        AD5933_StartNextChannel(scan, device);
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Polls every busy device once, round robin. A device whose point is
+ *        ready gets its next command right away (next frequency, or the
+ *        next channel once the sweep is done), so its settling and DFT run
+ *        while the other devices are polled and read. Call it until it
+ *        returns false; the caller may sleep between calls.
+ *
+ * @param scan  - Scan started with AD5933_StartScan.
+ * @param nowUs - Current time in us.
+ *
+ * @return true while channels remain.
+*******************************************************************************/
+bool AD5933_ScanStep(AD5933_Scan *scan, unsigned long long nowUs)
+{
+    AD5933_Device      *dev     = 0;
+    AD5933_SweepBuffer *buffer  = 0;
+    AD5933_PollResult   result  = AD5933_POLL_PENDING;
+    unsigned char       device  = 0;
+    unsigned char       status  = 0;
+    bool                busy    = false;
+    signed short        real    = 0;
+    signed short        imag    = 0;
+
+    for(device = 0; device < scan->deviceCount; device++)
+    {
+        if(scan->active[device] == AD5933_SCAN_IDLE)
+        {
+            continue;
+        }
+        dev    = scan->devices[device];
+        buffer = &scan->results[scan->active[device]];
+        result = AD5933_Poll(dev);
+        if(result == AD5933_POLL_PENDING)
+        {
+            busy = true;
+            continue;
+        }
+        if(result == AD5933_POLL_READY)
+        {
+            AD5933_CollectData(dev, &real, &imag, &status);
+            if(buffer->count < buffer->capacity)
+            {
+                buffer->realData[buffer->count] = real;
+                buffer->imagData[buffer->count] = imag;
+                buffer->count++;
+            }
+            if(!(status & AD5933_STAT_SWEEP_DONE) &&
+               (buffer->count < buffer->capacity))
+            {
+                if(AD5933_BeginPoint(dev, AD5933_FUNCTION_INC_FREQ))
+                {
+                    busy = true;
+                    continue;
+                }
+                result = AD5933_POLL_ERROR;
+            }
+        }
+        if(result == AD5933_POLL_READY)
+        {
+            scan->done++;
+        }
+        else
+        {
+            scan->failed++;
+        }
+        AD5933_StartNextChannel(scan, device);
+        busy |= (scan->active[device] != AD5933_SCAN_IDLE);
+    }
+    if(!busy)
+    {
+        scan->endUs = nowUs;
+    }
+
+    return busy;
+}
+
+/***************************************************************************//**
+ * @brief Returns the throughput of the last scan: channels measured per
+ *        second between AD5933_StartScan and the step that finished it.
+ *
+ * @param scan - Scan.
+ *
+ * @return Channels per second, 0 if the scan took no time.
+*******************************************************************************/
+float AD5933_GetScanRate(const AD5933_Scan *scan)
+{
+    if(scan->endUs <= scan->startUs)
+    {
+        return 0;
+    }
+
+    return (float)(scan->done * 1e6 / (double)(scan->endUs - scan->startUs));
+}
@@ -0,0 +1,79 @@
+/***************************************************************************//**
+ *   @file   AD5933_Scan.h
+ *   @brief  Scan of multiplexed electrode channels over one or more devices,
+ *           overlapping the conversions of a device with the bus traffic of
+ *           the others.
+*******************************************************************************/
+
+#ifndef __AD5933_SCAN_H__
+#define __AD5933_SCAN_H__
+
+#include "stdbool.h"
+#include "AD5933.h"
+
+/******************************************************************************/
+/**************************** Scan Definitions ********************************/
+/******************************************************************************/
+
+#define AD5933_SCAN_MAX_DEVICES     8       // Devices of one scan
+#define AD5933_SCAN_IDLE            0xFFFF  // Device without a channel
+
+/******************************************************************************/
+/****************************** Scan Types ************************************/
+/******************************************************************************/
+
+/* One electrode pair: the device it is measured with and the multiplexer
+   setting that connects it. */
+typedef struct {
+    unsigned char  device;          // Index in the device list of the scan
+    unsigned short mux;             // Multiplexer setting
+} AD5933_ScanChannel;
+
+/* Connects a channel to the input of a device; false skips the channel. */
+typedef bool (*AD5933_MuxSelect)(void *context,
+                                 unsigned char device,
+                                 unsigned short mux);
+
+/* A scan and its progress. Times are in the caller's microsecond clock. */
+typedef struct {
+    AD5933_Device * const    *devices;      // Devices of the scan
+    unsigned char             deviceCount;  // Number of devices
+    const AD5933_ScanChannel *channels;     // Channels, in scan order
+    unsigned short            channelCount; // Number of channels
+    AD5933_SweepBuffer       *results;      // One buffer per channel
+    const AD5933_SweepProfile *profile;     // Sweep of every channel
+    AD5933_MuxSelect          select;       // Multiplexer control
+    void                     *context;      // Argument of select
+    unsigned short active[AD5933_SCAN_MAX_DEVICES];  // Channel of each device
+    unsigned short cursor[AD5933_SCAN_MAX_DEVICES];  // Next channel to look at
+    unsigned short            done;         // Channels measured
+    unsigned short            failed;       // Channels skipped or failed
+    unsigned long long        startUs;      // Start of the scan
+    unsigned long long        endUs;        // End of the scan
+} AD5933_Scan;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Describes a scan. */
+bool AD5933_InitScan(AD5933_Scan *scan,
+                     AD5933_Device * const *devices,
+                     unsigned char deviceCount,
+                     const AD5933_ScanChannel *channels,
+                     unsigned short channelCount,
+                     AD5933_SweepBuffer *results,
+                     const AD5933_SweepProfile *profile,
+                     AD5933_MuxSelect select,
+                     void *context);
+
+/*! Loads the sweep into every device and starts the first channels. */
+bool AD5933_StartScan(AD5933_Scan *scan, unsigned long long nowUs);
+
+/*! Polls every busy device once and moves the scan on. */
+bool AD5933_ScanStep(AD5933_Scan *scan, unsigned long long nowUs);
+
+/*! Returns the channels measured per second by the last scan. */
+float AD5933_GetScanRate(const AD5933_Scan *scan);
+
+#endif /* __AD5933_SCAN_H__ */
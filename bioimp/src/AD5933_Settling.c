@@ -0,0 +1,226 @@
+/***************************************************************************//**
+ *   @file   AD5933_Settling.c
+ *   @brief  Tuning of the settling cycles of each frequency band against a
+ *           long-settle reference.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Settling.h"
+#include "math.h"
+
+/******************************************************************************/
+/************************** Constants Definitions *****************************/
+/******************************************************************************/
+
+/* Settling cycles tried, shortest first */
+static const unsigned short SETTLING_LADDER[] = {
+    1, 2, 4, 8, 16, 32, 64, 128, 256, 511, 1022
+};
+#define SETTLING_STEPS  (sizeof(SETTLING_LADDER) / sizeof(SETTLING_LADDER[0]))
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Configures the grid and settling cycles and runs one sweep.
+ *
+ * @param dev    - Device context.
+ * @param table  - Grid of the tuning.
+ * @param cycles - Settling cycles.
+ * @param buffer - Buffer for the sweep.
+ *
+ * @return true if the sweep completed.
+*******************************************************************************/
+static bool AD5933_SettlingSweep(AD5933_Device *dev,
+                                 const AD5933_SettlingTable *table,
+                                 unsigned short cycles,
+                                 AD5933_SweepBuffer *buffer)
+{
+    unsigned short settlingReg = AD5933_EncodeSettlingCycles(cycles);
+
+    AD5933_ConfigSweep(dev, table->startFreq, table->incFreq, table->points - 1);
+
+    return AD5933_SetSettlingCycles(dev, settlingReg & AD5933_MAX_SETTLING_CYCLES,
+                                    settlingReg >> 9) &&
+           AD5933_RunSweep(dev, buffer);
+}
+
+/***************************************************************************//**
+ * @brief Checks if every point of a band of a trial sweep is within the
+ *        tolerance of the reference: |trial - reference| / |reference|.
+ *
+ * @param reference - Reference sweep.
+ * @param trial     - Trial sweep.
+ * @param first     - First point of the band.
+ * @param count     - Points of the band.
+ * @param tolerance - Relative deviation allowed.
+ *
+ * @return true if the band agrees with the reference.
+*******************************************************************************/
+static bool AD5933_BandAgrees(const AD5933_SweepBuffer *reference,
+                              const AD5933_SweepBuffer *trial,
+                              unsigned short first,
+                              unsigned short count,
+                              float tolerance)
+{
+    double         real  = 0;
+    double         imag  = 0;
+    double         limit = 0;
+    unsigned short point = 0;
+
+    for(point = first; point < first + count; point++)
+    {
+        real  = (double)trial->realData[point] - reference->realData[point];
+        imag  = (double)trial->imagData[point] - reference->imagData[point];
+        limit = (double)tolerance * tolerance *
+                ((double)reference->realData[point] * reference->realData[point] +
+                 (double)reference->imagData[point] * reference->imagData[point]);
+        if(real * real + imag * imag > limit)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Finds, for each band of a sweep grid and the load connected, the
+ *        smallest settling cycles whose result agrees with a reference sweep
+ *        settled for AD5933_SETTLING_REFERENCE cycles. The candidates go up
+ *        in powers of two; each trial is one sweep of the whole grid and the
+ *        bands still open check it, so the tuning takes at most one sweep per
+ *        candidate. Run it once per load type and keep the table; the device
+ *        is left with the grid configured.
+ *
+ * @param dev        - Device context.
+ * @param table      - Table to fill.
+ * @param startFreq  - Start frequency in Hz.
+ * @param incFreq    - Frequency increment in Hz.
+ * @param incNum     - Number of increments. Maximum value is 511.
+ * @param bandPoints - Points of each band. It is raised when the grid would
+ *                     need more than AD5933_SETTLING_MAX_BANDS bands.
+ * @param tolerance  - Relative deviation allowed from the reference.
+ * @param reference  - Buffer for the reference sweep (incNum + 1 points).
+ * @param trial      - Buffer for the trial sweeps (incNum + 1 points).
+ *
+ * @return false if a sweep failed.
+*******************************************************************************/
+bool AD5933_TuneSettling(AD5933_Device *dev,
+                         AD5933_SettlingTable *table,
+                         unsigned long  startFreq,
+                         unsigned long  incFreq,
+                         unsigned short incNum,
+                         unsigned short bandPoints,
+                         float tolerance,
+                         AD5933_SweepBuffer *reference,
+                         AD5933_SweepBuffer *trial)
+{
+    unsigned short minimum = 0;
+    unsigned short first   = 0;
+    unsigned short count   = 0;
+    unsigned char  step    = 0;
+    unsigned char  band    = 0;
+    unsigned char  open    = 0;
+
+    incNum            = (incNum > AD5933_MAX_INC_NUM) ? AD5933_MAX_INC_NUM : incNum;
+    table->startFreq  = startFreq;
+    table->incFreq    = incFreq;
+    table->points     = incNum + 1;
+    minimum           = (table->points + AD5933_SETTLING_MAX_BANDS - 1) /
+                        AD5933_SETTLING_MAX_BANDS;
+    table->bandPoints = (bandPoints < minimum) ? minimum : bandPoints;
+    table->bands      = (table->points + table->bandPoints - 1) / table->bandPoints;
+    table->sweeps     = 1;
+    for(band = 0; band < table->bands; band++)
+    {
+        table->cycles[band] = AD5933_SETTLING_REFERENCE;
+    }
+    if(!AD5933_SettlingSweep(dev, table, AD5933_SETTLING_REFERENCE, reference) ||
+       (reference->count != table->points))
+    {
+        return false;
+    }
+    open = table->bands;
+    for(step = 0; (step < SETTLING_STEPS) && (open > 0); step++)
+    {
+        table->sweeps++;
+        if(!AD5933_SettlingSweep(dev, table, SETTLING_LADDER[step], trial) ||
+           (trial->count != table->points))
+        {
+            return false;
+        }
+        for(band = 0; band < table->bands; band++)
+        {
+            first = band * table->bandPoints;
+            count = table->points - first;
+            count = (count > table->bandPoints) ? table->bandPoints : count;
+            if((table->cycles[band] == AD5933_SETTLING_REFERENCE) &&
+               AD5933_BandAgrees(reference, trial, first, count, tolerance))
+            {
+                table->cycles[band] = SETTLING_LADDER[step];
+                open--;
+            }
+        }
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Returns the settling cycles tuned for a frequency: those of the
+ *        band that holds it, or of the nearest band outside the grid.
+ *
+ * @param table     - Tuned table.
+ * @param frequency - Frequency in Hz.
+ *
+ * @return Settling cycles (AD5933_EncodeSettlingCycles gives the register).
+*******************************************************************************/
+unsigned short AD5933_GetTunedSettling(const AD5933_SettlingTable *table,
+                                       unsigned long frequency)
+{
+    unsigned long point = 0;
+
+    if(table->bands == 0)
+    {
+        return AD5933_SETTLING_REFERENCE;
+    }
+    if((frequency > table->startFreq) && (table->incFreq != 0))
+    {
+        point = (frequency - table->startFreq + table->incFreq / 2) /
+                table->incFreq;
+    }
+    point = (point >= table->points) ? (unsigned long)table->points - 1 : point;
+
+    return table->cycles[point / table->bandPoints];
+}
+
+/***************************************************************************//**
+ * @brief Configures the tuned grid as the sweep of the device, with the
+ *        longest settling of its bands so every band gets enough.
+ *
+ * @param dev   - Device context.
+ * @param table - Tuned table.
+ *
+ * @return true if the settling register was written.
+*******************************************************************************/
+bool AD5933_ConfigTunedSweep(AD5933_Device *dev,
+                             const AD5933_SettlingTable *table)
+{
+    unsigned short cycles      = 0;
+    unsigned short settlingReg = 0;
+    unsigned char  band        = 0;
+
+    for(band = 0; band < table->bands; band++)
+    {
+        cycles = (table->cycles[band] > cycles) ? table->cycles[band] : cycles;
+    }
+    settlingReg = AD5933_EncodeSettlingCycles(cycles);
+    AD5933_ConfigSweep(dev, table->startFreq, table->incFreq, table->points - 1);
+
+    return AD5933_SetSettlingCycles(dev, settlingReg & AD5933_MAX_SETTLING_CYCLES,
+                                    settlingReg >> 9);
+}
@@ -0,0 +1,60 @@
+/***************************************************************************//**
+ *   @file   AD5933_Settling.h
+ *   @brief  Tuning of the settling cycles of each frequency band against a
+ *           long-settle reference.
+*******************************************************************************/
+
+#ifndef __AD5933_SETTLING_H__
+#define __AD5933_SETTLING_H__
+
+#include "stdbool.h"
+#include "AD5933.h"
+
+/******************************************************************************/
+/*************************** Settling Definitions *****************************/
+/******************************************************************************/
+
+#define AD5933_SETTLING_MAX_BANDS   16      // Bands of a tuned grid
+#define AD5933_SETTLING_REFERENCE   (4 * AD5933_MAX_SETTLING_CYCLES)   // Cycles
+                                            // of the long-settle reference
+
+/******************************************************************************/
+/***************************** Settling Types *********************************/
+/******************************************************************************/
+
+/* Settling cycles tuned for one load and sweep grid. Band b holds points
+   b * bandPoints to (b + 1) * bandPoints - 1 of the grid. */
+typedef struct {
+    unsigned long  startFreq;                       // Frequency of point 0 (Hz)
+    unsigned long  incFreq;                         // Step between points (Hz)
+    unsigned short points;                          // Points of the grid
+    unsigned short bandPoints;                      // Points per band
+    unsigned char  bands;                           // Bands of the grid
+    unsigned short cycles[AD5933_SETTLING_MAX_BANDS];   // Cycles of each band
+    unsigned char  sweeps;                          // Sweeps the tuning took
+} AD5933_SettlingTable;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Finds the smallest settling cycles of each band that match a reference. */
+bool AD5933_TuneSettling(AD5933_Device *dev,
+                         AD5933_SettlingTable *table,
+                         unsigned long  startFreq,
+                         unsigned long  incFreq,
+                         unsigned short incNum,
+                         unsigned short bandPoints,
+                         float tolerance,
+                         AD5933_SweepBuffer *reference,
+                         AD5933_SweepBuffer *trial);
+
+/*! Returns the settling cycles tuned for a frequency. */
+unsigned short AD5933_GetTunedSettling(const AD5933_SettlingTable *table,
+                                       unsigned long frequency);
+
+/*! Configures the tuned grid with the cycles that suit all its bands. */
+bool AD5933_ConfigTunedSweep(AD5933_Device *dev,
+                             const AD5933_SettlingTable *table);
+
+#endif /* __AD5933_SETTLING_H__ */
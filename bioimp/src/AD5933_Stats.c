@@ -0,0 +1,136 @@
+/***************************************************************************//**
+ *   @file   AD5933_Stats.c
+ *   @brief  Reader side of the driver statistics. Runs in any thread, never
+ *           on the measurement path.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Stats.h"
+
+#if AD5933_STATS
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Clears the statistics and selects their clock. Call it before the
+ *        statistics are attached to a device.
+ *
+ * @param stats        - Statistics.
+ * @param clock        - Time source in ns, NULL for CLOCK_MONOTONIC.
+ * @param clockContext - Argument passed back to the clock.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_StatsInit(AD5933_Stats *stats,
+                      AD5933_StatsClock clock,
+                      void *clockContext)
+{
+    unsigned char entry  = 0;
+    unsigned char bucket = 0;
+
+    atomic_init(&stats->sequence, 0);
+    for(entry = 0; entry < AD5933_COUNTER_COUNT; entry++)
+    {
+        atomic_init(&stats->counters[entry], 0);
+    }
+    for(entry = 0; entry < AD5933_LATENCY_COUNT; entry++)
+    {
+        for(bucket = 0; bucket < AD5933_STATS_BUCKETS; bucket++)
+        {
+            atomic_init(&stats->histograms[entry][bucket], 0);
+        }
+    }
+    stats->clock        = clock;
+    stats->clockContext = clockContext;
+}
+
+/***************************************************************************//**
+ * @brief Takes a consistent copy of the statistics. The copy is retried
+ *        while the driver thread is updating them, so the driver never
+ *        waits; an update takes a few stores, so retries are rare.
+ *
+ * @param stats    - Statistics attached to a device.
+ * @param snapshot - Copy.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_StatsRead(AD5933_Stats *stats, AD5933_StatsSnapshot *snapshot)
+{
+    unsigned long begin  = 0;
+    unsigned long end    = 0;
+    unsigned char entry  = 0;
+    unsigned char bucket = 0;
+
+    snapshot->retries = 0;
+    while(true)
+    {
+        begin = atomic_load_explicit(&stats->sequence, memory_order_acquire);
+        for(entry = 0; entry < AD5933_COUNTER_COUNT; entry++)
+        {
+            snapshot->counters[entry] =
+                atomic_load_explicit(&stats->counters[entry],
+                                     memory_order_relaxed);
+        }
+        for(entry = 0; entry < AD5933_LATENCY_COUNT; entry++)
+        {
+            for(bucket = 0; bucket < AD5933_STATS_BUCKETS; bucket++)
+            {
+                snapshot->histograms[entry][bucket] =
+                    atomic_load_explicit(&stats->histograms[entry][bucket],
+                                         memory_order_relaxed);
+            }
+        }
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&stats->sequence, memory_order_relaxed);
+        if(((begin & 1) == 0) && (begin == end))
+        {
+            return;
+        }
+        snapshot->retries++;
+    }
+}
+
+/***************************************************************************//**
+ * @brief Returns the upper bound of the histogram bucket that holds a
+ *        quantile, e.g. 0.99 for the latency 99 % of the records are under.
+ *
+ * @param snapshot - Copy of the statistics.
+ * @param latency  - Histogram.
+ * @param quantile - Quantile, 0 to 1.
+ *
+ * @return Latency in us, 0 if the histogram is empty.
+*******************************************************************************/
+unsigned long AD5933_StatsQuantile(const AD5933_StatsSnapshot *snapshot,
+                                   AD5933_Latency latency,
+                                   float quantile)
+{
+    const unsigned long *histogram = snapshot->histograms[latency];
+    unsigned long        total     = 0;
+    unsigned long        seen      = 0;
+    unsigned char        bucket    = 0;
+
+    for(bucket = 0; bucket < AD5933_STATS_BUCKETS; bucket++)
+    {
+        total += histogram[bucket];
+    }
+    if(total == 0)
+    {
+        return 0;
+    }
+    for(bucket = 0; bucket < AD5933_STATS_BUCKETS - 1; bucket++)
+    {
+        seen += histogram[bucket];
+        if(seen >= quantile * total)
+        {
+            break;
+        }
+    }
+
+    return (unsigned long)((2ull << bucket) - 1);
+}
+
+#endif /* AD5933_STATS */
@@ -0,0 +1,216 @@
+/***************************************************************************//**
+ *   @file   AD5933_Stats.h
+ *   @brief  Hot-path counters and latency histograms of the driver.
+ *
+ *   Statistics are compiled in with -DAD5933_STATS=1; otherwise the calls
+ *   compile to nothing. The driver thread of a device is the only writer.
+ *   Any other thread takes a consistent copy with AD5933_StatsRead, which
+ *   never blocks the driver: the writer bumps a sequence number around each
+ *   update and the reader retries if it raced with one.
+*******************************************************************************/
+
+#ifndef __AD5933_STATS_H__
+#define __AD5933_STATS_H__
+
+#include "stdbool.h"
+#include "stdatomic.h"
+#include "time.h"
+
+/******************************************************************************/
+/**************************** Stats Definitions *******************************/
+/******************************************************************************/
+
+/* Statistics compiled in, set with -DAD5933_STATS=1 */
+#ifndef AD5933_STATS
+#define AD5933_STATS                0
+#endif
+
+/* Bucket b of a histogram counts latencies of 2^b to 2^(b+1) - 1 us;
+   bucket 0 also counts those under 1 us, the last one everything longer */
+#define AD5933_STATS_BUCKETS        32
+
+/******************************************************************************/
+/****************************** Stats Types ***********************************/
+/******************************************************************************/
+
+/* Counters of a device */
+typedef enum {
+    AD5933_COUNTER_BUS_READS,       // I2C read operations
+    AD5933_COUNTER_BUS_WRITES,      // I2C write operations
+    AD5933_COUNTER_DATA_POLLS,      // STATUS polls of the DATA_VALID waits
+    AD5933_COUNTER_DATA_WAITS,      // DATA_VALID waits completed
+    AD5933_COUNTER_TEMP_POLLS,      // STATUS polls of the TEMP_VALID waits
+    AD5933_COUNTER_TEMP_WAITS,      // TEMP_VALID waits completed
+    AD5933_COUNTER_REDUNDANT_WRITES,    // Writes the shadow copy skipped
+    AD5933_COUNTER_COUNT
+} AD5933_Counter;
+
+/* Latency histograms of a device */
+typedef enum {
+    AD5933_LATENCY_SWEEP,           // Whole sweep
+    AD5933_LATENCY_POINT,           // Point command to data ready
+    AD5933_LATENCY_CONFIG,          // Sweep configuration write
+    AD5933_LATENCY_TEMPERATURE,     // Temperature command to value read
+    AD5933_LATENCY_COUNT
+} AD5933_Latency;
+
+/* Time source of the histograms, in ns */
+typedef unsigned long long (*AD5933_StatsClock)(void *context);
+
+/* Statistics of one device, written by its driver thread only */
+typedef struct {
+    atomic_ulong       sequence;        // Odd while an update is in progress
+    atomic_ulong       counters[AD5933_COUNTER_COUNT];
+    atomic_ulong       histograms[AD5933_LATENCY_COUNT][AD5933_STATS_BUCKETS];
+    AD5933_StatsClock  clock;           // NULL = CLOCK_MONOTONIC
+    void              *clockContext;    // Argument of clock
+} AD5933_Stats;
+
+/* Consistent copy of the statistics */
+typedef struct {
+    unsigned long counters[AD5933_COUNTER_COUNT];
+    unsigned long histograms[AD5933_LATENCY_COUNT][AD5933_STATS_BUCKETS];
+    unsigned long retries;              // Copies discarded by a race
+} AD5933_StatsSnapshot;
+
+/******************************************************************************/
+/***************************** Stats Macros ***********************************/
+/******************************************************************************/
+
+#if AD5933_STATS
+#define AD5933_STATS_COUNT(stats, counter, n) \
+    AD5933_StatsCount(stats, counter, n)
+#define AD5933_STATS_NOW(stats) \
+    AD5933_StatsNow(stats)
+#define AD5933_STATS_LATENCY(stats, latency, startNs) \
+    AD5933_StatsLatency(stats, latency, startNs)
+#else
+/* The arguments are not evaluated, so they may name fields and locals that
+   only exist in a statistics build */
+#define AD5933_STATS_COUNT(stats, counter, n)           ((void)0)
+#define AD5933_STATS_NOW(stats)                         0ull
+#define AD5933_STATS_LATENCY(stats, latency, startNs)   ((void)0)
+#endif
+
+#if AD5933_STATS
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Returns the time of the statistics clock.
+ *
+ * @param stats - Statistics, or NULL.
+ *
+ * @return Time in ns, 0 if no statistics are attached.
+*******************************************************************************/
+static inline unsigned long long AD5933_StatsNow(AD5933_Stats *stats)
+{
+    struct timespec now;
+    
+    if(stats == 0)
+    {
+        return 0;
+    }
+    if(stats->clock != 0)
+    {
+        return stats->clock(stats->clockContext);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (unsigned long long)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+/***************************************************************************//**
+ * @brief Adds to an entry of the statistics inside a sequence update. Only
+ *        the driver thread writes, so a relaxed load and store suffice.
+ *
+ * @param stats - Statistics.
+ * @param entry - Counter or histogram bucket.
+ * @param n     - Amount added.
+ *
+ * @return None.
+*******************************************************************************/
+static inline void AD5933_StatsAdd(AD5933_Stats *stats,
+                                   atomic_ulong *entry,
+                                   unsigned long n)
+{
+    unsigned long sequence = atomic_load_explicit(&stats->sequence,
+                                                  memory_order_relaxed);
+    
+    atomic_store_explicit(&stats->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(entry,
+                          atomic_load_explicit(entry, memory_order_relaxed) + n,
+                          memory_order_relaxed);
+    atomic_store_explicit(&stats->sequence, sequence + 2, memory_order_release);
+}
+
+/***************************************************************************//**
+ * @brief Adds to a counter.
+ *
+ * @param stats   - Statistics, or NULL.
+ * @param counter - Counter.
+ * @param n       - Amount added.
+ *
+ * @return None.
+*******************************************************************************/
+static inline void AD5933_StatsCount(AD5933_Stats *stats,
+                                     AD5933_Counter counter,
+                                     unsigned long n)
+{
+    if(stats != 0)
+    {
+        AD5933_StatsAdd(stats, &stats->counters[counter], n);
+    }
+}
+
+/***************************************************************************//**
+ * @brief Records the time elapsed since startNs in a latency histogram.
+ *
+ * @param stats   - Statistics, or NULL.
+ * @param latency - Histogram.
+ * @param startNs - Start time, from AD5933_StatsNow.
+ *
+ * @return None.
+*******************************************************************************/
+static inline void AD5933_StatsLatency(AD5933_Stats *stats,
+                                       AD5933_Latency latency,
+                                       unsigned long long startNs)
+{
+    unsigned long long us     = 0;
+    unsigned char      bucket = 0;
+    
+    if(stats == 0)
+    {
+        return;
+    }
+    us = (AD5933_StatsNow(stats) - startNs) / 1000;
+    while((us >>= 1) && (bucket < AD5933_STATS_BUCKETS - 1))
+    {
+        bucket++;
+    }
+    AD5933_StatsAdd(stats, &stats->histograms[latency][bucket], 1);
+}
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Clears the statistics and selects their clock. */
+void AD5933_StatsInit(AD5933_Stats *stats,
+                      AD5933_StatsClock clock,
+                      void *clockContext);
+
+/*! Takes a consistent copy of the statistics without blocking the driver. */
+void AD5933_StatsRead(AD5933_Stats *stats, AD5933_StatsSnapshot *snapshot);
+
+/*! Returns the upper bound (us) of the bucket holding a latency quantile. */
+unsigned long AD5933_StatsQuantile(const AD5933_StatsSnapshot *snapshot,
+                                   AD5933_Latency latency,
+                                   float quantile);
+
+#endif /* AD5933_STATS */
+
+#endif /* __AD5933_STATS_H__ */
@@ -0,0 +1,316 @@
+/***************************************************************************//**
+ *   @file   AD5933_Stream.c
+ *   @brief  Continuous fixed-frequency acquisition: repeated DFTs at one
+ *           frequency, timestamped and decimated on the fly.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Stream.h"
+#include "string.h"
+#include "time.h"
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Returns the time of the stream clock.
+ *
+ * @param stream - Stream.
+ *
+ * @return Time in ns.
+*******************************************************************************/
+static unsigned long long AD5933_StreamNow(const AD5933_Stream *stream)
+{
+    struct timespec now;
+
+    if(stream->config.clock != 0)
+    {
+        return stream->config.clock(stream->config.clockContext);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (unsigned long long)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+/***************************************************************************//**
+ * @brief Clears the filter state and the counters of a stream.
+ *
+ * @param stream - Stream.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_ResetStream(AD5933_Stream *stream)
+{
+    memset(stream->integrators, 0, sizeof(stream->integrators));
+    memset(stream->combs, 0, sizeof(stream->combs));
+    memset(stream->history, 0, sizeof(stream->history));
+    stream->cicPhase    = 0;
+    stream->historyHead = 0;
+    stream->firPhase    = 0;
+    stream->inputs      = 0;
+    stream->outputs     = 0;
+}
+
+/***************************************************************************//**
+ * @brief Checks a configuration and resets the filters of a stream. The CIC
+ *        gain cicRatio ^ cicOrder must stay within AD5933_STREAM_MAX_CIC_GAIN
+ *        so its integrators never lose the 16-bit data.
+ *
+ * @param stream - Stream to initialize.
+ * @param config - Excitation and decimation.
+ * @param ring   - Output ring, with slots of sizeof(AD5933_StreamSample),
+ *                 or NULL if only FeedStream results are used.
+ *
+ * @return false if the configuration or the ring slots are invalid.
+*******************************************************************************/
+bool AD5933_InitStream(AD5933_Stream *stream,
+                       const AD5933_StreamConfig *config,
+                       AD5933_Ring *ring)
+{
+    unsigned long long gain  = 1;
+    unsigned char      stage = 0;
+
+    if((config->frequency == 0) || (config->cicRatio == 0) ||
+       (config->firRatio == 0) ||
+       (config->cicOrder > AD5933_STREAM_MAX_CIC_ORDER) ||
+       ((config->cicOrder == 0) && (config->cicRatio != 1)) ||
+       (config->firLength > AD5933_STREAM_MAX_TAPS) ||
+       ((config->firLength == 0) && (config->firRatio != 1)) ||
+       ((config->firLength != 0) && (config->firTaps == 0)) ||
+       ((ring != 0) && (ring->slotSize != sizeof(AD5933_StreamSample))))
+    {
+        return false;
+    }
+    for(stage = 0; stage < config->cicOrder; stage++)
+    {
+        gain *= config->cicRatio;
+        if(gain > AD5933_STREAM_MAX_CIC_GAIN)
+        {
+            return false;
+        }
+    }
+    stream->config   = *config;
+    stream->ring     = ring;
+    stream->cicScale = 1.0f / gain;
+    AD5933_ResetStream(stream);
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Returns the group delay of the decimation filters: the CIC delays
+ *        cicOrder * (cicRatio - 1) / 2 DFTs and a symmetric FIR
+ *        (firLength - 1) / 2 CIC outputs. The timestamp of a decimated sample
+ *        minus this delay times the DFT period is the instant it stands for.
+ *
+ * @param config - Excitation and decimation.
+ *
+ * @return Group delay in DFTs.
+*******************************************************************************/
+float AD5933_GetStreamDelay(const AD5933_StreamConfig *config)
+{
+    float delay = config->cicOrder * (config->cicRatio - 1) / 2.0f;
+
+    if(config->firLength != 0)
+    {
+        delay += (config->firLength - 1) / 2.0f * config->cicRatio;
+    }
+
+    return delay;
+}
+
+/***************************************************************************//**
+ * @brief Runs one DFT result through the CIC and the FIR. The CIC works on
+ *        64-bit integers with modulo arithmetic, so the integrators may wrap
+ *        and the combs still give the exact sum. The FIR is only evaluated
+ *        on the inputs it keeps. Each decimated sample goes to the ring;
+ *        if the ring is full it is dropped and counted there.
+ *
+ * @param stream      - Stream.
+ * @param realData    - Real data of the DFT.
+ * @param imagData    - Imaginary data of the DFT.
+ * @param timestampNs - Middle of the DFT window.
+ *
+ * @return true if a decimated sample was produced.
+*******************************************************************************/
+bool AD5933_FeedStream(AD5933_Stream *stream,
+                       signed short realData,
+                       signed short imagData,
+                       unsigned long long timestampNs)
+{
+    const AD5933_StreamConfig *config = &stream->config;
+    AD5933_StreamSample        sample;
+    unsigned long long         value[2];
+    float                      output[2];
+    unsigned char              part   = 0;
+    unsigned char              stage  = 0;
+    unsigned char              tap    = 0;
+    unsigned char              slot   = 0;
+    unsigned long long         delayed = 0;
+
+    stream->inputs++;
+    value[0] = (unsigned long long)(long long)realData;
+    value[1] = (unsigned long long)(long long)imagData;
+    if(config->cicOrder != 0)
+    {
+        for(part = 0; part < 2; part++)
+        {
+            for(stage = 0; stage < config->cicOrder; stage++)
+            {
+                stream->integrators[part][stage] += value[part];
+                value[part] = stream->integrators[part][stage];
+            }
+        }
+        if(++stream->cicPhase < config->cicRatio)
+        {
+            return false;
+        }
+        stream->cicPhase = 0;
+        for(part = 0; part < 2; part++)
+        {
+            for(stage = 0; stage < config->cicOrder; stage++)
+            {
+                delayed = stream->combs[part][stage];
+                stream->combs[part][stage] = value[part];
+                value[part] -= delayed;
+            }
+        }
+    }
+    output[0] = (long long)value[0] * stream->cicScale;
+    output[1] = (long long)value[1] * stream->cicScale;
+    if(config->firLength != 0)
+    {
+        stream->historyHead = (stream->historyHead + 1) % config->firLength;
+        stream->history[0][stream->historyHead] = output[0];
+        stream->history[1][stream->historyHead] = output[1];
+        if(++stream->firPhase < config->firRatio)
+        {
+            return false;
+        }
+        stream->firPhase = 0;
+        output[0] = 0;
+        output[1] = 0;
+        // Tap 0 goes with the newest input
+        slot = stream->historyHead;
+        for(tap = 0; tap < config->firLength; tap++)
+        {
+            output[0] += config->firTaps[tap] * stream->history[0][slot];
+            output[1] += config->firTaps[tap] * stream->history[1][slot];
+            slot = (slot == 0) ? config->firLength - 1 : slot - 1;
+        }
+    }
+    sample.timestampNs = timestampNs;
+    sample.index       = stream->outputs++;
+    sample.realData    = output[0];
+    sample.imagData    = output[1];
+    if(stream->ring != 0)
+    {
+        AD5933_RingPush(stream->ring, &sample);
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Loads the stream frequency and its settling cycles with one block
+ *        write, resets the filters and starts the first DFT. The time of a
+ *        DFT is worked out from the settling cycles and the DFT window, so
+ *        AD5933_ServiceStream does not touch the bus before it can be ready.
+ *
+ * @param dev    - Device context.
+ * @param stream - Stream initialized by AD5933_InitStream.
+ *
+ * @return true if the commands were sent.
+*******************************************************************************/
+bool AD5933_StartStream(AD5933_Device *dev, AD5933_Stream *stream)
+{
+    static const unsigned char MULTIPLIER[4] = {1, 2, 1, 4};
+    const AD5933_StreamConfig *config = &stream->config;
+    AD5933_SweepProfile        profile;
+
+    AD5933_ResetStream(stream);
+    stream->settlingNs   = (unsigned long long)config->settlingCycles *
+                           MULTIPLIER[config->settlingMultiplier & 0x3] *
+                           1000000000ull / config->frequency;
+    stream->conversionNs = stream->settlingNs +
+                           (unsigned long long)AD5933_DFT_SAMPLES *
+                           AD5933_ADC_DIVIDER * 1000000000ull /
+                           dev->sysClk;
+    AD5933_CompileSweepProfile(dev, &profile, config->frequency, 0, 0,
+                               config->settlingCycles,
+                               config->settlingMultiplier);
+    if(!AD5933_LoadSweepProfile(dev, &profile) || !AD5933_BeginSweep(dev))
+    {
+        return false;
+    }
+    stream->armedNs = AD5933_StreamNow(stream);
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Services a running stream without blocking. Before the DFT can be
+ *        ready it returns at once, without a bus transaction. Then each call
+ *        is one block read of status and data; once the data is valid the
+ *        next DFT is started with a single REPEAT_FREQ write, and the result
+ *        is filtered while the device converts. A DFT thus costs one write
+ *        and, when polled on time, one read. The clock is read after the
+ *        write, so the wait is counted from the actual start of the DFT.
+ *
+ * @param dev    - Device context.
+ * @param stream - Stream started by AD5933_StartStream.
+ *
+ * @return AD5933_POLL_PENDING - The DFT is not finished, call again later.
+ *         AD5933_POLL_READY   - A DFT was read and the next one started.
+ *         AD5933_POLL_TIMEOUT - The poll limit was reached.
+ *         AD5933_POLL_ERROR   - Bus error or stream not running.
+*******************************************************************************/
+AD5933_PollResult AD5933_ServiceStream(AD5933_Device *dev,
+                                       AD5933_Stream *stream)
+{
+    AD5933_PollResult  result      = AD5933_POLL_PENDING;
+    unsigned long long timestampNs = 0;
+    signed short       realData    = 0;
+    signed short       imagData    = 0;
+    unsigned char      status      = 0;
+
+    if((dev->pendingStatus == AD5933_STAT_DATA_VALID) &&
+       (AD5933_StreamNow(stream) - stream->armedNs < stream->conversionNs))
+    {
+        return AD5933_POLL_PENDING;
+    }
+    result = AD5933_Poll(dev);
+    if(result != AD5933_POLL_READY)
+    {
+        return result;
+    }
+    AD5933_CollectData(dev, &realData, &imagData, &status);
+    timestampNs = stream->armedNs + stream->settlingNs +
+                  (stream->conversionNs - stream->settlingNs) / 2;
+    if(!AD5933_BeginPoint(dev, AD5933_FUNCTION_REPEAT_FREQ))
+    {
+        result = AD5933_POLL_ERROR;
+    }
+    stream->armedNs = AD5933_StreamNow(stream);
+    AD5933_FeedStream(stream, realData, imagData, timestampNs);
+
+    return result;
+}
+
+/***************************************************************************//**
+ * @brief Stops the stream: the DFT in progress is abandoned and the device
+ *        goes to standby. The filters keep their state until the next start.
+ *
+ * @param dev - Device context.
+ *
+ * @return true if the device went to standby.
+*******************************************************************************/
+bool AD5933_StopStream(AD5933_Device *dev)
+{
+    dev->pendingStatus = 0;
+
+    return AD5933_SetToStandBy(dev);
+}
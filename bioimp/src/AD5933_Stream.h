@@ -0,0 +1,99 @@
+/***************************************************************************//**
+ *   @file   AD5933_Stream.h
+ *   @brief  Continuous fixed-frequency acquisition: repeated DFTs at one
+ *           frequency, timestamped and decimated on the fly.
+*******************************************************************************/
+
+#ifndef __AD5933_STREAM_H__
+#define __AD5933_STREAM_H__
+
+#include "stdbool.h"
+#include "AD5933.h"
+#include "AD5933_Ring.h"
+
+/******************************************************************************/
+/*************************** Stream Definitions *******************************/
+/******************************************************************************/
+
+#define AD5933_STREAM_MAX_CIC_ORDER 4       // CIC integrator/comb stages
+#define AD5933_STREAM_MAX_CIC_GAIN  (1ull << 47)    // cicRatio ^ cicOrder,
+                                            // so 16-bit data fit in 64 bits
+#define AD5933_STREAM_MAX_TAPS      64      // FIR coefficients
+
+/******************************************************************************/
+/****************************** Stream Types **********************************/
+/******************************************************************************/
+
+/* Excitation and decimation of a stream. Samples go through the CIC first,
+   then through the FIR; each stage is skipped when its length is 0. */
+typedef struct {
+    unsigned long  frequency;           // Excitation frequency (Hz)
+    unsigned short settlingCycles;      // Settling cycles of each DFT
+    unsigned char  settlingMultiplier;  // AD5933_SETTLING_Xn
+    unsigned char  cicOrder;            // CIC stages, 0 = no CIC
+    unsigned short cicRatio;            // CIC decimation, 1 if no CIC
+    const float   *firTaps;             // FIR coefficients, NULL = no FIR
+    unsigned char  firLength;           // Number of firTaps
+    unsigned char  firRatio;            // FIR decimation, 1 if no FIR
+    AD5933_StatsClock clock;            // Time source (ns), NULL =
+                                        // CLOCK_MONOTONIC
+    void          *clockContext;        // Argument of clock
+} AD5933_StreamConfig;
+
+/* One decimated sample, as stored in the output ring */
+typedef struct {
+    unsigned long long timestampNs;     // Middle of the DFT window of the
+                                        // newest DFT that went into it
+    unsigned long      index;           // Decimated samples before this one
+    float              realData;        // Filtered real data
+    float              imagData;        // Filtered imaginary data
+} AD5933_StreamSample;
+
+/* State of a stream. Everything lives in the structure, so a stream runs
+   for any time without allocating. */
+typedef struct {
+    AD5933_StreamConfig config;         // Copy of the configuration
+    AD5933_Ring        *ring;           // Output samples, NULL = none
+    unsigned long long  integrators[2][AD5933_STREAM_MAX_CIC_ORDER];
+    unsigned long long  combs[2][AD5933_STREAM_MAX_CIC_ORDER];
+    unsigned short      cicPhase;       // Inputs since the last CIC output
+    float               cicScale;       // 1 / cicRatio ^ cicOrder
+    float               history[2][AD5933_STREAM_MAX_TAPS];
+    unsigned char       historyHead;    // Slot of the newest FIR input
+    unsigned char       firPhase;       // Inputs since the last FIR output
+    unsigned long long  settlingNs;     // Settling part of each DFT
+    unsigned long long  conversionNs;   // Settling plus DFT window
+    unsigned long long  armedNs;        // Start of the DFT in progress
+    unsigned long       inputs;         // DFTs read
+    unsigned long       outputs;        // Decimated samples produced
+} AD5933_Stream;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Checks a configuration and resets the filters of a stream. */
+bool AD5933_InitStream(AD5933_Stream *stream,
+                       const AD5933_StreamConfig *config,
+                       AD5933_Ring *ring);
+
+/*! Returns the delay of the decimation filters, in DFTs. */
+float AD5933_GetStreamDelay(const AD5933_StreamConfig *config);
+
+/*! Runs one DFT result through the decimation filters. */
+bool AD5933_FeedStream(AD5933_Stream *stream,
+                       signed short realData,
+                       signed short imagData,
+                       unsigned long long timestampNs);
+
+/*! Loads the stream frequency and starts the first DFT. */
+bool AD5933_StartStream(AD5933_Device *dev, AD5933_Stream *stream);
+
+/*! Reads a finished DFT, starts the next one and filters the result. */
+AD5933_PollResult AD5933_ServiceStream(AD5933_Device *dev,
+                                       AD5933_Stream *stream);
+
+/*! Stops the stream and puts the device in standby. */
+bool AD5933_StopStream(AD5933_Device *dev);
+
+#endif /* __AD5933_STREAM_H__ */
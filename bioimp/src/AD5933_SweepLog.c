@@ -0,0 +1,447 @@
+/***************************************************************************//**
+ *   @file   AD5933_SweepLog.c
+ *   @brief  Compact append-only binary log of sweeps and its mapped reader.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_SweepLog.h"
+#include "math.h"
+#include "stdlib.h"
+#include "string.h"
+#include "errno.h"
+#include "fcntl.h"
+#include "unistd.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+
+/******************************************************************************/
+/************************** Constants Definitions *****************************/
+/******************************************************************************/
+static const unsigned char SWEEPLOG_MAGIC[8] = {'A', 'D', '5', '9', '3', '3', 'S', 'L'};
+#define SWEEPLOG_SYNC               0x31505753ul    // "SWP1"
+#define SWEEPLOG_NO_TEMPERATURE     (-32768)        // Temperature not measured
+#define SWEEPLOG_TEMP_LSB           32              // Codes per degree Celsius
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Little-endian field helpers.
+*******************************************************************************/
+static void AD5933_Put16(unsigned char *data, unsigned short value)
+{
+    data[0] = (unsigned char)value;
+    data[1] = (unsigned char)(value >> 8);
+}
+
+static void AD5933_Put32(unsigned char *data, unsigned long value)
+{
+    AD5933_Put16(data, (unsigned short)value);
+    AD5933_Put16(data + 2, (unsigned short)(value >> 16));
+}
+
+static unsigned short AD5933_Get16(const unsigned char *data)
+{
+    return (unsigned short)(data[0] | (data[1] << 8));
+}
+
+static unsigned long AD5933_Get32(const unsigned char *data)
+{
+    return AD5933_Get16(data) | ((unsigned long)AD5933_Get16(data + 2) << 16);
+}
+
+/***************************************************************************//**
+ * @brief Fills a record header from the device state (range, gain and clock)
+ *        and a sweep profile (frequency codes and number of points).
+ *
+ * @param dev         - Device context.
+ * @param profile     - Profile the sweep was run with.
+ * @param temperature - Die temperature in degrees Celsius, NAN if unknown.
+ * @param timestamp   - Time of the sweep in the caller's time base.
+ * @param header      - Header to fill.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_SweepLogHeader(const AD5933_Device *dev,
+                           const AD5933_SweepProfile *profile,
+                           float temperature,
+                           unsigned long long timestamp,
+                           AD5933_SweepHeader *header)
+{
+    unsigned short incNum      = 0;
+    unsigned short settlingReg = 0;
+
+    AD5933_DecodeSweepProfile(profile, &header->startCode, &header->incCode,
+                              &incNum, &settlingReg);
+    header->points      = incNum + 1;
+    header->sysClk      = profile->sysClk;
+    header->timestamp   = timestamp;
+    header->temperature = isnan(temperature) ? SWEEPLOG_NO_TEMPERATURE :
+                          (signed short)lroundf(temperature * SWEEPLOG_TEMP_LSB);
+    header->range       = dev->range;
+    header->gain        = dev->gain;
+    header->clockSource = dev->clockSource;
+}
+
+/***************************************************************************//**
+ * @brief Writes all the bytes of a buffer, retrying partial writes.
+ *
+ * @param fd    - File descriptor.
+ * @param data  - Bytes to write.
+ * @param bytes - Number of bytes.
+ *
+ * @return true if every byte was written.
+*******************************************************************************/
+static bool AD5933_WriteAll(int fd, const unsigned char *data, size_t bytes)
+{
+    ssize_t written = 0;
+
+    while(bytes > 0)
+    {
+        written = write(fd, data, bytes);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data  += written;
+        bytes -= written;
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Returns the size of the record that starts with a record header.
+ *
+ * @param header - AD5933_SWEEPLOG_RECORD_HEADER bytes.
+ *
+ * @return Bytes of the record with its points, 0 if there is no record sync.
+*******************************************************************************/
+static size_t AD5933_RecordSize(const unsigned char *header)
+{
+    if(AD5933_Get32(header) != SWEEPLOG_SYNC)
+    {
+        return 0;
+    }
+
+    return AD5933_SWEEPLOG_RECORD_HEADER +
+           AD5933_SWEEPLOG_POINT_SIZE * (size_t)AD5933_Get16(&header[26]);
+}
+
+/***************************************************************************//**
+ * @brief Walks the record headers of an existing log, like the reader does,
+ *        and cuts the file after the last complete record. Whatever follows
+ *        it (a record torn by a crash) would otherwise hide every record
+ *        appended after it.
+ *
+ * @param fd   - Log file open for writing.
+ * @param size - Bytes in the file.
+ *
+ * @return false if the file could not be read or truncated.
+*******************************************************************************/
+static bool AD5933_TrimTornRecord(int fd, off_t size)
+{
+    unsigned char header[AD5933_SWEEPLOG_RECORD_HEADER];
+    off_t         offset = AD5933_SWEEPLOG_FILE_HEADER;
+    size_t        record = 0;
+
+    while((offset + AD5933_SWEEPLOG_RECORD_HEADER <= size) &&
+          (pread(fd, header, sizeof(header), offset) == sizeof(header)))
+    {
+        record = AD5933_RecordSize(header);
+        if((record == 0) || (offset + (off_t)record > size))
+        {
+            break;
+        }
+        offset += record;
+    }
+
+    return (offset == size) || (ftruncate(fd, offset) == 0);
+}
+
+/***************************************************************************//**
+ * @brief Opens a log file for appending. A new or empty file gets the file
+ *        header; an existing one must be a log of this version, and a torn
+ *        record at its end is removed so the new records can be read.
+ *
+ * @param writer - Writer to initialize.
+ * @param path   - Path of the log file.
+ *
+ * @return false if the file cannot be opened or is not a sweep log.
+*******************************************************************************/
+bool AD5933_SweepLogCreate(AD5933_SweepLogWriter *writer, const char *path)
+{
+    unsigned char header[AD5933_SWEEPLOG_FILE_HEADER] = {0};
+    struct stat   info;
+
+    writer->used = 0;
+    writer->fd   = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if(writer->fd < 0)
+    {
+        return false;
+    }
+    if(fstat(writer->fd, &info) != 0)
+    {
+        AD5933_SweepLogCloseWriter(writer);
+        return false;
+    }
+    if(info.st_size == 0)
+    {
+        memcpy(header, SWEEPLOG_MAGIC, sizeof(SWEEPLOG_MAGIC));
+        AD5933_Put16(&header[8], AD5933_SWEEPLOG_VERSION);
+        AD5933_Put16(&header[10], AD5933_SWEEPLOG_RECORD_HEADER);
+        if(AD5933_WriteAll(writer->fd, header, sizeof(header)))
+        {
+            return true;
+        }
+    }
+    else if((pread(writer->fd, header, sizeof(header), 0) == sizeof(header)) &&
+            (memcmp(header, SWEEPLOG_MAGIC, sizeof(SWEEPLOG_MAGIC)) == 0) &&
+            (AD5933_Get16(&header[8]) == AD5933_SWEEPLOG_VERSION) &&
+            AD5933_TrimTornRecord(writer->fd, info.st_size))
+    {
+        return true;
+    }
+    close(writer->fd);
+    writer->fd = -1;
+
+    return false;
+}
+
+/***************************************************************************//**
+ * @brief Appends one sweep to the staging buffer, which goes to the file
+ *        each time it fills up. Nothing is allocated.
+ *
+ * @param writer - Writer.
+ * @param header - Conditions of the sweep (its points field is ignored).
+ * @param sweep  - Points of the sweep; sweep->count are logged.
+ *
+ * @return false if the sweep has no arrays or a write failed.
+*******************************************************************************/
+bool AD5933_SweepLogAppend(AD5933_SweepLogWriter *writer,
+                           const AD5933_SweepHeader *header,
+                           const AD5933_SweepBuffer *sweep)
+{
+    unsigned char *record = 0;
+    unsigned short point  = 0;
+
+    if((writer->fd < 0) || (sweep->realData == 0) || (sweep->imagData == 0))
+    {
+        return false;
+    }
+    if((writer->used + AD5933_SWEEPLOG_RECORD_HEADER > AD5933_SWEEPLOG_STAGING) &&
+       !AD5933_SweepLogFlush(writer))
+    {
+        return false;
+    }
+    record = &writer->staging[writer->used];
+    AD5933_Put32(&record[0], SWEEPLOG_SYNC);
+    AD5933_Put32(&record[4], header->startCode);
+    AD5933_Put32(&record[8], header->incCode);
+    AD5933_Put32(&record[12], header->sysClk);
+    AD5933_Put32(&record[16], (unsigned long)(header->timestamp & 0xFFFFFFFFull));
+    AD5933_Put32(&record[20], (unsigned long)(header->timestamp >> 32));
+    AD5933_Put16(&record[24], (unsigned short)header->temperature);
+    AD5933_Put16(&record[26], sweep->count);
+    record[28] = header->range;
+    record[29] = header->gain;
+    record[30] = header->clockSource;
+    record[31] = 0;
+    writer->used += AD5933_SWEEPLOG_RECORD_HEADER;
+    for(point = 0; point < sweep->count; point++)
+    {
+        if((writer->used + AD5933_SWEEPLOG_POINT_SIZE > AD5933_SWEEPLOG_STAGING) &&
+           !AD5933_SweepLogFlush(writer))
+        {
+            return false;
+        }
+        record = &writer->staging[writer->used];
+        AD5933_Put16(&record[0], (unsigned short)sweep->realData[point]);
+        AD5933_Put16(&record[2], (unsigned short)sweep->imagData[point]);
+        writer->used += AD5933_SWEEPLOG_POINT_SIZE;
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Writes the buffered records to the file.
+ *
+ * @param writer - Writer.
+ *
+ * @return false if the write failed.
+*******************************************************************************/
+bool AD5933_SweepLogFlush(AD5933_SweepLogWriter *writer)
+{
+    bool written = AD5933_WriteAll(writer->fd, writer->staging, writer->used);
+
+    writer->used = 0;
+
+    return written;
+}
+
+/***************************************************************************//**
+ * @brief Flushes and closes the log file.
+ *
+ * @param writer - Writer.
+ *
+ * @return false if the last write or the close failed.
+*******************************************************************************/
+bool AD5933_SweepLogCloseWriter(AD5933_SweepLogWriter *writer)
+{
+    bool result = true;
+
+    if(writer->fd < 0)
+    {
+        return false;
+    }
+    result = AD5933_SweepLogFlush(writer);
+    result = (close(writer->fd) == 0) && result;
+    writer->fd = -1;
+
+    return result;
+}
+
+/***************************************************************************//**
+ * @brief Maps a log file read-only and indexes its sweeps by walking the
+ *        record headers. A record cut short at the end of the file (e.g. by
+ *        a crash while writing) is left out.
+ *
+ * @param reader - Reader to initialize.
+ * @param path   - Path of the log file.
+ *
+ * @return false if the file cannot be mapped or is not a sweep log.
+*******************************************************************************/
+bool AD5933_SweepLogOpen(AD5933_SweepLogReader *reader, const char *path)
+{
+    struct stat   info;
+    int           fd        = open(path, O_RDONLY);
+    size_t        offset    = AD5933_SWEEPLOG_FILE_HEADER;
+    size_t        record    = 0;
+    unsigned long allocated = 0;
+    size_t       *offsets   = 0;
+
+    memset(reader, 0, sizeof(*reader));
+    if(fd < 0)
+    {
+        return false;
+    }
+    if((fstat(fd, &info) != 0) || (info.st_size < AD5933_SWEEPLOG_FILE_HEADER))
+    {
+        close(fd);
+        return false;
+    }
+    reader->size = info.st_size;
+    reader->map  = mmap(0, reader->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(reader->map == MAP_FAILED)
+    {
+        reader->map = 0;
+        return false;
+    }
+    if((memcmp(reader->map, SWEEPLOG_MAGIC, sizeof(SWEEPLOG_MAGIC)) != 0) ||
+       (AD5933_Get16(&reader->map[8]) != AD5933_SWEEPLOG_VERSION))
+    {
+        AD5933_SweepLogClose(reader);
+        return false;
+    }
+    while(offset + AD5933_SWEEPLOG_RECORD_HEADER <= reader->size)
+    {
+        record = AD5933_RecordSize(&reader->map[offset]);
+        if((record == 0) || (offset + record > reader->size))
+        {
+            break;
+        }
+        if(reader->count == allocated)
+        {
+            allocated = (allocated == 0) ? 1024 : 2 * allocated;
+            offsets   = realloc(reader->offsets, allocated * sizeof(size_t));
+            if(offsets == 0)
+            {
+                AD5933_SweepLogClose(reader);
+                return false;
+            }
+            reader->offsets = offsets;
+        }
+        reader->offsets[reader->count++] = offset;
+        offset += record;
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Reads the header and points of any sweep straight from the mapping.
+ *
+ * @param reader - Reader.
+ * @param index  - Sweep number, 0 is the oldest.
+ * @param header - Conditions of the sweep.
+ * @param sweep  - Buffer for the points, or NULL to read only the header.
+ *
+ * @return false if there is no such sweep or it does not fit in the buffer
+ *         (the points that fit are copied).
+*******************************************************************************/
+bool AD5933_SweepLogRead(const AD5933_SweepLogReader *reader,
+                         unsigned long index,
+                         AD5933_SweepHeader *header,
+                         AD5933_SweepBuffer *sweep)
+{
+    const unsigned char *record = 0;
+    const unsigned char *points = 0;
+    unsigned short       point  = 0;
+
+    if(index >= reader->count)
+    {
+        return false;
+    }
+    record = &reader->map[reader->offsets[index]];
+    header->startCode   = AD5933_Get32(&record[4]);
+    header->incCode     = AD5933_Get32(&record[8]);
+    header->sysClk      = AD5933_Get32(&record[12]);
+    header->timestamp   = AD5933_Get32(&record[16]) |
+                          ((unsigned long long)AD5933_Get32(&record[20]) << 32);
+    header->temperature = (signed short)AD5933_Get16(&record[24]);
+    header->points      = AD5933_Get16(&record[26]);
+    header->range       = record[28];
+    header->gain        = record[29];
+    header->clockSource = record[30];
+    if(sweep == 0)
+    {
+        return true;
+    }
+    points       = &record[AD5933_SWEEPLOG_RECORD_HEADER];
+    sweep->count = (header->points < sweep->capacity) ? header->points :
+                                                        sweep->capacity;
+    for(point = 0; point < sweep->count; point++)
+    {
+        sweep->realData[point] = (signed short)AD5933_Get16(&points[0]);
+        sweep->imagData[point] = (signed short)AD5933_Get16(&points[2]);
+        points += AD5933_SWEEPLOG_POINT_SIZE;
+    }
+
+    return sweep->count == header->points;
+}
+
+/***************************************************************************//**
+ * @brief Unmaps the log file and frees the index.
+ *
+ * @param reader - Reader.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_SweepLogClose(AD5933_SweepLogReader *reader)
+{
+    if(reader->map != 0)
+    {
+        munmap((void *)reader->map, reader->size);
+    }
+    free(reader->offsets);
+    memset(reader, 0, sizeof(*reader));
+}
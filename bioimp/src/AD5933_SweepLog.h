@@ -0,0 +1,103 @@
+/***************************************************************************//**
+ *   @file   AD5933_SweepLog.h
+ *   @brief  Compact append-only binary log of sweeps and its mapped reader.
+ *
+ *   File layout, all fields little-endian:
+ *     File header (16 bytes): "AD5933SL", version (u16), record header
+ *                             size (u16), reserved (u32).
+ *     Each sweep record:      sync "SWP1" (u32), start code (u32), increment
+ *                             code (u32), system clock (u32), timestamp
+ *                             (u64), temperature in 1/32 C (i16), points
+ *                             (u16), range, gain, clock source, flags (u8),
+ *                             then points x (real, imaginary) as i16.
+ *   A record is 32 + 4 * points bytes, so the reader walks the headers to
+ *   index the file and reads any sweep directly from the mapping.
+*******************************************************************************/
+
+#ifndef __AD5933_SWEEPLOG_H__
+#define __AD5933_SWEEPLOG_H__
+
+#include "stdbool.h"
+#include "stddef.h"
+#include "AD5933.h"
+
+/******************************************************************************/
+/************************** Sweep Log Definitions *****************************/
+/******************************************************************************/
+
+#define AD5933_SWEEPLOG_VERSION         1
+#define AD5933_SWEEPLOG_FILE_HEADER     16      // Bytes of the file header
+#define AD5933_SWEEPLOG_RECORD_HEADER   32      // Bytes of a record header
+#define AD5933_SWEEPLOG_POINT_SIZE      4       // Real and imaginary, i16 each
+#define AD5933_SWEEPLOG_STAGING         4096    // Bytes buffered by the writer
+
+/******************************************************************************/
+/**************************** Sweep Log Types *********************************/
+/******************************************************************************/
+
+/* Conditions of one logged sweep */
+typedef struct {
+    unsigned long      startCode;       // Start frequency code
+    unsigned long      incCode;         // Frequency increment code
+    unsigned long      sysClk;          // System clock (Hz)
+    unsigned long long timestamp;       // Caller's time base (e.g. ms)
+    signed short       temperature;     // Die temperature in 1/32 C
+    unsigned short     points;          // Points in the record
+    unsigned char      range;           // AD5933_RANGE_x
+    unsigned char      gain;            // AD5933_GAIN_x
+    unsigned char      clockSource;     // AD5933_CONTROL_INT/EXT_SYSCLK
+} AD5933_SweepHeader;
+
+/* Appends sweeps to a log file through a fixed staging buffer. */
+typedef struct {
+    int            fd;                              // File descriptor
+    unsigned short used;                            // Bytes in staging
+    unsigned char  staging[AD5933_SWEEPLOG_STAGING];
+} AD5933_SweepLogWriter;
+
+/* Read-only mapping of a log file and the offset of each sweep. */
+typedef struct {
+    const unsigned char *map;       // Mapped file
+    size_t               size;      // Bytes mapped
+    size_t              *offsets;   // Offset of each record
+    unsigned long        count;     // Complete records in the file
+} AD5933_SweepLogReader;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Fills a record header from the device state and a sweep profile. */
+void AD5933_SweepLogHeader(const AD5933_Device *dev,
+                           const AD5933_SweepProfile *profile,
+                           float temperature,
+                           unsigned long long timestamp,
+                           AD5933_SweepHeader *header);
+
+/*! Opens (or creates) a log file for appending. */
+bool AD5933_SweepLogCreate(AD5933_SweepLogWriter *writer, const char *path);
+
+/*! Appends one sweep. */
+bool AD5933_SweepLogAppend(AD5933_SweepLogWriter *writer,
+                           const AD5933_SweepHeader *header,
+                           const AD5933_SweepBuffer *sweep);
+
+/*! Writes the buffered records to the file. */
+bool AD5933_SweepLogFlush(AD5933_SweepLogWriter *writer);
+
+/*! Flushes and closes the log file. */
+bool AD5933_SweepLogCloseWriter(AD5933_SweepLogWriter *writer);
+
+/*! Maps a log file and indexes its sweeps. */
+bool AD5933_SweepLogOpen(AD5933_SweepLogReader *reader, const char *path);
+
+/*! Reads the header and points of any sweep of the file. */
+bool AD5933_SweepLogRead(const AD5933_SweepLogReader *reader,
+                         unsigned long index,
+                         AD5933_SweepHeader *header,
+                         AD5933_SweepBuffer *sweep);
+
+/*! Unmaps the log file. */
+void AD5933_SweepLogClose(AD5933_SweepLogReader *reader);
+
+#endif /* __AD5933_SWEEPLOG_H__ */
@@ -0,0 +1,114 @@
+/***************************************************************************//**
+ *   @file   AD5933_Temperature.c
+ *   @brief  Background temperature sampling in the idle slots between sweeps.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Temperature.h"
+#include "math.h"
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Initializes the temperature service of a device. The first call to
+ *        AD5933_ServiceTemperature starts a measurement.
+ *
+ * @param service  - Temperature service.
+ * @param periodMs - Time between temperatures in ms.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_InitTempService(AD5933_TempService *service,
+                            unsigned long periodMs)
+{
+    service->temperature = NAN;
+    service->sampledMs   = 0;
+    service->periodMs    = periodMs;
+    service->pending     = false;
+    service->samples     = 0;
+}
+
+/***************************************************************************//**
+ * @brief Call from the idle slots between sweeps. When a temperature is due
+ *        it starts the measurement and returns; the next calls poll it once
+ *        each and store the result, so the measurement pipeline never waits
+ *        on AD5933_STAT_TEMP_VALID. A sweep started before the result is
+ *        collected cancels the measurement, which is started again in the
+ *        next idle slot.
+ *
+ * @param dev     - Device context.
+ * @param service - Temperature service of the device.
+ * @param nowMs   - Current time in ms (wraps around safely).
+ *
+ * @return true if a new temperature was stored by this call; a reading
+ *         lost to a bus error keeps the previous one.
+*******************************************************************************/
+bool AD5933_ServiceTemperature(AD5933_Device *dev,
+                               AD5933_TempService *service,
+                               unsigned long nowMs)
+{
+    AD5933_PollResult result      = AD5933_POLL_PENDING;
+    float             temperature = 0;
+
+    // Another operation took over the device
+    if(service->pending && (dev->pendingStatus != AD5933_STAT_TEMP_VALID))
+    {
+        service->pending = false;
+    }
+    if(!service->pending)
+    {
+        if((service->samples != 0) &&
+           (nowMs - service->sampledMs < service->periodMs))
+        {
+            return false;
+        }
+        service->pending = AD5933_BeginTemperature(dev);
+        return false;
+    }
+    result = AD5933_Poll(dev);
+    if(result == AD5933_POLL_PENDING)
+    {
+        return false;
+    }
+    service->pending = false;
+    if(result != AD5933_POLL_READY)
+    {
+        return false;
+    }
+    temperature = AD5933_CollectTemperature(dev);
+    if(isnan(temperature))
+    {
+        return false;
+    }
+    service->temperature = temperature;
+    service->sampledMs   = nowMs;
+    service->samples++;
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Returns the last temperature and how old it is, without any bus
+ *        access.
+ *
+ * @param service - Temperature service.
+ * @param nowMs   - Current time in ms.
+ * @param ageMs   - Age of the temperature in ms; NULL if not needed.
+ *
+ * @return Temperature in degrees Celsius, NAN if none was taken yet.
+*******************************************************************************/
+float AD5933_GetCachedTemperature(const AD5933_TempService *service,
+                                  unsigned long nowMs,
+                                  unsigned long *ageMs)
+{
+    if(ageMs != 0)
+    {
+        *ageMs = (service->samples != 0) ? nowMs - service->sampledMs : 0;
+    }
+
+    return service->temperature;
+}
@@ -0,0 +1,44 @@
+/***************************************************************************//**
+ *   @file   AD5933_Temperature.h
+ *   @brief  Background temperature sampling in the idle slots between sweeps.
+*******************************************************************************/
+
+#ifndef __AD5933_TEMPERATURE_H__
+#define __AD5933_TEMPERATURE_H__
+
+#include "stdbool.h"
+#include "AD5933.h"
+
+/******************************************************************************/
+/************************** Temperature Types *********************************/
+/******************************************************************************/
+
+/* Last temperature of a device and the schedule of the next one. Times are
+   in the caller's millisecond clock. */
+typedef struct {
+    float         temperature;      // Last temperature (C), NAN if none
+    unsigned long sampledMs;        // Time of the last temperature
+    unsigned long periodMs;         // Time between temperatures
+    bool          pending;          // A measurement is in progress
+    unsigned long samples;          // Temperatures taken
+} AD5933_TempService;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Initializes the temperature service of a device. */
+void AD5933_InitTempService(AD5933_TempService *service,
+                            unsigned long periodMs);
+
+/*! Starts or finishes a temperature measurement without waiting. */
+bool AD5933_ServiceTemperature(AD5933_Device *dev,
+                               AD5933_TempService *service,
+                               unsigned long nowMs);
+
+/*! Returns the last temperature and its age. */
+float AD5933_GetCachedTemperature(const AD5933_TempService *service,
+                                  unsigned long nowMs,
+                                  unsigned long *ageMs);
+
+#endif /* __AD5933_TEMPERATURE_H__ */
@@ -0,0 +1,165 @@
+/*
+Benchmark del driver sobre el simulador:
+transacciones de bus, sondeos de STATUS y tiempo
+de cada API publica, con presupuestos que fallan
+si una operacion gasta mas transacciones que antes.
+
+Correr solo estos tests: ceedling test:path[test/bench]
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Sim.h"
+#include "stdio.h"
+#include "time.h"
+
+/* Presupuestos de transacciones de bus por llamada, con el puntero de
+   direccion ya cargado y resultados instantaneos */
+#define PRESUPUESTO_CONFIG_SWEEP        1   // escritura en bloque
+#define PRESUPUESTO_START_SWEEP         5   // 4 comandos + 1 sondeo con datos
+#define PRESUPUESTO_TEMPERATURA         5   // comando + puntero + 1 sondeo
+                                            // + 2 bytes
+#define PRESUPUESTO_ARRANQUE            4   // STANDBY, reset, INIT y START
+#define PRESUPUESTO_POR_PUNTO           2   // sondeo con datos + INC_FREQ
+
+#define REPETICIONES                    200
+#define PUNTOS                          100
+
+static AD5933_Device dev;
+static AD5933_Sim    sim;
+static signed short  real[AD5933_MAX_POINTS];
+static signed short  imag[AD5933_MAX_POINTS];
+
+void setUp(void)
+{
+    AD5933_Sim_Init(&sim,0x0D);
+    AD5933_Init(&dev,0x0D);
+    AD5933_SIM_ATTACH();
+    // solo se mide el costo del driver
+    sim.conversionScale = 0;
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim);
+}
+
+static double tiempoUs(void)
+{
+    struct timespec ahora;
+
+    clock_gettime(CLOCK_MONOTONIC,&ahora);
+    return ahora.tv_sec * 1e6 + ahora.tv_nsec / 1e3;
+}
+
+static void informar(const char *nombre, unsigned long llamadas, double inicioUs)
+{
+    double total = tiempoUs() - inicioUs;
+
+    printf("%-24s %7.2f tx %6.2f rd %6.2f wr %6.2f polls %8.3f us/call %9.1f us bus\n",
+           nombre,
+           (double)sim.transactions / llamadas,
+           (double)sim.reads / llamadas,
+           (double)sim.writes / llamadas,
+           (double)sim.statusPolls / llamadas,
+           total / llamadas,
+           sim.nowNs / 1e3 / llamadas);
+}
+
+/* testeo el presupuesto de AD5933_ConfigSweep */
+void test_presupuestoConfigSweep(void)
+{
+    unsigned long llamada;
+    double        inicio;
+
+    AD5933_ConfigSweep(&dev,30000,10,PUNTOS - 1);
+    AD5933_Sim_ResetCounters(&sim);
+    AD5933_ConfigSweep(&dev,30001,10,PUNTOS - 1);
+    TEST_ASSERT_EQUAL_UINT32(PRESUPUESTO_CONFIG_SWEEP,sim.transactions);
+    // la misma configuracion no vuelve al bus
+    AD5933_Sim_ResetCounters(&sim);
+    AD5933_ConfigSweep(&dev,30001,10,PUNTOS - 1);
+    TEST_ASSERT_EQUAL_UINT32(0,sim.transactions);
+
+    AD5933_Sim_ResetCounters(&sim);
+    inicio = tiempoUs();
+    for(llamada = 0; llamada < REPETICIONES; llamada++)
+    {
+        AD5933_ConfigSweep(&dev,30000 + (llamada & 1),10,PUNTOS - 1);
+    }
+    informar("AD5933_ConfigSweep",REPETICIONES,inicio);
+    TEST_ASSERT_EQUAL_UINT32(PRESUPUESTO_CONFIG_SWEEP * REPETICIONES,sim.transactions);
+}
+
+/* testeo el presupuesto de AD5933_StartSweep */
+void test_presupuestoStartSweep(void)
+{
+    unsigned long llamada;
+    double        inicio;
+
+    AD5933_ConfigSweep(&dev,30000,10,PUNTOS - 1);
+    AD5933_StartSweep(&dev);
+    AD5933_Sim_ResetCounters(&sim);
+    inicio = tiempoUs();
+    for(llamada = 0; llamada < REPETICIONES; llamada++)
+    {
+        AD5933_StartSweep(&dev);
+    }
+    informar("AD5933_StartSweep",REPETICIONES,inicio);
+    TEST_ASSERT_EQUAL_UINT32(PRESUPUESTO_START_SWEEP * REPETICIONES,sim.transactions);
+    TEST_ASSERT_EQUAL_UINT32(REPETICIONES,sim.statusPolls);
+}
+
+/* testeo el presupuesto de AD5933_GetTemperature */
+void test_presupuestoTemperatura(void)
+{
+    unsigned long llamada;
+    double        inicio;
+
+    AD5933_Sim_ResetCounters(&sim);
+    inicio = tiempoUs();
+    for(llamada = 0; llamada < REPETICIONES; llamada++)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.1,25,AD5933_GetTemperature(&dev,0));
+    }
+    informar("AD5933_GetTemperature",REPETICIONES,inicio);
+    TEST_ASSERT_EQUAL_UINT32(PRESUPUESTO_TEMPERATURA * REPETICIONES,sim.transactions);
+}
+
+/* testeo el costo por punto de AD5933_RunSweep */
+void test_presupuestoPorPunto(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, AD5933_MAX_POINTS, 0};
+    unsigned long      llamada;
+    double             inicio;
+
+    AD5933_ConfigSweep(&dev,30000,10,PUNTOS - 1);
+    AD5933_StartSweep(&dev);
+    AD5933_Sim_ResetCounters(&sim);
+    inicio = tiempoUs();
+    for(llamada = 0; llamada < REPETICIONES; llamada++)
+    {
+        TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+        TEST_ASSERT_EQUAL_UINT16(PUNTOS,barrido.count);
+    }
+    informar("AD5933_RunSweep (punto)",REPETICIONES * PUNTOS,inicio);
+    // el ultimo punto no incrementa la frecuencia
+    TEST_ASSERT_EQUAL_UINT32((PRESUPUESTO_ARRANQUE + PRESUPUESTO_POR_PUNTO * PUNTOS - 1) *
+                             REPETICIONES,sim.transactions);
+    TEST_ASSERT_EQUAL_UINT32(PUNTOS * REPETICIONES,sim.statusPolls);
+}
+/* testeo los sondeos por punto con los tiempos de la hoja de datos */
+void test_sondeosTiempoReal(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, AD5933_MAX_POINTS, 0};
+    double             inicio;
+
+    sim.conversionScale = 1;
+    AD5933_ConfigSweep(&dev,30000,10,PUNTOS - 1);
+    AD5933_Sim_ResetCounters(&sim);
+    inicio = tiempoUs();
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    informar("AD5933_RunSweep (real)",PUNTOS,inicio);
+    // el sondeo ocupa el bus mientras el DFT corre
+    TEST_ASSERT_GREATER_THAN_UINT32(PUNTOS,sim.statusPolls);
+}
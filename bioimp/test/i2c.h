@@ -6,6 +6,8 @@
 
 bool i2c_Init( int i2c_add, unsigned char frecClock );
 bool wiringPiI2CWriteReg8(int i2cdevice,unsigned char writeD_0,unsigned char writeD_1);
+bool wiringPiI2CWriteBlockData(int i2cdevice,unsigned char command,const unsigned char *values,unsigned char size);
 int wiringPiI2CReadReg8(int i2cdevice,unsigned char registerAddress);
+int wiringPiI2CReadBlockData(int i2cdevice,unsigned char command,unsigned char *values,unsigned char size);
 
 #endif 
\ No newline at end of file
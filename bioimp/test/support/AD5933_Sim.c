@@ -0,0 +1,786 @@
+/***************************************************************************//**
+ *   @file   AD5933_Sim.c
+ *   @brief  Behavioral register-level simulator of the AD5933 for host tests.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include "AD5933_Sim.h"
+#include "AD5933.h"
+#include "math.h"
+#include "string.h"
+
+/******************************************************************************/
+/************************** Constants Definitions *****************************/
+/******************************************************************************/
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+#define SIM_DFT_SAMPLES     1024        // ADC samples of each DFT
+#define SIM_ADC_DIVIDER     16          // ADC sample rate is MCLK / 16
+#define SIM_TEMP_NS         800000ull   // Temperature conversion time
+#define SIM_TEMP_LSB        32          // Codes per degree Celsius
+
+static AD5933_Sim *simDevices[AD5933_SIM_MAX_DEVICES];
+static bool        simSubmitting;       // A batch is being run
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Finds the simulated device answering a handle.
+ *
+ * @param i2cdevice - I2C handle.
+ *
+ * @return Simulated device, or NULL if none answers.
+*******************************************************************************/
+static AD5933_Sim *AD5933_Sim_Find(int i2cdevice)
+{
+    unsigned char index = 0;
+
+    for(index = 0; index < AD5933_SIM_MAX_DEVICES; index++)
+    {
+        if((simDevices[index] != 0) &&
+           (simDevices[index]->i2cdevice == i2cdevice))
+        {
+            return simDevices[index];
+        }
+    }
+
+    return 0;
+}
+
+/***************************************************************************//**
+ * @brief Accounts one bus transaction, and the host call that made it
+ *        unless it is part of a batch, on the virtual clock.
+ *
+ * @param sim   - Simulated device.
+ * @param read  - true for a read transaction.
+ * @param bytes - Bytes on the bus after the address byte.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_Sim_Transaction(AD5933_Sim *sim,
+                                   bool read,
+                                   unsigned short bytes)
+{
+    // Each call costs the host a system call, a batch costs one
+    if(!simSubmitting)
+    {
+        sim->hostCalls++;
+        sim->nowNs += sim->callNs;
+    }
+    // On a shared bus the transaction waits for the previous ones
+    if((sim->busNs != 0) && (*sim->busNs > sim->nowNs))
+    {
+        sim->nowNs = *sim->busNs;
+    }
+    sim->transactions++;
+    sim->reads  += read ? 1 : 0;
+    sim->writes += read ? 0 : 1;
+    sim->bytes  += bytes;
+    sim->nowNs  += sim->transactionNs + bytes * sim->byteNs;
+    if(sim->busNs != 0)
+    {
+        *sim->busNs = sim->nowNs;
+    }
+}
+
+/***************************************************************************//**
+ * @brief Reads a big-endian register field.
+ *
+ * @param sim     - Simulated device.
+ * @param address - Address of the first byte.
+ * @param bytes   - Number of bytes.
+ *
+ * @return Value of the field.
+*******************************************************************************/
+static unsigned long AD5933_Sim_Field(const AD5933_Sim *sim,
+                                      unsigned char address,
+                                      unsigned char bytes)
+{
+    unsigned long value = 0;
+
+    while(bytes--)
+    {
+        value = (value << 8) | sim->regs[address++];
+    }
+
+    return value;
+}
+
+/***************************************************************************//**
+ * @brief System clock selected in the control register.
+ *
+ * @param sim - Simulated device.
+ *
+ * @return Clock frequency in Hz.
+*******************************************************************************/
+static double AD5933_Sim_Clock(const AD5933_Sim *sim)
+{
+    if(sim->regs[AD5933_REG_CONTROL_LB] & AD5933_CONTROL_EXT_SYSCLK)
+    {
+        return sim->extClk;
+    }
+
+    return AD5933_INTERNAL_SYS_CLK;
+}
+
+/***************************************************************************//**
+ * @brief Gaussian noise sample (xorshift and Box-Muller).
+ *
+ * @param sim - Simulated device.
+ *
+ * @return Sample with zero mean and unit variance.
+*******************************************************************************/
+static double AD5933_Sim_Gaussian(AD5933_Sim *sim)
+{
+    double        u[2];
+    unsigned char index = 0;
+
+    for(index = 0; index < 2; index++)
+    {
+        sim->seed ^= (sim->seed << 13) & 0xFFFFFFFFul;
+        sim->seed ^= sim->seed >> 17;
+        sim->seed ^= (sim->seed << 5) & 0xFFFFFFFFul;
+        u[index] = ((sim->seed & 0xFFFFFFFFul) + 1.0) / 4294967297.0;
+    }
+
+    return sqrt(-2 * log(u[0])) * cos(2 * M_PI * u[1]);
+}
+
+/***************************************************************************//**
+ * @brief Stores a DFT result at the output frequency. The magnitude is
+ *        inversely proportional to |Z| and scaled by range and PGA gain,
+ *        short of the transient still left after the settling cycles; the
+ *        phase follows the impedance phase plus the system phase, so the
+ *        datasheet formula (phase - system phase) gives the phase of Z.
+ *
+ * @param sim - Simulated device.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_Sim_Convert(AD5933_Sim *sim)
+{
+    static const double RANGE_SCALE[4] = {1.0, 0.1, 0.2, 0.5};
+    double        frequency = sim->freqCode * AD5933_Sim_Clock(sim) /
+                              (double)(1ul << AD5933_FREQ_CODE_SHIFT);
+    unsigned char control   = sim->regs[AD5933_REG_CONTROL_HB];
+    double        scale     = sim->dftScale * RANGE_SCALE[(control >> 1) & 0x3] *
+                              ((control & 0x1) ? 1 : 5);
+    double        zReal     = 0;
+    double        zImag     = 0;
+    double        magnitude = 0;
+    double        phase     = 0;
+    double        data[2];
+    unsigned char part      = 0;
+    long          value     = 0;
+
+    AD5933_Sim_Impedance(sim, frequency, &zReal, &zImag);
+    magnitude = sqrt(zReal * zReal + zImag * zImag);
+    magnitude = (magnitude > 0) ? (scale / magnitude) : 32767;
+    // What is left of the transient when the DFT starts
+    if(sim->settlingTau > 0)
+    {
+        magnitude *= 1 - exp(-sim->settledS / sim->settlingTau);
+    }
+    phase     = atan2(zImag, zReal) + sim->systemPhase;
+    data[0]   = magnitude * cos(phase);
+    data[1]   = magnitude * sin(phase);
+    for(part = 0; part < 2; part++)
+    {
+        if(sim->noise > 0)
+        {
+            data[part] += sim->noise * AD5933_Sim_Gaussian(sim);
+        }
+        value = lround(data[part]);
+        value = (value > 32767) ? 32767 : ((value < -32768) ? -32768 : value);
+        sim->regs[AD5933_REG_REAL_DATA + 2 * part]     = (unsigned char)(value >> 8);
+        sim->regs[AD5933_REG_REAL_DATA + 2 * part + 1] = (unsigned char)value;
+    }
+}
+
+/***************************************************************************//**
+ * @brief Completes the conversions whose time has come.
+ *
+ * @param sim - Simulated device.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_Sim_Update(AD5933_Sim *sim)
+{
+    unsigned short incNum = AD5933_Sim_Field(sim, AD5933_REG_INC_NUM, 2) &
+                            AD5933_MAX_INC_NUM;
+    long           code   = 0;
+
+    if(sim->measuring && (sim->nowNs >= sim->dataReadyNs))
+    {
+        AD5933_Sim_Convert(sim);
+        sim->measuring = false;
+        sim->measurements++;
+        sim->regs[AD5933_REG_STATUS] |= AD5933_STAT_DATA_VALID;
+        if(sim->sweeping && (sim->point >= incNum))
+        {
+            sim->regs[AD5933_REG_STATUS] |= AD5933_STAT_SWEEP_DONE;
+        }
+    }
+    if(sim->measuringTemp && (sim->nowNs >= sim->tempReadyNs))
+    {
+        code = lround(sim->temperature * SIM_TEMP_LSB) & 0x3FFF;
+        sim->regs[AD5933_REG_TEMP_DATA]     = (unsigned char)(code >> 8);
+        sim->regs[AD5933_REG_TEMP_DATA + 1] = (unsigned char)code;
+        sim->measuringTemp = false;
+        sim->regs[AD5933_REG_STATUS] |= AD5933_STAT_TEMP_VALID;
+    }
+}
+
+/***************************************************************************//**
+ * @brief Starts a DFT at the output frequency: settling cycles, then the
+ *        samples of the DFT.
+ *
+ * @param sim - Simulated device.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_Sim_StartConversion(AD5933_Sim *sim)
+{
+    static const unsigned char MULTIPLIER[4] = {1, 2, 1, 4};
+    unsigned short settling  = AD5933_Sim_Field(sim, AD5933_REG_SETTLING_CYCLES, 2);
+    double         clock     = AD5933_Sim_Clock(sim);
+    double         frequency = sim->freqCode * clock /
+                               (double)(1ul << AD5933_FREQ_CODE_SHIFT);
+    double         ns        = 0;
+
+    if(frequency > 0)
+    {
+        ns += (settling & AD5933_MAX_SETTLING_CYCLES) *
+              MULTIPLIER[(settling >> 9) & 0x3] * 1e9 / frequency;
+    }
+    sim->settledS = ns * 1e-9;
+    if(clock > 0)
+    {
+        ns += SIM_DFT_SAMPLES * SIM_ADC_DIVIDER * 1e9 / clock;
+    }
+    sim->regs[AD5933_REG_STATUS] &= ~(AD5933_STAT_DATA_VALID |
+                                      AD5933_STAT_SWEEP_DONE);
+    sim->measuring   = true;
+    sim->dataReadyNs = sim->nowNs +
+                       (unsigned long long)(ns * sim->conversionScale);
+}
+
+/***************************************************************************//**
+ * @brief Runs the control function written to the control register.
+ *
+ * @param sim      - Simulated device.
+ * @param function - AD5933_FUNCTION_x.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_Sim_Command(AD5933_Sim *sim, unsigned char function)
+{
+    unsigned short incNum = AD5933_Sim_Field(sim, AD5933_REG_INC_NUM, 2) &
+                            AD5933_MAX_INC_NUM;
+
+    sim->function = function;
+    switch(function)
+    {
+        case AD5933_FUNCTION_INIT_START_FREQ:
+            sim->freqCode  = AD5933_Sim_Field(sim, AD5933_REG_FREQ_START, 3);
+            sim->point     = 0;
+            sim->sweeping  = false;
+            sim->measuring = false;
+            sim->regs[AD5933_REG_STATUS] &= ~(AD5933_STAT_DATA_VALID |
+                                              AD5933_STAT_SWEEP_DONE);
+            break;
+        case AD5933_FUNCTION_START_SWEEP:
+            sim->freqCode = AD5933_Sim_Field(sim, AD5933_REG_FREQ_START, 3);
+            sim->point    = 0;
+            sim->sweeping = true;
+            AD5933_Sim_StartConversion(sim);
+            break;
+        case AD5933_FUNCTION_INC_FREQ:
+            if(sim->point < incNum)
+            {
+                sim->point++;
+                sim->freqCode += AD5933_Sim_Field(sim, AD5933_REG_FREQ_INC, 3);
+            }
+            AD5933_Sim_StartConversion(sim);
+            break;
+        case AD5933_FUNCTION_REPEAT_FREQ:
+            AD5933_Sim_StartConversion(sim);
+            break;
+        case AD5933_FUNCTION_MEASURE_TEMP:
+            sim->regs[AD5933_REG_STATUS] &= ~AD5933_STAT_TEMP_VALID;
+            sim->measuringTemp = true;
+            sim->tempReadyNs   = sim->nowNs +
+                                 (unsigned long long)(SIM_TEMP_NS *
+                                                      sim->conversionScale);
+            break;
+        case AD5933_FUNCTION_POWER_DOWN:
+        case AD5933_FUNCTION_STANDBY:
+            sim->measuring = false;
+            sim->sweeping  = false;
+            sim->regs[AD5933_REG_STATUS] &= ~(AD5933_STAT_DATA_VALID |
+                                              AD5933_STAT_SWEEP_DONE);
+            break;
+        default:
+            break;
+    }
+}
+
+/***************************************************************************//**
+ * @brief Writes one register. Read-only registers ignore the write.
+ *
+ * @param sim     - Simulated device.
+ * @param address - Register address.
+ * @param value   - Byte written.
+ *
+ * @return None.
+*******************************************************************************/
+static void AD5933_Sim_WriteRegister(AD5933_Sim *sim,
+                                     unsigned char address,
+                                     unsigned char value)
+{
+    if((address < AD5933_REG_CONTROL_HB) ||
+       (address >= AD5933_REG_CONTROL_HB + AD5933_SHADOW_SIZE))
+    {
+        return;
+    }
+    if(address == AD5933_REG_CONTROL_LB)
+    {
+        // The reset bit clears itself
+        sim->regs[address] = value & ~AD5933_CONTROL_RESET;
+        if(value & AD5933_CONTROL_RESET)
+        {
+            sim->measuring     = false;
+            sim->sweeping      = false;
+            sim->measuringTemp = false;
+            sim->point         = 0;
+            sim->regs[AD5933_REG_STATUS] = 0;
+        }
+        return;
+    }
+    sim->regs[address] = value;
+    if(address == AD5933_REG_CONTROL_HB)
+    {
+        AD5933_Sim_Command(sim, value >> 4);
+    }
+}
+
+/***************************************************************************//**
+ * @brief Initializes a simulated device at power-on (powered down, 1 kohm
+ *        resistor, datasheet timing on a 400 kHz bus) and makes it answer a
+ *        handle, replacing any other device on the same handle.
+ *
+ * @param sim       - Simulated device.
+ * @param i2cdevice - I2C handle to answer.
+ *
+ * @return false if AD5933_SIM_MAX_DEVICES devices are already attached.
+*******************************************************************************/
+bool AD5933_Sim_Init(AD5933_Sim *sim, int i2cdevice)
+{
+    unsigned char index = 0;
+    unsigned char free  = AD5933_SIM_MAX_DEVICES;
+
+    memset(sim, 0, sizeof(*sim));
+    sim->i2cdevice       = i2cdevice;
+    sim->load.r0         = 1000;
+    sim->load.alpha      = 1;
+    sim->dftScale        = 1e7;
+    sim->temperature     = 25;
+    sim->conversionScale = 1;
+    sim->transactionNs   = AD5933_SIM_TRANSACTION_NS;
+    sim->byteNs          = AD5933_SIM_BYTE_NS;
+    sim->seed            = 2463534242ul;
+    sim->regs[AD5933_REG_CONTROL_HB] =
+        AD5933_CONTROL_FUNCTION(AD5933_FUNCTION_POWER_DOWN);
+    for(index = 0; index < AD5933_SIM_MAX_DEVICES; index++)
+    {
+        if((simDevices[index] == 0) || (simDevices[index] == sim) ||
+           (simDevices[index]->i2cdevice == i2cdevice))
+        {
+            simDevices[index] = 0;
+            free = (free == AD5933_SIM_MAX_DEVICES) ? index : free;
+        }
+    }
+    if(free == AD5933_SIM_MAX_DEVICES)
+    {
+        return false;
+    }
+    simDevices[free] = sim;
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Stops a simulated device from answering its handle.
+ *
+ * @param sim - Simulated device.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_Sim_Detach(AD5933_Sim *sim)
+{
+    unsigned char index = 0;
+
+    for(index = 0; index < AD5933_SIM_MAX_DEVICES; index++)
+    {
+        if(simDevices[index] == sim)
+        {
+            simDevices[index] = 0;
+        }
+    }
+}
+
+/***************************************************************************//**
+ * @brief Sets an RC load: a resistor in parallel with a capacitor.
+ *
+ * @param sim         - Simulated device.
+ * @param resistance  - Resistance in ohms.
+ * @param capacitance - Capacitance in farads.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_Sim_SetRC(AD5933_Sim *sim, double resistance, double capacitance)
+{
+    sim->load.r0    = resistance;
+    sim->load.rInf  = 0;
+    sim->load.tau   = resistance * capacitance;
+    sim->load.alpha = 1;
+}
+
+/***************************************************************************//**
+ * @brief Returns the impedance of the Cole load at a frequency.
+ *
+ * @param sim       - Simulated device.
+ * @param frequency - Frequency in Hz.
+ * @param real      - Real part in ohms.
+ * @param imag      - Imaginary part in ohms.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_Sim_Impedance(const AD5933_Sim *sim,
+                          double frequency,
+                          double *real,
+                          double *imag)
+{
+    const AD5933_SimLoad *load  = &sim->load;
+    double                power = pow(2 * M_PI * frequency * load->tau,
+                                      load->alpha);
+    double                den_r = 1 + power * cos(load->alpha * M_PI / 2);
+    double                den_i = power * sin(load->alpha * M_PI / 2);
+    double                den   = den_r * den_r + den_i * den_i;
+
+    *real = load->rInf + (load->r0 - load->rInf) * den_r / den;
+    *imag = -(load->r0 - load->rInf) * den_i / den;
+}
+
+/***************************************************************************//**
+ * @brief Clears the bus counters and the virtual clock. Conversions in
+ *        progress keep their remaining time.
+ *
+ * @param sim - Simulated device.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_Sim_ResetCounters(AD5933_Sim *sim)
+{
+    sim->dataReadyNs  = (sim->dataReadyNs > sim->nowNs) ?
+                        (sim->dataReadyNs - sim->nowNs) : 0;
+    sim->tempReadyNs  = (sim->tempReadyNs > sim->nowNs) ?
+                        (sim->tempReadyNs - sim->nowNs) : 0;
+    sim->nowNs        = 0;
+    sim->transactions = 0;
+    sim->hostCalls    = 0;
+    sim->reads        = 0;
+    sim->writes       = 0;
+    sim->statusPolls  = 0;
+    sim->bytes        = 0;
+    sim->measurements = 0;
+}
+
+/***************************************************************************//**
+ * @brief Advances the virtual clock, as if the host waited.
+ *
+ * @param sim - Simulated device.
+ * @param ns  - Nanoseconds.
+ *
+ * @return None.
+*******************************************************************************/
+void AD5933_Sim_Advance(AD5933_Sim *sim, unsigned long long ns)
+{
+    sim->nowNs += ns;
+}
+
+/***************************************************************************//**
+ * @brief Byte write: sets the address pointer (AD5933_ADDR_POINTER) or
+ *        writes a register.
+ *
+ * @param i2cdevice - I2C handle.
+ * @param command   - Register address or AD5933_ADDR_POINTER.
+ * @param data      - Byte written.
+ * @param numCalls  - Unused, part of the callback signature.
+ *
+ * @return false if no device answers the handle.
+*******************************************************************************/
+bool AD5933_Sim_WriteReg8(int i2cdevice,
+                          unsigned char command,
+                          unsigned char data,
+                          int numCalls)
+{
+    AD5933_Sim *sim = AD5933_Sim_Find(i2cdevice);
+
+    (void)numCalls;
+    if(sim == 0)
+    {
+        return false;
+    }
+    AD5933_Sim_Transaction(sim, false, 2);
+    AD5933_Sim_Update(sim);
+    if(command == AD5933_ADDR_POINTER)
+    {
+        sim->addrPointer = data;
+    }
+    else
+    {
+        AD5933_Sim_WriteRegister(sim, command, data);
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Byte read of a register. Like the part, it leaves the address
+ *        pointer at that register.
+ *
+ * @param i2cdevice - I2C handle.
+ * @param command   - Register address.
+ * @param numCalls  - Unused, part of the callback signature.
+ *
+ * @return Register value, or -1 if no device answers the handle.
+*******************************************************************************/
+int AD5933_Sim_ReadReg8(int i2cdevice,
+                        unsigned char command,
+                        int numCalls)
+{
+    AD5933_Sim *sim = AD5933_Sim_Find(i2cdevice);
+
+    (void)numCalls;
+    if(sim == 0)
+    {
+        return -1;
+    }
+    AD5933_Sim_Transaction(sim, true, 3);
+    AD5933_Sim_Update(sim);
+    sim->addrPointer  = command;
+    sim->statusPolls += (command == AD5933_REG_STATUS) ? 1 : 0;
+
+    return sim->regs[command];
+}
+
+/***************************************************************************//**
+ * @brief Block write from the address pointer.
+ *
+ * @param i2cdevice - I2C handle.
+ * @param command   - AD5933_BLOCK_WRITE.
+ * @param values    - Bytes to write.
+ * @param size      - Number of bytes.
+ * @param numCalls  - Unused, part of the callback signature.
+ *
+ * @return false if no device answers or the command is not a block write.
+*******************************************************************************/
+bool AD5933_Sim_WriteBlockData(int i2cdevice,
+                               unsigned char command,
+                               const unsigned char *values,
+                               unsigned char size,
+                               int numCalls)
+{
+    AD5933_Sim    *sim  = AD5933_Sim_Find(i2cdevice);
+    unsigned char  byte = 0;
+
+    (void)numCalls;
+    if((sim == 0) || (command != AD5933_BLOCK_WRITE))
+    {
+        return false;
+    }
+    AD5933_Sim_Transaction(sim, false, 2 + size);
+    AD5933_Sim_Update(sim);
+    for(byte = 0; byte < size; byte++)
+    {
+        AD5933_Sim_WriteRegister(sim, sim->addrPointer + byte, values[byte]);
+    }
+
+    return true;
+}
+
+/***************************************************************************//**
+ * @brief Block read from the address pointer.
+ *
+ * @param i2cdevice - I2C handle.
+ * @param command   - AD5933_BLOCK_READ.
+ * @param values    - Buffer for the bytes read.
+ * @param size      - Number of bytes.
+ * @param numCalls  - Unused, part of the callback signature.
+ *
+ * @return Number of bytes read, or -1 on error.
+*******************************************************************************/
+int AD5933_Sim_ReadBlockData(int i2cdevice,
+                             unsigned char command,
+                             unsigned char *values,
+                             unsigned char size,
+                             int numCalls)
+{
+    AD5933_Sim    *sim  = AD5933_Sim_Find(i2cdevice);
+    unsigned char  byte = 0;
+
+    (void)numCalls;
+    if((sim == 0) || (command != AD5933_BLOCK_READ))
+    {
+        return -1;
+    }
+    AD5933_Sim_Transaction(sim, true, 3 + size);
+    AD5933_Sim_Update(sim);
+    if((sim->addrPointer <= AD5933_REG_STATUS) &&
+       (sim->addrPointer + size > AD5933_REG_STATUS))
+    {
+        sim->statusPolls++;
+    }
+    for(byte = 0; byte < size; byte++)
+    {
+        values[byte] = sim->regs[(unsigned char)(sim->addrPointer + byte)];
+    }
+
+    return size;
+}
+
+/***************************************************************************//**
+ * @brief Runs a batch of bus operations in order as one host call, like an
+ *        I2C_RDWR transfer: the operations after a failed one are not run.
+ *
+ * @param i2cdevice - I2C handle.
+ * @param ops       - Operations.
+ * @param count     - Number of operations.
+ *
+ * @return false if no device answers or an operation failed.
+*******************************************************************************/
+bool AD5933_Sim_Submit(int i2cdevice,
+                       const AD5933_BusOp *ops,
+                       unsigned char count)
+{
+    AD5933_Sim    *sim    = AD5933_Sim_Find(i2cdevice);
+    unsigned char  index  = 0;
+    int            result = 1;
+
+    if(sim == 0)
+    {
+        return false;
+    }
+    sim->hostCalls++;
+    sim->nowNs   += sim->callNs;
+    simSubmitting = true;
+    for(index = 0; (index < count) && (result >= 0); index++)
+    {
+        switch(ops[index].type)
+        {
+            case AD5933_BUS_WRITE_REG8:
+                result = AD5933_Sim_WriteReg8(i2cdevice, ops[index].command,
+                                              ops[index].data[0], 0) ? 1 : -1;
+                break;
+            case AD5933_BUS_READ_REG8:
+                result = AD5933_Sim_ReadReg8(i2cdevice, ops[index].command, 0);
+                if(result >= 0)
+                {
+                    ops[index].readData[0] = (unsigned char)result;
+                }
+                break;
+            case AD5933_BUS_WRITE_BLOCK:
+                result = AD5933_Sim_WriteBlockData(i2cdevice, ops[index].command,
+                                                   ops[index].data,
+                                                   ops[index].size, 0) ? 1 : -1;
+                break;
+            default:
+                result = AD5933_Sim_ReadBlockData(i2cdevice, ops[index].command,
+                                                  ops[index].readData,
+                                                  ops[index].size, 0);
+                break;
+        }
+    }
+    simSubmitting = false;
+
+    return result >= 0;
+}
+
+/******************************************************************************/
+/********************* Transport on top of the simulator **********************/
+/******************************************************************************/
+
+static bool AD5933_Sim_TransportWriteReg8(int i2cdevice, unsigned char command,
+                                          unsigned char data)
+{
+    return AD5933_Sim_WriteReg8(i2cdevice, command, data, 0);
+}
+
+static int AD5933_Sim_TransportReadReg8(int i2cdevice, unsigned char command)
+{
+    return AD5933_Sim_ReadReg8(i2cdevice, command, 0);
+}
+
+static bool AD5933_Sim_TransportWriteBlock(int i2cdevice, unsigned char command,
+                                           const unsigned char *values,
+                                           unsigned char size)
+{
+    return AD5933_Sim_WriteBlockData(i2cdevice, command, values, size, 0);
+}
+
+static int AD5933_Sim_TransportReadBlock(int i2cdevice, unsigned char command,
+                                         unsigned char *values,
+                                         unsigned char size)
+{
+    return AD5933_Sim_ReadBlockData(i2cdevice, command, values, size, 0);
+}
+
+const AD5933_Transport AD5933_SIM_TRANSPORT = {
+    AD5933_Sim_TransportWriteReg8,
+    AD5933_Sim_TransportReadReg8,
+    AD5933_Sim_TransportWriteBlock,
+    AD5933_Sim_TransportReadBlock,
+    AD5933_Sim_Submit
+};
+
+#ifdef AD5933_SIM_I2C
+/******************************************************************************/
+/********************** i2c.h on top of the simulator *************************/
+/******************************************************************************/
+#include "i2c.h"
+
+bool i2c_Init(int i2c_add, unsigned char frecClock)
+{
+    (void)frecClock;
+
+    return AD5933_Sim_Find(i2c_add) != 0;
+}
+
+bool wiringPiI2CWriteReg8(int i2cdevice, unsigned char writeD_0, unsigned char writeD_1)
+{
+    return AD5933_Sim_WriteReg8(i2cdevice, writeD_0, writeD_1, 0);
+}
+
+bool wiringPiI2CWriteBlockData(int i2cdevice, unsigned char command,
+                               const unsigned char *values, unsigned char size)
+{
+    return AD5933_Sim_WriteBlockData(i2cdevice, command, values, size, 0);
+}
+
+int wiringPiI2CReadReg8(int i2cdevice, unsigned char registerAddress)
+{
+    return AD5933_Sim_ReadReg8(i2cdevice, registerAddress, 0);
+}
+
+int wiringPiI2CReadBlockData(int i2cdevice, unsigned char command,
+                             unsigned char *values, unsigned char size)
+{
+    return AD5933_Sim_ReadBlockData(i2cdevice, command, values, size, 0);
+}
+#endif /* AD5933_SIM_I2C */
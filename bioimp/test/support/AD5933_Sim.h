@@ -0,0 +1,154 @@
+/***************************************************************************//**
+ *   @file   AD5933_Sim.h
+ *   @brief  Behavioral register-level simulator of the AD5933 for host tests.
+ *
+ *   The simulator answers the calls of i2c.h like the part would: register
+ *   map, address pointer and block commands, control function state machine,
+ *   status bits, a Cole (or RC) load and the conversion and bus times, kept
+ *   on a virtual clock. Its bus functions have the CMock callback signature,
+ *   so a test routes the mock through it with AD5933_SIM_ATTACH(). Building
+ *   AD5933_Sim.c with AD5933_SIM_I2C defined also provides i2c.h itself.
+*******************************************************************************/
+
+#ifndef __AD5933_SIM_H__
+#define __AD5933_SIM_H__
+
+#include "stdbool.h"
+#include "AD5933.h"
+
+/******************************************************************************/
+/************************** Simulator Definitions *****************************/
+/******************************************************************************/
+
+#define AD5933_SIM_MAX_DEVICES      8       // Simulated devices at a time
+#define AD5933_SIM_REG_SIZE         256     // Whole 8-bit register space
+
+/* Default bus timing: 400 kHz I2C, 9 bits per byte */
+#define AD5933_SIM_TRANSACTION_NS   50000ull    // Start, address and stop
+#define AD5933_SIM_BYTE_NS          22500ull    // One byte on the bus
+
+/* Routes the i2c mock through the simulator (needs mock_i2c.h) */
+#define AD5933_SIM_ATTACH() \
+    do { \
+        wiringPiI2CWriteReg8_StubWithCallback(AD5933_Sim_WriteReg8); \
+        wiringPiI2CReadReg8_StubWithCallback(AD5933_Sim_ReadReg8); \
+        wiringPiI2CWriteBlockData_StubWithCallback(AD5933_Sim_WriteBlockData); \
+        wiringPiI2CReadBlockData_StubWithCallback(AD5933_Sim_ReadBlockData); \
+    } while(0)
+
+/******************************************************************************/
+/**************************** Simulator Types *********************************/
+/******************************************************************************/
+
+/* Cole load: Z = rInf + (r0 - rInf) / (1 + (j * w * tau)^alpha).
+   A resistor R in parallel with C is r0 = R, rInf = 0, tau = R * C,
+   alpha = 1; a plain resistor has tau = 0. */
+typedef struct {
+    double r0;                  // Resistance at DC (ohms)
+    double rInf;                // Resistance at infinite frequency (ohms)
+    double tau;                 // Time constant (s)
+    double alpha;               // Dispersion, 0 < alpha <= 1
+} AD5933_SimLoad;
+
+/* One simulated device. Fields marked (config) may be changed by the test
+   after AD5933_Sim_Init; the rest is state. */
+typedef struct {
+    int                i2cdevice;           // I2C handle answered
+    AD5933_SimLoad     load;                // (config) Connected load
+    double             dftScale;            // (config) |DFT| * |Z| at 2 Vpp x1
+    double             systemPhase;         // (config) Phase added by the path
+    double             noise;               // (config) Noise sigma in counts
+    double             temperature;         // (config) Die temperature (C)
+    double             conversionScale;     // (config) 1 = datasheet times,
+                                            //          0 = instant results
+    double             settlingTau;         // (config) Decay of the load
+                                            //          transient (s), 0 = none
+    unsigned long      extClk;              // (config) External clock (Hz)
+    unsigned long long transactionNs;       // (config) Cost of a transaction
+    unsigned long long byteNs;              // (config) Cost of each byte
+    unsigned long long callNs;              // (config) Host cost of each bus
+                                            //          call (system call), 0
+    unsigned long      seed;                // (config) Noise generator state
+    unsigned long long *busNs;              // (config) Clock of a bus shared
+                                            //          with other devices,
+                                            //          NULL = own bus
+    unsigned char      regs[AD5933_SIM_REG_SIZE];   // Register map
+    unsigned char      addrPointer;         // Address pointer
+    unsigned char      function;            // Last control function
+    bool               measuring;           // A DFT is in progress
+    bool               sweeping;            // START_SWEEP was issued
+    unsigned long      freqCode;            // Code of the output frequency
+    unsigned short     point;               // Increments since START_SWEEP
+    unsigned long long dataReadyNs;         // End of the DFT in progress
+    double             settledS;            // Settling time of that DFT (s)
+    unsigned long long tempReadyNs;         // End of the temperature measure
+    bool               measuringTemp;       // A temperature measure is pending
+    unsigned long long nowNs;               // Virtual time
+    unsigned long      transactions;        // Bus transactions
+    unsigned long      hostCalls;           // Bus calls of the host; a batch
+                                            // submitted at once is one call
+    unsigned long      reads;               // Read transactions
+    unsigned long      writes;              // Write transactions
+    unsigned long      statusPolls;         // Reads that include STATUS
+    unsigned long      bytes;               // Bytes after the address byte
+    unsigned long      measurements;        // DFTs completed
+} AD5933_Sim;
+
+/******************************************************************************/
+/************************ Variables Declarations ******************************/
+/******************************************************************************/
+
+/*! Backend that reaches the simulator without the mock and submits batches
+    in one call, like the i2c-dev backend. */
+extern const AD5933_Transport AD5933_SIM_TRANSPORT;
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/*! Initializes a simulated device at power-on and makes it answer a handle. */
+bool AD5933_Sim_Init(AD5933_Sim *sim, int i2cdevice);
+
+/*! Stops a simulated device from answering its handle. */
+void AD5933_Sim_Detach(AD5933_Sim *sim);
+
+/*! Sets an RC load: a resistor in parallel with a capacitor. */
+void AD5933_Sim_SetRC(AD5933_Sim *sim, double resistance, double capacitance);
+
+/*! Returns the impedance of the load at a frequency. */
+void AD5933_Sim_Impedance(const AD5933_Sim *sim,
+                          double frequency,
+                          double *real,
+                          double *imag);
+
+/*! Clears the bus counters and the virtual clock. */
+void AD5933_Sim_ResetCounters(AD5933_Sim *sim);
+
+/*! Advances the virtual clock, as if the host waited. */
+void AD5933_Sim_Advance(AD5933_Sim *sim, unsigned long long ns);
+
+/*! Runs a batch of bus operations as one host call. */
+bool AD5933_Sim_Submit(int i2cdevice,
+                       const AD5933_BusOp *ops,
+                       unsigned char count);
+
+/*! Bus functions, with the signature of the CMock callbacks of i2c.h. */
+bool AD5933_Sim_WriteReg8(int i2cdevice,
+                          unsigned char command,
+                          unsigned char data,
+                          int numCalls);
+int  AD5933_Sim_ReadReg8(int i2cdevice,
+                         unsigned char command,
+                         int numCalls);
+bool AD5933_Sim_WriteBlockData(int i2cdevice,
+                               unsigned char command,
+                               const unsigned char *values,
+                               unsigned char size,
+                               int numCalls);
+int  AD5933_Sim_ReadBlockData(int i2cdevice,
+                              unsigned char command,
+                              unsigned char *values,
+                              unsigned char size,
+                              int numCalls);
+
+#endif /* __AD5933_SIM_H__ */
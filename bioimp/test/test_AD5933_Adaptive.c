@@ -0,0 +1,133 @@
+/*
+Barrido adaptivo:
+una pasada gruesa y sub-barridos de refinamiento
+solo donde la impedancia cambia rapido.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Adaptive.h"
+#include "AD5933_Sim.h"
+#include "math.h"
+
+#define PUNTOS  400
+
+static AD5933_Sim          sim;
+static AD5933_Device       dev;
+static AD5933_AdaptivePlan plan;
+static signed short        real[PUNTOS];
+static signed short        imag[PUNTOS];
+static unsigned long       codigos[PUNTOS];
+
+void setUp(void)
+{
+    AD5933_Sim_Init(&sim,0x0D);
+    AD5933_Init(&dev,0x0D);
+    AD5933_SIM_ATTACH();
+    sim.conversionScale = 0;
+    plan.startFreq          = 1000;
+    plan.stopFreq           = 100000;
+    plan.coarsePoints       = 12;
+    plan.refinePoints       = 3;
+    plan.maxDepth           = 5;
+    plan.magnitudeStep      = 0.05f;
+    plan.phaseStep          = 0.05f;
+    plan.settlingCycles     = 15;
+    plan.settlingMultiplier = AD5933_SETTLING_X1;
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim);
+}
+
+/* testeo que una carga plana solo cuesta la pasada gruesa */
+void test_cargaPlana(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, PUNTOS, 0};
+
+    AD5933_Sim_SetRC(&sim,1000,0);
+    TEST_ASSERT_TRUE(AD5933_RunAdaptiveSweep(&dev,&plan,&barrido,codigos));
+    TEST_ASSERT_EQUAL_UINT16(12,barrido.count);
+    TEST_ASSERT_EQUAL_UINT32(12,sim.measurements);
+    TEST_ASSERT_EQUAL_HEX32(AD5933_INT_FREQ_CODE(1000),codigos[0]);
+    TEST_ASSERT_UINT32_WITHIN(11,AD5933_INT_FREQ_CODE(100000),codigos[11]);
+}
+
+/* testeo que los puntos se concentran en la dispersion y la curva se mantiene */
+void test_dispersion(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, PUNTOS, 0};
+    unsigned short     punto   = 0;
+    unsigned long      frecuencia = 0;
+    double             f0 = 0;
+    double             f1 = 0;
+    double             m0 = 0;
+    double             m1 = 0;
+    double             zReal = 0;
+    double             zImag = 0;
+    double             esperado = 0;
+    double             medido = 0;
+    unsigned short     bajos = 0;
+
+    // carga de Cole de 2 kohm a 500 ohm con la dispersion cerca de 8 kHz
+    sim.load.r0    = 2000;
+    sim.load.rInf  = 500;
+    sim.load.tau   = 2e-5;
+    sim.load.alpha = 1;
+    TEST_ASSERT_TRUE(AD5933_RunAdaptiveSweep(&dev,&plan,&barrido,codigos));
+    TEST_ASSERT_TRUE(barrido.count > 12);
+    TEST_ASSERT_EQUAL_UINT32(barrido.count,sim.measurements);
+    for(punto = 1; punto < barrido.count; punto++)
+    {
+        TEST_ASSERT_TRUE(codigos[punto] > codigos[punto - 1]);
+        if(codigos[punto] < AD5933_INT_FREQ_CODE(20000))
+        {
+            bajos++;
+        }
+    }
+    // la mayoria de los puntos estan por debajo de 20 kHz
+    TEST_ASSERT_TRUE(bajos > barrido.count / 2);
+
+    // un barrido lineal con el paso mas fino necesitaria muchos mas puntos
+    f0 = codigos[barrido.count - 1];
+    for(punto = 1; punto < barrido.count; punto++)
+    {
+        f1 = codigos[punto] - codigos[punto - 1];
+        f0 = (f1 < f0) ? f1 : f0;
+    }
+    TEST_ASSERT_TRUE(4 * barrido.count <
+                     (codigos[barrido.count - 1] - codigos[0]) / f0);
+
+    // interpolando linealmente el modulo sigue a la carga con error < 2 %
+    punto = 1;
+    for(frecuencia = 1000; frecuencia <= 99000; frecuencia += 250)
+    {
+        while(AD5933_CodeToFrequency(codigos[punto],16000000ul) < frecuencia * 1000)
+        {
+            punto++;
+        }
+        f0 = AD5933_CodeToFrequency(codigos[punto - 1],16000000ul) / 1000.0;
+        f1 = AD5933_CodeToFrequency(codigos[punto],16000000ul) / 1000.0;
+        m0 = sqrt((double)real[punto - 1] * real[punto - 1] +
+                  (double)imag[punto - 1] * imag[punto - 1]);
+        m1 = sqrt((double)real[punto] * real[punto] +
+                  (double)imag[punto] * imag[punto]);
+        medido = m0 + (m1 - m0) * (frecuencia - f0) / (f1 - f0);
+        AD5933_Sim_Impedance(&sim,frecuencia,&zReal,&zImag);
+        esperado = sim.dftScale / sqrt(zReal * zReal + zImag * zImag);
+        TEST_ASSERT_DOUBLE_WITHIN(0.02 * esperado,esperado,medido);
+    }
+}
+
+/* testeo un plan invalido */
+void test_planInvalido(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, 4, 0};
+
+    TEST_ASSERT_FALSE(AD5933_RunAdaptiveSweep(&dev,&plan,&barrido,codigos));
+    barrido.capacity = PUNTOS;
+    plan.stopFreq    = plan.startFreq;
+    TEST_ASSERT_FALSE(AD5933_RunAdaptiveSweep(&dev,&plan,&barrido,codigos));
+    TEST_ASSERT_EQUAL_UINT32(0,sim.measurements);
+}
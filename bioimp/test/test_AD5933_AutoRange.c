@@ -0,0 +1,183 @@
+/*
+Seleccion automatica de rango y ganancia:
+cada banda del barrido se mide con la combinacion
+que no satura ni queda en el piso de ruido.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_AutoRange.h"
+#include "AD5933_Calibration.h"
+#include "AD5933_Kernel.h"
+#include "AD5933_Sim.h"
+#include "math.h"
+#include "stdlib.h"
+
+#define PUNTOS  100
+
+static AD5933_Sim          sim;
+static AD5933_Device       dev;
+static AD5933_SweepProfile perfil;
+static AD5933_RangeCache   cache;
+static signed short        real[PUNTOS];
+static signed short        imag[PUNTOS];
+
+void setUp(void)
+{
+    AD5933_Sim_Init(&sim,0x0D);
+    AD5933_Init(&dev,0x0D);
+    AD5933_SIM_ATTACH();
+    sim.conversionScale = 0;
+    // 1 kHz a 100 kHz: |Z| baja de 16 kohm a 300 ohm
+    AD5933_Sim_SetRC(&sim,20000,5.3e-9);
+    AD5933_CompileSweepProfile(&dev,&perfil,1000,1000,PUNTOS - 1,15,AD5933_SETTLING_X1);
+    AD5933_InitRangeCache(&cache,10);
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim);
+}
+
+/* testeo que ninguna banda queda saturada ni en el piso de ruido */
+static void verificarBandas(void)
+{
+    unsigned short punto = 0;
+    unsigned char  banda = 0;
+    unsigned char  rango = 0;
+    unsigned char  ganancia = 0;
+    double         pico  = 0;
+    double         modulo = 0;
+
+    for(banda = 0; banda < 10; banda++)
+    {
+        pico = 0;
+        for(punto = banda * 10; punto < banda * 10 + 10; punto++)
+        {
+            TEST_ASSERT_TRUE(abs(real[punto]) < AD5933_AUTORANGE_CLIP);
+            TEST_ASSERT_TRUE(abs(imag[punto]) < AD5933_AUTORANGE_CLIP);
+            modulo = sqrt((double)real[punto] * real[punto] +
+                          (double)imag[punto] * imag[punto]);
+            pico = (modulo > pico) ? modulo : pico;
+        }
+        AD5933_GetPointRange(&cache,banda * 10,&rango,&ganancia);
+        // en el piso solo si ya esta en el nivel mas fuerte
+        TEST_ASSERT_TRUE((pico >= AD5933_AUTORANGE_FLOOR) ||
+                         (cache.level[banda] == AD5933_AUTORANGE_LEVELS - 1));
+    }
+}
+
+/* testeo el primer barrido, que reintenta solo las bandas que cambian */
+void test_primerBarrido(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, PUNTOS, 0};
+    unsigned char      rango   = 0;
+    unsigned char      ganancia = 0;
+
+    TEST_ASSERT_TRUE(AD5933_RunAutoRangedSweep(&dev,&perfil,&cache,&barrido));
+    TEST_ASSERT_EQUAL_UINT16(PUNTOS,barrido.count);
+    TEST_ASSERT_TRUE(cache.changed > 0);
+    TEST_ASSERT_TRUE(cache.changed < 10);
+    verificarBandas();
+
+    // 100 kHz: 300 ohm satura en 2 Vpp x1, se baja
+    AD5933_GetPointRange(&cache,PUNTOS - 1,&rango,&ganancia);
+    TEST_ASSERT_EQUAL_HEX8(AD5933_GAIN_X1,ganancia);
+    TEST_ASSERT_TRUE(rango != AD5933_RANGE_2000mVpp);
+    // el rango del dispositivo no cambia
+    TEST_ASSERT_EQUAL_HEX8(AD5933_RANGE_2000mVpp,dev.range);
+}
+
+/* testeo que una carga alta sube todas las bandas al nivel mas fuerte */
+void test_cargaAlta(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, PUNTOS, 0};
+    unsigned char      rango   = 0;
+    unsigned char      ganancia = 0;
+
+    // 50 kohm da 200 cuentas en 2 Vpp x1
+    AD5933_Sim_SetRC(&sim,50000,0);
+    TEST_ASSERT_TRUE(AD5933_RunAutoRangedSweep(&dev,&perfil,&cache,&barrido));
+    TEST_ASSERT_EQUAL_UINT8(10,cache.changed);
+    AD5933_GetPointRange(&cache,0,&rango,&ganancia);
+    TEST_ASSERT_EQUAL_HEX8(AD5933_RANGE_2000mVpp,rango);
+    TEST_ASSERT_EQUAL_HEX8(AD5933_GAIN_X5,ganancia);
+    TEST_ASSERT_INT16_WITHIN(2,1000,real[PUNTOS - 1]);
+    verificarBandas();
+}
+
+/* testeo que el segundo barrido del mismo perfil usa la cache sin reintentos */
+void test_barridoConCache(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, PUNTOS, 0};
+    unsigned long      primero = 0;
+
+    TEST_ASSERT_TRUE(AD5933_RunAutoRangedSweep(&dev,&perfil,&cache,&barrido));
+    primero = sim.measurements;
+    AD5933_Sim_ResetCounters(&sim);
+    sim.measurements = 0;
+    TEST_ASSERT_TRUE(AD5933_RunAutoRangedSweep(&dev,&perfil,&cache,&barrido));
+    TEST_ASSERT_EQUAL_UINT8(0,cache.changed);
+    TEST_ASSERT_EQUAL_UINT32(PUNTOS,sim.measurements);
+    TEST_ASSERT_TRUE(primero > PUNTOS);
+    verificarBandas();
+
+    // si la carga cambia, solo se reintentan las bandas afectadas
+    AD5933_Sim_SetRC(&sim,20000,2.65e-9);
+    sim.measurements = 0;
+    TEST_ASSERT_TRUE(AD5933_RunAutoRangedSweep(&dev,&perfil,&cache,&barrido));
+    TEST_ASSERT_TRUE(sim.measurements < 2 * PUNTOS);
+    verificarBandas();
+}
+
+/* testeo que otro perfil descarta la cache */
+void test_otroPerfil(void)
+{
+    AD5933_SweepBuffer  barrido = {real, imag, PUNTOS, 0};
+    AD5933_SweepProfile otro;
+
+    TEST_ASSERT_TRUE(AD5933_RunAutoRangedSweep(&dev,&perfil,&cache,&barrido));
+    AD5933_CompileSweepProfile(&dev,&otro,50000,500,PUNTOS - 1,15,AD5933_SETTLING_X1);
+    TEST_ASSERT_TRUE(AD5933_RunAutoRangedSweep(&dev,&otro,&cache,&barrido));
+    TEST_ASSERT_EQUAL_MEMORY(otro.image,cache.image,AD5933_PROFILE_SIZE);
+    TEST_ASSERT_TRUE(cache.changed > 0);
+    verificarBandas();
+}
+
+/* testeo que un barrido con rango automatico se convierte en impedancia */
+void test_impedanciaConRangos(void)
+{
+    static AD5933_Calibration cal;
+    static float              impedancia[PUNTOS];
+    static float              fase[PUNTOS];
+    AD5933_SweepBuffer        barrido = {real, imag, PUNTOS, 0};
+    AD5933_LevelGains         ganancias;
+    unsigned short            punto = 0;
+    double                    zReal = 0;
+    double                    zImag = 0;
+
+    // calibracion con 1 kohm en 2 Vpp x1
+    AD5933_Sim_SetRC(&sim,1000,0);
+    TEST_ASSERT_TRUE(AD5933_RunCalibration(&dev,&cal,&barrido,1000,1000,1000,PUNTOS - 1));
+    AD5933_Sim_SetRC(&sim,20000,5.3e-9);
+    TEST_ASSERT_TRUE(AD5933_RunAutoRangedSweep(&dev,&perfil,&cache,&barrido));
+    TEST_ASSERT_TRUE(cache.changed > 0);
+
+    AD5933_InitLevelGains(&ganancias);
+    TEST_ASSERT_FALSE(AD5933_ApplyRangedCalibration(&cal,AD5933_RANGE_200mVpp,
+                                                    AD5933_GAIN_X5,&cache,
+                                                    &ganancias,&barrido,1000,
+                                                    1000,impedancia,fase));
+    TEST_ASSERT_TRUE(AD5933_ApplyRangedCalibration(&cal,AD5933_RANGE_2000mVpp,
+                                                   AD5933_GAIN_X1,&cache,
+                                                   &ganancias,&barrido,1000,
+                                                   1000,impedancia,fase));
+    // todas las bandas quedan en ohm, cualquiera sea su nivel
+    for(punto = 0; punto < PUNTOS; punto++)
+    {
+        AD5933_Sim_Impedance(&sim,1000.0 * (punto + 1),&zReal,&zImag);
+        TEST_ASSERT_FLOAT_WITHIN(0.01 * hypot(zReal,zImag),hypot(zReal,zImag),
+                                 impedancia[punto]);
+        TEST_ASSERT_FLOAT_WITHIN(0.02,atan2(zImag,zReal),fase[punto]);
+    }
+}
@@ -0,0 +1,115 @@
+/*
+Calibracion por frecuencia del AD5933:
+factor de ganancia y fase del sistema
+para cada punto del barrido.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Calibration.h"
+#include "AD5933_Kernel.h"
+#include "math.h"
+
+static AD5933_Calibration cal;
+
+void setUp(void)
+{
+}
+void tearDown(void)
+{
+    
+}
+
+/* testeo el factor de ganancia y la fase de cada punto de calibracion */
+void test_construirCalibracion(void)
+{
+    signed short real[3] = {3000, 0, -500};
+    signed short imag[3] = {4000, 1000, 0};
+    AD5933_SweepBuffer barrido = {real, imag, 3, 3};
+
+    TEST_ASSERT_TRUE(AD5933_BuildCalibration(&cal,&barrido,1000,10000,1000));
+    TEST_ASSERT_EQUAL_UINT16(3,cal.points);
+    // |3000 + 4000j| = 5000, 1 / (5000 * 1000)
+    TEST_ASSERT_FLOAT_WITHIN(1e-12,2e-7,cal.gainFactor[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6,M_PI / 2,cal.systemPhase[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6,M_PI,cal.systemPhase[2]);
+}
+
+/* testeo que un punto sin senal invalida la calibracion */
+void test_calibracionSinSenal(void)
+{
+    signed short real[2] = {100, 0};
+    signed short imag[2] = {100, 0};
+    AD5933_SweepBuffer barrido = {real, imag, 2, 2};
+
+    TEST_ASSERT_FALSE(AD5933_BuildCalibration(&cal,&barrido,1000,10000,1000));
+}
+
+/* testeo la interpolacion entre puntos y fuera del rango calibrado */
+void test_interpolarCalibracion(void)
+{
+    signed short real[2] = {1000, 0};
+    signed short imag[2] = {0, 500};
+    AD5933_SweepBuffer barrido = {real, imag, 2, 2};
+    float ganancia = 0;
+    float fase = 0;
+
+    AD5933_BuildCalibration(&cal,&barrido,1000,10000,1000);
+    AD5933_InterpolateCalibration(&cal,10500,&ganancia,&fase);
+    TEST_ASSERT_FLOAT_WITHIN(1e-12,1.5e-6,ganancia);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6,M_PI / 4,fase);
+
+    AD5933_InterpolateCalibration(&cal,50000,&ganancia,&fase);
+    TEST_ASSERT_FLOAT_WITHIN(1e-12,2e-6,ganancia);
+}
+
+/* testeo que una carga igual a la de calibracion da la misma impedancia */
+void test_aplicarCalibracion(void)
+{
+    signed short real[3] = {2000, 1800, 1600};
+    signed short imag[3] = {-100, -200, -300};
+    AD5933_SweepBuffer barrido = {real, imag, 3, 3};
+    signed short realMedido[2] = {1000, 900};
+    signed short imagMedido[2] = {-50, -100};
+    AD5933_SweepBuffer medicion = {realMedido, imagMedido, 2, 2};
+    float impedancia[2];
+    float fase[2];
+
+    AD5933_BuildCalibration(&cal,&barrido,1000,10000,2000);
+    // la medicion usa la mitad de corriente en los puntos de 10 kHz y 12 kHz
+    AD5933_ApplyCalibration(&cal,&medicion,10000,2000,impedancia,fase);
+    TEST_ASSERT_FLOAT_WITHIN(0.01,2000,impedancia[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01,2000,impedancia[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5,0,fase[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5,0,fase[1]);
+}
+
+/* testeo la correccion del factor de ganancia con la temperatura */
+void test_coeficienteTemperatura(void)
+{
+    signed short real[2] = {2000, 1800};
+    signed short imag[2] = {0, 0};
+    AD5933_SweepBuffer barrido = {real, imag, 2, 2};
+    signed short realCaliente[2] = {1960, 1764};
+    AD5933_SweepBuffer caliente = {realCaliente, imag, 2, 2};
+    AD5933_Calibration calCaliente;
+    float impedancia[2];
+    float fase[2];
+
+    AD5933_BuildCalibration(&cal,&barrido,1000,10000,2000);
+    TEST_ASSERT_TRUE(isnan(cal.temperature));
+    AD5933_SetCalibrationTemperature(&cal,25,0);
+    // a 35 C el mismo resistor da 2 % menos de senal
+    AD5933_BuildCalibration(&calCaliente,&caliente,1000,10000,2000);
+    AD5933_SetCalibrationTemperature(&calCaliente,35,0);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5,0.00204,AD5933_EstimateGainTempCo(&cal,&calCaliente));
+
+    AD5933_SetCalibrationTemperature(&cal,25,AD5933_EstimateGainTempCo(&cal,&calCaliente));
+    AD5933_ApplyCalibrationAt(&cal,&caliente,10000,2000,35,impedancia,fase);
+    TEST_ASSERT_FLOAT_WITHIN(0.05,1000,impedancia[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05,1000,impedancia[1]);
+    // sin temperatura no se corrige
+    AD5933_ApplyCalibrationAt(&cal,&caliente,10000,2000,NAN,impedancia,fase);
+    TEST_ASSERT_FLOAT_WITHIN(0.05,1020.4,impedancia[0]);
+}
@@ -0,0 +1,128 @@
+/*
+Transporte i2c-dev de Linux:
+sin hardware se prueban los errores y los mensajes que se arman.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_I2cDev.h"
+
+void setUp(void)
+{
+}
+void tearDown(void)
+{
+}
+
+/* testeo que un bus inexistente no se abre */
+void test_busInexistente(void)
+{
+    TEST_ASSERT_EQUAL_INT(-1,AD5933_I2cDevOpen(255));
+}
+
+/* testeo que un lote sobre un descriptor invalido falla */
+void test_loteSinDescriptor(void)
+{
+    AD5933_BusOp  lote[2] = {{AD5933_BUS_WRITE_REG8, 0xB0, 1, {0x8F}, 0},
+                             {AD5933_BUS_READ_BLOCK, 0xA1, 9, {0}, 0}};
+    unsigned char datos[9];
+
+    lote[1].readData = datos;
+    TEST_ASSERT_TRUE(AD5933_I2cDevSubmit(-1,lote,0));
+    TEST_ASSERT_FALSE(AD5933_I2cDevSubmit(-1,lote,2));
+    TEST_ASSERT_EQUAL_INT(-1,AD5933_I2CDEV_TRANSPORT.readReg8(-1,0x8F));
+}
+
+/* testeo el formato de los mensajes de escritura */
+void test_mensajesEscritura(void)
+{
+    AD5933_BusOp          lote[2] = {{AD5933_BUS_WRITE_REG8, 0x80, 1, {0xB1}, 0},
+                                     {AD5933_BUS_WRITE_BLOCK, 0xA0, 3,
+                                      {0x0F, 0x5C, 0x28}, 0}};
+    unsigned char         bloque[5] = {0xA0, 3, 0x0F, 0x5C, 0x28};
+    AD5933_I2cDevTransfer transferencia;
+
+    TEST_ASSERT_EQUAL_INT(2,AD5933_I2cDevBuildMessages(lote,2,&transferencia));
+    TEST_ASSERT_EQUAL_UINT8(2,transferencia.count);
+    TEST_ASSERT_EQUAL_HEX16(AD5933_ADDRESS,transferencia.msgs[0].addr);
+    TEST_ASSERT_EQUAL_HEX16(0,transferencia.msgs[0].flags);
+    TEST_ASSERT_EQUAL_UINT16(2,transferencia.msgs[0].len);
+    TEST_ASSERT_EQUAL_HEX8(0x80,transferencia.msgs[0].buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xB1,transferencia.msgs[0].buf[1]);
+    TEST_ASSERT_EQUAL_UINT16(5,transferencia.msgs[1].len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(bloque,transferencia.msgs[1].buf,5);
+}
+
+/* testeo que cada lectura es una escritura del comando mas una lectura */
+void test_mensajesLectura(void)
+{
+    unsigned char         datos[9];
+    unsigned char         byte = 0;
+    AD5933_BusOp          lote[3] = {{AD5933_BUS_WRITE_REG8, 0xB0, 1, {0x8F}, 0},
+                                     {AD5933_BUS_READ_BLOCK, 0xA1, 9, {0}, 0},
+                                     {AD5933_BUS_READ_REG8, 0x92, 1, {0}, 0}};
+    AD5933_I2cDevTransfer transferencia;
+
+    lote[1].readData = datos;
+    lote[2].readData = &byte;
+    TEST_ASSERT_EQUAL_INT(3,AD5933_I2cDevBuildMessages(lote,3,&transferencia));
+    TEST_ASSERT_EQUAL_UINT8(5,transferencia.count);
+    // lectura en bloque: comando y cantidad, luego 9 bytes con inicio repetido
+    TEST_ASSERT_EQUAL_UINT16(2,transferencia.msgs[1].len);
+    TEST_ASSERT_EQUAL_HEX8(0xA1,transferencia.msgs[1].buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(9,transferencia.msgs[1].buf[1]);
+    TEST_ASSERT_EQUAL_HEX16(I2C_M_RD,transferencia.msgs[2].flags);
+    TEST_ASSERT_EQUAL_UINT16(9,transferencia.msgs[2].len);
+    TEST_ASSERT_EQUAL_PTR(datos,transferencia.msgs[2].buf);
+    // lectura de un byte: solo la direccion, luego 1 byte
+    TEST_ASSERT_EQUAL_UINT16(1,transferencia.msgs[3].len);
+    TEST_ASSERT_EQUAL_HEX8(0x92,transferencia.msgs[3].buf[0]);
+    TEST_ASSERT_EQUAL_HEX16(0,transferencia.msgs[3].flags);
+    TEST_ASSERT_EQUAL_HEX16(I2C_M_RD,transferencia.msgs[4].flags);
+    TEST_ASSERT_EQUAL_UINT16(1,transferencia.msgs[4].len);
+    TEST_ASSERT_EQUAL_PTR(&byte,transferencia.msgs[4].buf);
+}
+
+/* testeo que un lote largo se parte sin separar una lectura de su comando */
+void test_loteLargoPartido(void)
+{
+    AD5933_BusOp          lote[AD5933_I2CDEV_MAX_MSGS];
+    unsigned char         datos[AD5933_I2CDEV_MAX_MSGS];
+    unsigned char         indice = 0;
+    AD5933_I2cDevTransfer transferencia;
+
+    // una escritura y despues lecturas de un byte (2 mensajes cada una)
+    lote[0] = (AD5933_BusOp){AD5933_BUS_WRITE_REG8, 0x80, 1, {0x91}, 0};
+    for(indice = 1; indice < AD5933_I2CDEV_MAX_MSGS; indice++)
+    {
+        lote[indice] = (AD5933_BusOp){AD5933_BUS_READ_REG8, 0x92, 1, {0},
+                                      &datos[indice]};
+    }
+    // 1 + 2 * 20 = 41 mensajes: la lectura 21 ya no entra
+    TEST_ASSERT_EQUAL_INT(21,AD5933_I2cDevBuildMessages(lote,
+                                                        AD5933_I2CDEV_MAX_MSGS,
+                                                        &transferencia));
+    TEST_ASSERT_EQUAL_UINT8(41,transferencia.count);
+    TEST_ASSERT_EQUAL_HEX16(I2C_M_RD,transferencia.msgs[40].flags);
+    // el resto va en la llamada siguiente
+    TEST_ASSERT_EQUAL_INT(AD5933_I2CDEV_MAX_MSGS - 21,
+                          AD5933_I2cDevBuildMessages(&lote[21],
+                                                     AD5933_I2CDEV_MAX_MSGS - 21,
+                                                     &transferencia));
+    TEST_ASSERT_EQUAL_UINT8(2 * (AD5933_I2CDEV_MAX_MSGS - 21),transferencia.count);
+    TEST_ASSERT_EQUAL_PTR(&datos[21],transferencia.msgs[1].buf);
+}
+
+/* testeo que una operacion demasiado grande corta el lote */
+void test_operacionDemasiadoGrande(void)
+{
+    AD5933_BusOp          lote[2] = {{AD5933_BUS_WRITE_REG8, 0xB0, 1, {0x8F}, 0},
+                                     {AD5933_BUS_READ_BLOCK, 0xA1,
+                                      AD5933_BUS_MAX_DATA + 1, {0}, 0}};
+    AD5933_I2cDevTransfer transferencia;
+
+    TEST_ASSERT_EQUAL_INT(1,AD5933_I2cDevBuildMessages(lote,2,&transferencia));
+    TEST_ASSERT_EQUAL_INT(-1,AD5933_I2cDevBuildMessages(&lote[1],1,
+                                                        &transferencia));
+}
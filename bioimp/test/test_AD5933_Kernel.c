@@ -0,0 +1,130 @@
+/*
+Calculo en bloque de magnitud, fase e
+impedancia de todos los puntos de un barrido,
+en punto flotante y solo con enteros.
+*/
+
+#include "unity.h"
+#include "AD5933_Kernel.h"
+#include "math.h"
+
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+
+static signed short real[8] = {3000, -3000, -3000, 3000, 0, 0, 32767, -32768};
+static signed short imag[8] = {4000, 4000, -4000, -4000, 0, 1000, 0, -32768};
+
+void setUp(void)
+{
+}
+void tearDown(void)
+{
+    
+}
+
+/* testeo magnitud, fase e impedancia en los cuatro cuadrantes */
+void test_procesarBarrido(void)
+{
+    float ganancia[8];
+    float faseSistema[8];
+    float magnitud[8];
+    float fase[8];
+    float impedancia[8];
+    int   punto;
+
+    for(punto = 0; punto < 8; punto++)
+    {
+        ganancia[punto]    = 1e-6f;
+        faseSistema[punto] = 0.1f;
+    }
+    AD5933_ProcessSweep(real,imag,ganancia,faseSistema,8,magnitud,fase,impedancia);
+    for(punto = 0; punto < 8; punto++)
+    {
+        double mag = sqrt((double)real[punto] * real[punto] +
+                          (double)imag[punto] * imag[punto]);
+        double ang = atan2(imag[punto],real[punto]) - 0.1;
+
+        ang = (ang <= -M_PI) ? (ang + 2 * M_PI) : ang;
+        TEST_ASSERT_FLOAT_WITHIN(0.01,mag,magnitud[punto]);
+        if(mag > 0)
+        {
+            TEST_ASSERT_FLOAT_WITHIN(1e-5 / (1e-6 * mag),1 / (1e-6 * mag),impedancia[punto]);
+            TEST_ASSERT_FLOAT_WITHIN(2e-6,ang,fase[punto]);
+        }
+    }
+    // sin senal no hay impedancia
+    TEST_ASSERT_EQUAL_FLOAT(0,impedancia[4]);
+}
+
+/* testeo la raiz cuadrada entera */
+void test_raizEntera(void)
+{
+    TEST_ASSERT_EQUAL_UINT16(0,AD5933_Isqrt(0));
+    TEST_ASSERT_EQUAL_UINT16(5000,AD5933_Isqrt(25000000ul));
+    TEST_ASSERT_EQUAL_UINT16(4999,AD5933_Isqrt(24999999ul));
+    TEST_ASSERT_EQUAL_UINT16(46340,AD5933_Isqrt(2147483648ul));
+    TEST_ASSERT_EQUAL_UINT16(65535,AD5933_Isqrt(4294967295ul));
+}
+
+/* testeo la fase CORDIC contra atan2 */
+void test_faseCordic(void)
+{
+    int punto;
+
+    for(punto = 0; punto < 8; punto++)
+    {
+        long esperado;
+
+        if((real[punto] == 0) && (imag[punto] == 0))
+        {
+            continue;
+        }
+        esperado = lround(atan2(imag[punto],real[punto]) * AD5933_ANGLE_PI / M_PI);
+        TEST_ASSERT_INT16_WITHIN(4,(signed short)esperado,
+                                 AD5933_Atan2Cordic(imag[punto],real[punto]));
+    }
+    TEST_ASSERT_INT16_WITHIN(4,AD5933_ANGLE_PI / 4,AD5933_Atan2Cordic(3,3));
+}
+
+/* testeo que el calculo entero coincide con el de punto flotante */
+void test_procesarBarridoEntero(void)
+{
+    float              ganancia[8];
+    float              faseSistema[8];
+    float              fase[8];
+    float              impedancia[8];
+    unsigned long long escala[8];
+    signed short       faseFija[8];
+    unsigned short     magnitud[8];
+    signed short       faseEntera[8];
+    unsigned long      impedanciaEntera[8];
+    int                punto;
+
+    for(punto = 0; punto < 8; punto++)
+    {
+        ganancia[punto]    = 1e-6f;
+        faseSistema[punto] = -M_PI / 2;
+    }
+    AD5933_ConvertCalibration(ganancia,faseSistema,8,escala,faseFija);
+    TEST_ASSERT_EQUAL_UINT32(1000000ul,(unsigned long)escala[0]);
+    TEST_ASSERT_EQUAL_INT16(-16384,faseFija[0]);
+    AD5933_ProcessSweep(real,imag,ganancia,faseSistema,8,0,fase,impedancia);
+    AD5933_ProcessSweepFixed(real,imag,escala,faseFija,8,
+                             magnitud,faseEntera,impedanciaEntera);
+    TEST_ASSERT_EQUAL_UINT16(5000,magnitud[0]);
+    TEST_ASSERT_EQUAL_UINT32(200,impedanciaEntera[0]);
+    TEST_ASSERT_EQUAL_UINT32(0,impedanciaEntera[4]);
+    for(punto = 0; punto < 8; punto++)
+    {
+        if(punto == 4)
+        {
+            continue;
+        }
+        TEST_ASSERT_UINT32_WITHIN(1,(unsigned long)lroundf(impedancia[punto]),
+                                  impedanciaEntera[punto]);
+        // la fase entera da la vuelta en +-pi
+        TEST_ASSERT_INT16_WITHIN(6,0,(signed short)(faseEntera[punto] -
+                                     lround(fase[punto] * AD5933_ANGLE_PI / M_PI)));
+    }
+}
@@ -0,0 +1,99 @@
+/*
+Registro estructurado del driver:
+registros binarios en un anillo sin bloqueo
+que otro hilo formatea despues.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Log.h"
+#include "AD5933_Ring.h"
+#include "string.h"
+
+static AD5933_Device    dev;
+static AD5933_Ring      anillo;
+static AD5933_LogRecord registros[4];
+
+void setUp(void)
+{
+    AD5933_Init(&dev,0x0D);
+    AD5933_LogInit(&anillo,registros,4);
+}
+void tearDown(void)
+{
+    
+}
+
+/* testeo que el anillo descarta y cuenta lo que no entra */
+void test_anilloLleno(void)
+{
+    AD5933_Ring   cola;
+    unsigned long datos[2];
+    unsigned long valor = 0;
+
+    TEST_ASSERT_FALSE(AD5933_RingInit(&cola,datos,sizeof(unsigned long),3));
+    TEST_ASSERT_TRUE(AD5933_RingInit(&cola,datos,sizeof(unsigned long),2));
+    TEST_ASSERT_FALSE(AD5933_RingPop(&cola,&valor));
+    valor = 7;
+    TEST_ASSERT_TRUE(AD5933_RingPush(&cola,&valor));
+    valor = 8;
+    TEST_ASSERT_TRUE(AD5933_RingPush(&cola,&valor));
+    valor = 9;
+    TEST_ASSERT_FALSE(AD5933_RingPush(&cola,&valor));
+    TEST_ASSERT_EQUAL_UINT32(1,atomic_load(&cola.dropped));
+    TEST_ASSERT_EQUAL_UINT32(2,AD5933_RingCount(&cola));
+    TEST_ASSERT_TRUE(AD5933_RingPop(&cola,&valor));
+    TEST_ASSERT_EQUAL_UINT32(7,valor);
+    TEST_ASSERT_TRUE(AD5933_RingPop(&cola,&valor));
+    TEST_ASSERT_EQUAL_UINT32(8,valor);
+    TEST_ASSERT_FALSE(AD5933_RingPop(&cola,&valor));
+}
+
+/* testeo que sin anillo no se registra nada */
+void test_sinAnillo(void)
+{
+    AD5933_LOG_ERROR((AD5933_Ring *)0,AD5933_EVENT_BUS_ERROR,0x80,0,0);
+    AD5933_LOG_ERROR(dev.log,AD5933_EVENT_BUS_ERROR,0x80,0,0);
+    TEST_ASSERT_EQUAL_UINT32(0,AD5933_RingCount(&anillo));
+}
+
+/* testeo que el calculo del factor de ganancia se registra y se formatea despues */
+void test_registroFactorGanancia(void)
+{
+    int i2cdevice = 0x0D;
+    unsigned char bloque[4] = {0, 3, 0, 4};
+    char texto[64];
+
+    AD5933_SetLog(&dev,&anillo);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0x81,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x94,true);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,4,4);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(bloque,4);
+
+    AD5933_CalculateGainFactor(&dev,1000,8);
+
+    // lectura en bloque y paso de calibracion
+    TEST_ASSERT_EQUAL_UINT32(2,AD5933_RingCount(&anillo));
+    TEST_ASSERT_TRUE(AD5933_LogFormat(&anillo,texto,sizeof(texto)));
+    TEST_ASSERT_EQUAL_STRING("DEBUG: Block read from 0x94, 4 bytes",texto);
+    TEST_ASSERT_TRUE(AD5933_LogFormat(&anillo,texto,sizeof(texto)));
+    TEST_ASSERT_EQUAL_STRING("INFO: Calibration step R=3 I=4",texto);
+    TEST_ASSERT_FALSE(AD5933_LogFormat(&anillo,texto,sizeof(texto)));
+}
+
+/* testeo que un error de bus se registra como ERROR */
+void test_registroErrorBus(void)
+{
+    int i2cdevice = 0x0D;
+    char texto[16];
+
+    AD5933_SetLog(&dev,&anillo);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0xB1,false);
+
+    TEST_ASSERT_FALSE(AD5933_SetToStandBy(&dev));
+    // el texto se recorta al tamano del buffer
+    TEST_ASSERT_TRUE(AD5933_LogFormat(&anillo,texto,sizeof(texto)));
+    TEST_ASSERT_EQUAL_STRING("ERROR: Bus erro",texto);
+}
@@ -0,0 +1,203 @@
+/*
+Pipeline de adquisicion y procesamiento:
+el hilo de adquisicion entrega barridos crudos
+a un grupo de hilos que los calibran y procesan.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Calibration.h"
+#include "AD5933_Kernel.h"
+#include "AD5933_Pipeline.h"
+#include "AD5933_Queue.h"
+#include "AD5933_Sim.h"
+#include "pthread.h"
+#include "math.h"
+
+#define CUADROS     4
+#define CANALES     2
+#define BARRIDOS    40
+#define PUNTOS      21
+#define HILOS       4
+#define VALORES     20000
+
+static AD5933_Sim          sim[CANALES];
+static AD5933_Device       dev[CANALES];
+static AD5933_Calibration  cal[CANALES];
+static AD5933_Frame        cuadros[CUADROS];
+static AD5933_QueueCell    celdas[2 * CUADROS];
+static AD5933_Pipeline     pipeline;
+
+static AD5933_Queue        cola;
+static AD5933_QueueCell    celdasCola[64];
+static atomic_ulong        vistos[HILOS * VALORES];
+static atomic_ulong        consumidos;
+
+/* resultados de los barridos procesados, uno por numero de publicacion:
+   cada cuadro lo procesa un solo hilo, asi que ningun hilo escribe el
+   lugar de otro, y se leen despues de AD5933_PipelineStop */
+static atomic_ulong        procesados[CANALES];
+static atomic_ulong        entregas[BARRIDOS];
+static unsigned short      canalBarrido[BARRIDOS];
+static float               impedancia[BARRIDOS];
+static bool                convertido[BARRIDOS];
+
+static void guardarCuadro(void *contexto, AD5933_Frame *cuadro)
+{
+    (void)contexto;
+    if(cuadro->sequence < BARRIDOS)
+    {
+        canalBarrido[cuadro->sequence] = cuadro->channel;
+        impedancia[cuadro->sequence]   = cuadro->impedance[0];
+        convertido[cuadro->sequence]   = cuadro->converted;
+        atomic_fetch_add(&entregas[cuadro->sequence], 1);
+    }
+    atomic_fetch_add(&procesados[cuadro->channel], 1);
+}
+
+static void *productor(void *argumento)
+{
+    unsigned long base  = (unsigned long)argumento * VALORES;
+    unsigned long valor = 0;
+
+    for(valor = 0; valor < VALORES; valor++)
+    {
+        while(!AD5933_QueuePush(&cola, (void *)(base + valor + 1)))
+        {
+        }
+    }
+    return 0;
+}
+
+static void *consumidor(void *argumento)
+{
+    void *valor = 0;
+
+    (void)argumento;
+    while(atomic_load(&consumidos) < HILOS * VALORES)
+    {
+        if(AD5933_QueuePop(&cola, &valor))
+        {
+            atomic_fetch_add(&vistos[(unsigned long)valor - 1], 1);
+            atomic_fetch_add(&consumidos, 1);
+        }
+    }
+    return 0;
+}
+
+void setUp(void)
+{
+    static AD5933_SweepBuffer barrido;
+    static signed short real[PUNTOS];
+    static signed short imag[PUNTOS];
+    unsigned char canal = 0;
+
+    for(canal = 0; canal < CANALES; canal++)
+    {
+        AD5933_Sim_Init(&sim[canal],0x10 + canal);
+        AD5933_Init(&dev[canal],0x10 + canal);
+        AD5933_SetTransport(&dev[canal],&AD5933_SIM_TRANSPORT);
+        sim[canal].conversionScale = 0;
+        AD5933_ConfigSweep(&dev[canal],10000,1000,PUNTOS - 1);
+        barrido.realData = real;
+        barrido.imagData = imag;
+        barrido.capacity = PUNTOS;
+        // calibracion con 1 kohm, despues una carga distinta en cada canal
+        AD5933_RunSweep(&dev[canal],&barrido);
+        AD5933_BuildCalibration(&cal[canal],&barrido,1000,10000,1000);
+        sim[canal].load.r0 = 2000 + 1000 * canal;
+        atomic_init(&procesados[canal],0);
+    }
+    for(canal = 0; canal < BARRIDOS; canal++)
+    {
+        atomic_init(&entregas[canal],0);
+    }
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim[0]);
+    AD5933_Sim_Detach(&sim[1]);
+}
+
+/* testeo la cola con varios productores y consumidores */
+void test_colaVariosHilos(void)
+{
+    pthread_t     hilos[2 * HILOS];
+    unsigned long indice = 0;
+
+    TEST_ASSERT_FALSE(AD5933_QueueInit(&cola,celdasCola,48));
+    TEST_ASSERT_TRUE(AD5933_QueueInit(&cola,celdasCola,64));
+    atomic_init(&consumidos,0);
+    for(indice = 0; indice < HILOS * VALORES; indice++)
+    {
+        atomic_init(&vistos[indice],0);
+    }
+    for(indice = 0; indice < HILOS; indice++)
+    {
+        pthread_create(&hilos[indice],0,productor,(void *)indice);
+        pthread_create(&hilos[HILOS + indice],0,consumidor,0);
+    }
+    for(indice = 0; indice < 2 * HILOS; indice++)
+    {
+        pthread_join(hilos[indice],0);
+    }
+    // cada valor sale una sola vez
+    for(indice = 0; indice < HILOS * VALORES; indice++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(1,atomic_load(&vistos[indice]));
+    }
+}
+
+/* testeo que sin cuadros libres la adquisicion no se bloquea */
+void test_sinCuadrosLibres(void)
+{
+    unsigned char indice = 0;
+
+    TEST_ASSERT_TRUE(AD5933_PipelineInit(&pipeline,cuadros,celdas,CUADROS,0,0,0,0));
+    for(indice = 0; indice < CUADROS; indice++)
+    {
+        TEST_ASSERT_TRUE(AD5933_PipelineSweep(&pipeline,&dev[0],0,10000,1000,NAN));
+    }
+    // sin hilos de trabajo nadie libera los cuadros
+    TEST_ASSERT_FALSE(AD5933_PipelineSweep(&pipeline,&dev[0],0,10000,1000,NAN));
+    TEST_ASSERT_EQUAL_UINT32(1,atomic_load(&pipeline.overruns));
+    TEST_ASSERT_TRUE(AD5933_PipelineStart(&pipeline,2));
+    AD5933_PipelineStop(&pipeline);
+    TEST_ASSERT_EQUAL_UINT32(CUADROS,atomic_load(&pipeline.processed));
+    TEST_ASSERT_EQUAL_UINT16(PUNTOS,cuadros[0].sweep.count);
+}
+
+/* testeo que los hilos calibran los barridos de cada canal */
+void test_barridosProcesados(void)
+{
+    const AD5933_Calibration *calibraciones[CANALES] = {&cal[0], &cal[1]};
+    const float               carga[CANALES] = {2000, 3000};
+    unsigned char             barrido = 0;
+
+    TEST_ASSERT_TRUE(AD5933_PipelineInit(&pipeline,cuadros,celdas,CUADROS,
+                                         calibraciones,CANALES,guardarCuadro,0));
+    TEST_ASSERT_TRUE(AD5933_PipelineStart(&pipeline,HILOS));
+    for(barrido = 0; barrido < BARRIDOS; barrido++)
+    {
+        // la adquisicion reintenta si los hilos todavia no liberaron un cuadro
+        while(!AD5933_PipelineSweep(&pipeline,&dev[barrido % CANALES],
+                                    barrido % CANALES,10000,1000,NAN))
+        {
+        }
+    }
+    AD5933_PipelineStop(&pipeline);
+
+    TEST_ASSERT_EQUAL_UINT32(BARRIDOS,atomic_load(&pipeline.published));
+    TEST_ASSERT_EQUAL_UINT32(BARRIDOS,atomic_load(&pipeline.processed));
+    TEST_ASSERT_EQUAL_UINT32(BARRIDOS / CANALES,atomic_load(&procesados[0]));
+    TEST_ASSERT_EQUAL_UINT32(BARRIDOS / CANALES,atomic_load(&procesados[1]));
+    // cada barrido llego una vez al manejador, calibrado con su canal
+    for(barrido = 0; barrido < BARRIDOS; barrido++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(1,atomic_load(&entregas[barrido]));
+        TEST_ASSERT_EQUAL_UINT16(barrido % CANALES,canalBarrido[barrido]);
+        TEST_ASSERT_TRUE(convertido[barrido]);
+        TEST_ASSERT_FLOAT_WITHIN(5,carga[barrido % CANALES],impedancia[barrido]);
+    }
+}
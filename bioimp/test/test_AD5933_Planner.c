@@ -0,0 +1,135 @@
+/*
+Planificador de barridos:
+una lista arbitraria de frecuencias se divide
+en la menor cantidad de barridos del AD5933.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Planner.h"
+#include "AD5933_Settling.h"
+#include "AD5933_Sim.h"
+#include "math.h"
+
+#define PUNTOS      1000
+#define SEGMENTOS   64
+
+static AD5933_Sim           sim;
+static AD5933_Device        dev;
+static AD5933_PlannerConfig config;
+static AD5933_SweepSegment  segmentos[SEGMENTOS];
+static AD5933_SweepPlan     plan = {segmentos, SEGMENTOS, 0, 0};
+static unsigned long        lista[PUNTOS];
+static unsigned long        medidas[PUNTOS];
+static signed short         real[PUNTOS];
+static signed short         imag[PUNTOS];
+
+void setUp(void)
+{
+    AD5933_Sim_Init(&sim,0x0D);
+    AD5933_Init(&dev,0x0D);
+    AD5933_SIM_ATTACH();
+    sim.conversionScale      = 0;
+    sim.extClk               = 1000000;
+    config.extClk            = 1000000;
+    config.tolerance         = 0.005f;
+    config.minDftPeriods     = 4;
+    config.settlingTime      = 0.001f;
+    config.minSettlingCycles = 10;
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim);
+}
+
+/* testeo que mas de 512 puntos lineales usan dos segmentos */
+void test_masDe512Puntos(void)
+{
+    unsigned short punto = 0;
+
+    for(punto = 0; punto < PUNTOS; punto++)
+    {
+        lista[punto] = 5000 + 50ul * punto;
+    }
+    TEST_ASSERT_TRUE(AD5933_PlanSweep(lista,PUNTOS,&config,&plan));
+    TEST_ASSERT_EQUAL_UINT16(2,plan.count);
+    TEST_ASSERT_EQUAL_UINT16(PUNTOS,plan.points);
+    TEST_ASSERT_EQUAL_UINT16(512,segmentos[0].points);
+    TEST_ASSERT_EQUAL_UINT16(512,segmentos[1].first);
+    TEST_ASSERT_EQUAL_HEX8(AD5933_CONTROL_INT_SYSCLK,segmentos[1].clockSource);
+    // 1 ms a 54.95 kHz son 55 ciclos
+    TEST_ASSERT_EQUAL_HEX8(55,segmentos[1].profile.image[9]);
+
+    // sin tolerancia una lista en Hz no es una progresion exacta de codigos
+    // y no alcanzan los segmentos
+    config.tolerance = 0;
+    TEST_ASSERT_FALSE(AD5933_PlanSweep(lista,PUNTOS,&config,&plan));
+    TEST_ASSERT_EQUAL_UINT16(SEGMENTOS,plan.count);
+}
+
+/* testeo una lista logaritmica con el reloj externo en las frecuencias bajas */
+void test_listaLogaritmica(void)
+{
+    unsigned short punto = 0;
+    unsigned short indice = 0;
+    unsigned long  frecuencia = 0;
+    double         sistema = 0;
+
+    for(punto = 0; punto < 200; punto++)
+    {
+        lista[punto] = lround(100 * pow(1000, punto / 199.0));
+    }
+    TEST_ASSERT_TRUE(AD5933_PlanSweep(lista,200,&config,&plan));
+    TEST_ASSERT_EQUAL_UINT16(200,plan.points);
+    TEST_ASSERT_TRUE(plan.count < 30);
+    for(indice = 0; indice < plan.count; indice++)
+    {
+        TEST_ASSERT_EQUAL_UINT16(segmentos[indice].first,
+                                 (indice == 0) ? 0 : segmentos[indice - 1].first +
+                                                     segmentos[indice - 1].points);
+        for(punto = 0; punto < segmentos[indice].points; punto++)
+        {
+            frecuencia = lista[segmentos[indice].first + punto];
+            TEST_ASSERT_DOUBLE_WITHIN(frecuencia * 5.0 + 500,frecuencia * 1000.0,
+                AD5933_GetPointFrequency(&segmentos[indice].profile,punto));
+            // ventana del DFT de 1.024 ms con el reloj interno
+            sistema = (frecuencia * 1.024e-3 < 4) ? 1e6 : 16e6;
+            TEST_ASSERT_EQUAL_UINT32(sistema,segmentos[indice].profile.sysClk);
+        }
+    }
+}
+
+/* testeo correr el plan y juntar los resultados en el orden de la lista */
+void test_correrPlan(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, PUNTOS, 0};
+    unsigned short     punto   = 0;
+
+    AD5933_Sim_SetRC(&sim,1000,0);
+    for(punto = 0; punto < 200; punto++)
+    {
+        lista[punto] = lround(100 * pow(1000, punto / 199.0));
+    }
+    // el final de la lista vuelve a las frecuencias bajas
+    for(punto = 200; punto < 260; punto++)
+    {
+        lista[punto] = 300 + 10 * (punto - 200);
+    }
+    TEST_ASSERT_TRUE(AD5933_PlanSweep(lista,260,&config,&plan));
+    TEST_ASSERT_TRUE(AD5933_RunPlan(&dev,&plan,&barrido,medidas));
+    TEST_ASSERT_EQUAL_UINT16(260,barrido.count);
+    TEST_ASSERT_EQUAL_UINT32(260,sim.measurements);
+    for(punto = 0; punto < 260; punto++)
+    {
+        TEST_ASSERT_INT16_WITHIN(2,10000,real[punto]);
+        TEST_ASSERT_DOUBLE_WITHIN(lista[punto] * 5.0 + 500,lista[punto] * 1000.0,
+                                  medidas[punto]);
+    }
+    // el reloj del dispositivo vuelve al interno
+    TEST_ASSERT_EQUAL_HEX8(AD5933_CONTROL_INT_SYSCLK,dev.clockSource);
+    TEST_ASSERT_EQUAL_UINT32(AD5933_INTERNAL_SYS_CLK,dev.sysClk);
+
+    barrido.capacity = 100;
+    TEST_ASSERT_FALSE(AD5933_RunPlan(&dev,&plan,&barrido,medidas));
+}
@@ -0,0 +1,152 @@
+/*
+Escaneo de canales multiplexados:
+varios AD5933 en el mismo bus, mientras uno convierte
+se leen los otros.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Scan.h"
+#include "AD5933_Sim.h"
+
+#define DISPOSITIVOS    3
+#define CANALES         12
+#define PUNTOS          10
+
+static AD5933_Sim          sim[DISPOSITIVOS];
+static AD5933_Device       dev[DISPOSITIVOS];
+static AD5933_Device      *lista[DISPOSITIVOS] = {&dev[0], &dev[1], &dev[2]};
+static AD5933_ScanChannel  canales[CANALES];
+static AD5933_SweepBuffer  resultados[CANALES];
+static signed short        real[CANALES][PUNTOS];
+static signed short        imag[CANALES][PUNTOS];
+static AD5933_SweepProfile perfil;
+static unsigned long long  bus;
+static unsigned short      rechazado;
+
+/* el multiplexor conecta a cada canal un resistor distinto */
+static bool seleccionar(void *contexto, unsigned char dispositivo, unsigned short mux)
+{
+    (void)contexto;
+    if(mux == rechazado)
+    {
+        return false;
+    }
+    sim[dispositivo].load.r0 = 1000 + 100 * mux;
+
+    return true;
+}
+
+void setUp(void)
+{
+    unsigned char  indice = 0;
+    unsigned short canal  = 0;
+
+    bus       = 0;
+    rechazado = 0xFFFF;
+    for(indice = 0; indice < DISPOSITIVOS; indice++)
+    {
+        AD5933_Sim_Init(&sim[indice],0x0D + indice);
+        sim[indice].busNs = &bus;
+        AD5933_Init(&dev[indice],0x0D + indice);
+    }
+    AD5933_SIM_ATTACH();
+    for(canal = 0; canal < CANALES; canal++)
+    {
+        canales[canal].device   = canal % DISPOSITIVOS;
+        canales[canal].mux      = canal;
+        resultados[canal].realData = real[canal];
+        resultados[canal].imagData = imag[canal];
+        resultados[canal].capacity = PUNTOS;
+        resultados[canal].count    = 0;
+    }
+    AD5933_CompileSweepProfile(&dev[0],&perfil,30000,1000,PUNTOS - 1,15,AD5933_SETTLING_X1);
+}
+void tearDown(void)
+{
+    unsigned char indice = 0;
+
+    for(indice = 0; indice < DISPOSITIVOS; indice++)
+    {
+        AD5933_Sim_Detach(&sim[indice]);
+    }
+}
+
+/* testeo que cada canal recibe su barrido */
+void test_escaneo(void)
+{
+    AD5933_Scan    escaneo;
+    unsigned short canal = 0;
+    unsigned short punto = 0;
+
+    TEST_ASSERT_TRUE(AD5933_InitScan(&escaneo,lista,DISPOSITIVOS,canales,CANALES,
+                                     resultados,&perfil,seleccionar,0));
+    TEST_ASSERT_TRUE(AD5933_StartScan(&escaneo,bus / 1000));
+    while(AD5933_ScanStep(&escaneo,bus / 1000))
+    {
+    }
+    TEST_ASSERT_EQUAL_UINT16(CANALES,escaneo.done);
+    TEST_ASSERT_EQUAL_UINT16(0,escaneo.failed);
+    for(canal = 0; canal < CANALES; canal++)
+    {
+        TEST_ASSERT_EQUAL_UINT16(PUNTOS,resultados[canal].count);
+        for(punto = 0; punto < PUNTOS; punto++)
+        {
+            TEST_ASSERT_INT16_WITHIN(2,1e7 / (1000 + 100 * canal),real[canal][punto]);
+        }
+    }
+}
+
+/* testeo que el escaneo solapado supera al barrido bloqueante canal por canal */
+void test_rendimiento(void)
+{
+    AD5933_Scan        escaneo;
+    unsigned short     canal = 0;
+    unsigned long long inicio = 0;
+    float              secuencial = 0;
+    float              solapado = 0;
+
+    // referencia: un canal tras otro con la API bloqueante
+    for(canal = 0; canal < CANALES; canal++)
+    {
+        TEST_ASSERT_TRUE(AD5933_LoadSweepProfile(&dev[canal % DISPOSITIVOS],&perfil));
+    }
+    inicio = bus;
+    for(canal = 0; canal < CANALES; canal++)
+    {
+        seleccionar(0,canal % DISPOSITIVOS,canal);
+        TEST_ASSERT_TRUE(AD5933_RunSweep(&dev[canal % DISPOSITIVOS],&resultados[canal]));
+    }
+    secuencial = CANALES * 1e9f / (bus - inicio);
+
+    TEST_ASSERT_TRUE(AD5933_InitScan(&escaneo,lista,DISPOSITIVOS,canales,CANALES,
+                                     resultados,&perfil,seleccionar,0));
+    TEST_ASSERT_TRUE(AD5933_StartScan(&escaneo,bus / 1000));
+    while(AD5933_ScanStep(&escaneo,bus / 1000))
+    {
+    }
+    solapado = AD5933_GetScanRate(&escaneo);
+    TEST_ASSERT_TRUE(solapado > 2 * secuencial);
+}
+
+/* testeo que un canal que el multiplexor rechaza se saltea */
+void test_canalRechazado(void)
+{
+    AD5933_Scan escaneo;
+
+    rechazado = 4;
+    TEST_ASSERT_TRUE(AD5933_InitScan(&escaneo,lista,DISPOSITIVOS,canales,CANALES,
+                                     resultados,&perfil,seleccionar,0));
+    TEST_ASSERT_TRUE(AD5933_StartScan(&escaneo,0));
+    while(AD5933_ScanStep(&escaneo,0))
+    {
+    }
+    TEST_ASSERT_EQUAL_UINT16(CANALES - 1,escaneo.done);
+    TEST_ASSERT_EQUAL_UINT16(1,escaneo.failed);
+    TEST_ASSERT_EQUAL_UINT16(0,resultados[4].count);
+
+    canales[0].device = DISPOSITIVOS;
+    TEST_ASSERT_FALSE(AD5933_InitScan(&escaneo,lista,DISPOSITIVOS,canales,CANALES,
+                                      resultados,&perfil,seleccionar,0));
+}
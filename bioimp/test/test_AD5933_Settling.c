@@ -0,0 +1,95 @@
+/*
+Ciclos de asentamiento:
+se busca para cada banda de frecuencias la menor
+cantidad de ciclos que coincide con una referencia.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Settling.h"
+#include "AD5933_Planner.h"
+#include "AD5933_Sim.h"
+#include "math.h"
+
+#define PUNTOS  91
+
+static AD5933_Sim           sim;
+static AD5933_Device        dev;
+static AD5933_SettlingTable tabla;
+static signed short         realRef[PUNTOS];
+static signed short         imagRef[PUNTOS];
+static signed short         real[PUNTOS];
+static signed short         imag[PUNTOS];
+static AD5933_SweepBuffer   referencia = {realRef, imagRef, PUNTOS, 0};
+static AD5933_SweepBuffer   prueba     = {real, imag, PUNTOS, 0};
+
+void setUp(void)
+{
+    AD5933_Sim_Init(&sim,0x0D);
+    AD5933_Init(&dev,0x0D);
+    AD5933_SIM_ATTACH();
+    sim.conversionScale = 0;
+    sim.settlingTau     = 100e-6;
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim);
+}
+
+/* testeo que las bandas altas necesitan mas ciclos que las bajas */
+void test_ciclosPorBanda(void)
+{
+    unsigned char banda = 0;
+
+    TEST_ASSERT_TRUE(AD5933_TuneSettling(&dev,&tabla,10000,1000,PUNTOS - 1,10,
+                                         1e-3f,&referencia,&prueba));
+    TEST_ASSERT_EQUAL_UINT8(10,tabla.bands);
+    for(banda = 1; banda < tabla.bands; banda++)
+    {
+        TEST_ASSERT_TRUE(tabla.cycles[banda] >= tabla.cycles[banda - 1]);
+    }
+    TEST_ASSERT_TRUE(tabla.cycles[0] < tabla.cycles[tabla.bands - 1]);
+    TEST_ASSERT_TRUE(tabla.cycles[tabla.bands - 1] < AD5933_SETTLING_REFERENCE);
+    // una referencia y un barrido por escalon, no un barrido por punto
+    TEST_ASSERT_TRUE(tabla.sweeps <= 12);
+    TEST_ASSERT_EQUAL_UINT16(tabla.cycles[0],AD5933_GetTunedSettling(&tabla,10000));
+    TEST_ASSERT_EQUAL_UINT16(tabla.cycles[9],AD5933_GetTunedSettling(&tabla,200000));
+}
+
+/* testeo que el barrido con la tabla coincide con la referencia */
+void test_barridoAjustado(void)
+{
+    unsigned char punto = 0;
+
+    TEST_ASSERT_TRUE(AD5933_TuneSettling(&dev,&tabla,10000,1000,PUNTOS - 1,10,
+                                         1e-3f,&referencia,&prueba));
+    TEST_ASSERT_TRUE(AD5933_ConfigTunedSweep(&dev,&tabla));
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&prueba));
+    TEST_ASSERT_EQUAL_UINT16(PUNTOS,prueba.count);
+    for(punto = 0; punto < PUNTOS; punto++)
+    {
+        TEST_ASSERT_TRUE(hypot(real[punto] - realRef[punto],
+                               imag[punto] - imagRef[punto]) <=
+                         1e-3 * hypot(realRef[punto],imagRef[punto]));
+    }
+}
+
+/* testeo que el planificador toma los ciclos de la tabla */
+void test_planificadorConTabla(void)
+{
+    AD5933_PlannerConfig config   = {0, 0.005f, 0, 0.001f, 1, &tabla};
+    AD5933_SweepSegment  segmento[2];
+    AD5933_SweepPlan     plan     = {segmento, 2, 0, 0};
+    unsigned long        lista[2] = {10000, 100000};
+    unsigned short       ciclos   = 0;
+
+    TEST_ASSERT_TRUE(AD5933_TuneSettling(&dev,&tabla,10000,1000,PUNTOS - 1,10,
+                                         1e-3f,&referencia,&prueba));
+    TEST_ASSERT_TRUE(AD5933_PlanSweep(lista,1,&config,&plan));
+    ciclos = (segmento[0].profile.image[8] << 8) | segmento[0].profile.image[9];
+    TEST_ASSERT_EQUAL_HEX16(AD5933_EncodeSettlingCycles(tabla.cycles[0]),ciclos);
+    TEST_ASSERT_TRUE(AD5933_PlanSweep(lista,2,&config,&plan));
+    ciclos = (segmento[0].profile.image[8] << 8) | segmento[0].profile.image[9];
+    TEST_ASSERT_EQUAL_HEX16(AD5933_EncodeSettlingCycles(tabla.cycles[9]),ciclos);
+}
@@ -0,0 +1,254 @@
+/*
+Simulador del AD5933 a nivel de registros:
+el driver corre sobre un modelo del integrado
+con carga RC/Cole y tiempos de bus virtuales.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Calibration.h"
+#include "AD5933_Kernel.h"
+#include "AD5933_Sim.h"
+#include "math.h"
+
+static AD5933_Device dev;
+static AD5933_Sim    sim;
+static signed short  real[AD5933_MAX_POINTS];
+static signed short  imag[AD5933_MAX_POINTS];
+
+void setUp(void)
+{
+    AD5933_Sim_Init(&sim,0x0D);
+    AD5933_Init(&dev,0x0D);
+    AD5933_SIM_ATTACH();
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim);
+}
+
+/* testeo la maquina de estados y los bits de STATUS a nivel de registros */
+void test_estadoBarrido(void)
+{
+    unsigned char perfil[10] = {0x0F, 0x5C, 0x29, 0x00, 0x01, 0x50, 0x00, 0x02, 0x00, 0x0F};
+
+    AD5933_Sim_WriteReg8(0x0D,0xB0,0x82,0);
+    TEST_ASSERT_TRUE(AD5933_Sim_WriteBlockData(0x0D,0xA0,perfil,10,0));
+    AD5933_Sim_WriteReg8(0x0D,0x80,0x11,0);
+    AD5933_Sim_WriteReg8(0x0D,0x80,0x21,0);
+    // el DFT todavia no termino
+    TEST_ASSERT_EQUAL_HEX8(0x00,AD5933_Sim_ReadReg8(0x0D,0x8F,0));
+    AD5933_Sim_Advance(&sim,10000000ull);
+    TEST_ASSERT_EQUAL_HEX8(0x02,AD5933_Sim_ReadReg8(0x0D,0x8F,0));
+    // dos incrementos hasta terminar el barrido
+    AD5933_Sim_WriteReg8(0x0D,0x80,0x31,0);
+    TEST_ASSERT_EQUAL_HEX8(0x00,AD5933_Sim_ReadReg8(0x0D,0x8F,0));
+    AD5933_Sim_Advance(&sim,10000000ull);
+    TEST_ASSERT_EQUAL_HEX8(0x02,AD5933_Sim_ReadReg8(0x0D,0x8F,0));
+    AD5933_Sim_WriteReg8(0x0D,0x80,0x31,0);
+    AD5933_Sim_Advance(&sim,10000000ull);
+    TEST_ASSERT_EQUAL_HEX8(0x06,AD5933_Sim_ReadReg8(0x0D,0x8F,0));
+    TEST_ASSERT_EQUAL_UINT32(1006633 + 2 * 336,sim.freqCode);
+    // STANDBY limpia los datos
+    AD5933_Sim_WriteReg8(0x0D,0x80,0xB1,0);
+    TEST_ASSERT_EQUAL_HEX8(0x00,AD5933_Sim_ReadReg8(0x0D,0x8F,0));
+    // un handle sin dispositivo no responde
+    TEST_ASSERT_FALSE(AD5933_Sim_WriteReg8(0x0E,0x80,0xB1,0));
+}
+
+/* testeo la temperatura negativa en complemento a dos de 14 bits */
+void test_temperaturaSimulada(void)
+{
+    sim.temperature = -12.5;
+
+    TEST_ASSERT_FLOAT_WITHIN(0.001,-12.5,AD5933_GetTemperature(&dev,0));
+}
+
+/* testeo calibracion y medicion de una carga RC con el driver completo */
+void test_barridoCargaRC(void)
+{
+    static AD5933_Calibration cal;
+    AD5933_SweepBuffer  barrido = {real, imag, AD5933_MAX_POINTS, 0};
+    AD5933_SweepProfile perfil;
+    float               impedancia[AD5933_MAX_POINTS];
+    float               fase[AD5933_MAX_POINTS];
+    double              zr;
+    double              zi;
+    unsigned short      punto;
+
+    sim.systemPhase = 0.3;
+    AD5933_CompileSweepProfile(&dev,&perfil,10000,1000,40,15,AD5933_SETTLING_X1);
+    TEST_ASSERT_TRUE(AD5933_LoadSweepProfile(&dev,&perfil));
+    // calibracion con 1 kohm
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    TEST_ASSERT_EQUAL_UINT16(41,barrido.count);
+    TEST_ASSERT_TRUE(AD5933_BuildCalibration(&cal,&barrido,1000,10000,1000));
+
+    // 2 kohm en paralelo con 10 nF
+    AD5933_Sim_SetRC(&sim,2000,10e-9);
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    TEST_ASSERT_EQUAL_UINT16(41,barrido.count);
+    AD5933_ApplyCalibration(&cal,&barrido,10000,1000,impedancia,fase);
+    for(punto = 0; punto < barrido.count; punto++)
+    {
+        AD5933_Sim_Impedance(&sim,AD5933_GetPointFrequency(&perfil,punto) / 1000.0,&zr,&zi);
+        TEST_ASSERT_FLOAT_WITHIN(sqrt(zr * zr + zi * zi) * 0.002,sqrt(zr * zr + zi * zi),impedancia[punto]);
+        TEST_ASSERT_FLOAT_WITHIN(0.002,atan2(zi,zr),fase[punto]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(82,sim.measurements);
+}
+
+/* testeo el tiempo virtual: conversiones y transacciones de bus */
+void test_tiempoVirtual(void)
+{
+    AD5933_SweepBuffer  barrido = {real, imag, AD5933_MAX_POINTS, 0};
+    AD5933_SweepProfile perfil;
+    unsigned long long  conversion;
+
+    AD5933_CompileSweepProfile(&dev,&perfil,10000,1000,9,100,AD5933_SETTLING_X1);
+    TEST_ASSERT_TRUE(AD5933_LoadSweepProfile(&dev,&perfil));
+
+    // resultados instantaneos: un solo sondeo por punto
+    sim.conversionScale = 0;
+    sim.transactions    = 0;
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    TEST_ASSERT_EQUAL_UINT16(10,barrido.count);
+    // 4 comandos de arranque, puntero, 10 lecturas y 9 incrementos
+    TEST_ASSERT_EQUAL_UINT32(4 + 1 + 10 + 9,sim.transactions);
+
+    // tiempos de la hoja de datos: asentamiento mas 1024 muestras a MCLK/16
+    sim.conversionScale = 1;
+    sim.nowNs           = 0;
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    conversion = 0;
+    for(unsigned short punto = 0; punto < 10; punto++)
+    {
+        conversion += 100 * 1e9 / (AD5933_GetPointFrequency(&perfil,punto) / 1000.0) + 1024ull * 1000;
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(conversion / 1000,sim.nowNs / 1000);
+    TEST_ASSERT_LESS_THAN_UINT32(conversion / 1000 + 10000,sim.nowNs / 1000);
+}
+
+/* testeo el promedio con REPEAT_FREQ y la parada temprana por error estandar */
+void test_barridoPromediado(void)
+{
+    AD5933_SweepBuffer  barrido = {real, imag, AD5933_MAX_POINTS, 0};
+    AD5933_PointAverage promedio[AD5933_MAX_POINTS];
+    AD5933_SweepProfile perfil;
+    unsigned short      punto;
+
+    sim.conversionScale = 0;
+    AD5933_CompileSweepProfile(&dev,&perfil,10000,1000,9,15,AD5933_SETTLING_X1);
+    TEST_ASSERT_TRUE(AD5933_LoadSweepProfile(&dev,&perfil));
+    // referencia sin ruido: 1e7 / 1 kohm = 10000 cuentas reales
+    sim.noise = 40;
+
+    // siempre 16 muestras por punto
+    AD5933_Sim_ResetCounters(&sim);
+    TEST_ASSERT_TRUE(AD5933_RunAveragedSweep(&dev,&barrido,promedio,16,0));
+    TEST_ASSERT_EQUAL_UINT16(10,barrido.count);
+    TEST_ASSERT_EQUAL_UINT32(160,sim.measurements);
+    // 4 de arranque, puntero, 16 sondeos y 15 repeticiones por punto, 9 incrementos
+    TEST_ASSERT_EQUAL_UINT32(4 + 1 + 10 * (16 + 15) + 9,sim.transactions);
+    for(punto = 0; punto < barrido.count; punto++)
+    {
+        TEST_ASSERT_EQUAL_UINT16(16,promedio[punto].samples);
+        // error estandar esperado 40 / 4 = 10
+        TEST_ASSERT_FLOAT_WITHIN(6,10,promedio[punto].stdErrReal);
+        TEST_ASSERT_FLOAT_WITHIN(40,10000,promedio[punto].meanReal);
+        TEST_ASSERT_FLOAT_WITHIN(40,0,promedio[punto].meanImag);
+        TEST_ASSERT_INT16_WITHIN(1,(signed short)promedio[punto].meanReal,barrido.realData[punto]);
+    }
+
+    // objetivo de 20 cuentas: alcanza con pocas muestras
+    AD5933_Sim_ResetCounters(&sim);
+    TEST_ASSERT_TRUE(AD5933_RunAveragedSweep(&dev,&barrido,promedio,64,20));
+    TEST_ASSERT_EQUAL_UINT16(10,barrido.count);
+    TEST_ASSERT_LESS_THAN_UINT32(10 * 64,sim.measurements);
+    for(punto = 0; punto < barrido.count; punto++)
+    {
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(AD5933_AVERAGE_MIN_SAMPLES,promedio[punto].samples);
+        if(promedio[punto].samples < 64)
+        {
+            TEST_ASSERT_TRUE(promedio[punto].stdErrReal <= 20);
+            TEST_ASSERT_TRUE(promedio[punto].stdErrImag <= 20);
+        }
+    }
+}
+
+static AD5933_SweepBuffer *barridoEnCurso;
+static unsigned short      puntosRecibidos;
+
+static void recibirPunto(void *contexto, const AD5933_Point *punto)
+{
+    // el punto llega antes de que el barrido termine
+    TEST_ASSERT_EQUAL_PTR(&sim,contexto);
+    TEST_ASSERT_EQUAL_UINT16(puntosRecibidos,punto->index);
+    TEST_ASSERT_EQUAL_UINT16(punto->index,barridoEnCurso->count);
+    TEST_ASSERT_EQUAL_UINT32(punto->index + 1,sim.measurements);
+    TEST_ASSERT_EQUAL_INT16(10000,punto->realData);
+    TEST_ASSERT_EQUAL(punto->index == 9,(punto->status & AD5933_STAT_SWEEP_DONE) != 0);
+    puntosRecibidos++;
+}
+
+/* testeo la publicacion de cada punto por callback y por anillo */
+void test_barridoEnStreaming(void)
+{
+    AD5933_SweepBuffer  barrido = {0, 0, AD5933_MAX_POINTS, 0};
+    AD5933_SweepProfile perfil;
+    AD5933_Ring         anillo;
+    AD5933_Point        puntos[8];
+    AD5933_Point        punto;
+    unsigned short      indice = 0;
+
+    sim.conversionScale = 0;
+    AD5933_CompileSweepProfile(&dev,&perfil,10000,1000,9,15,AD5933_SETTLING_X1);
+    TEST_ASSERT_TRUE(AD5933_LoadSweepProfile(&dev,&perfil));
+    TEST_ASSERT_TRUE(AD5933_InitPointRing(&anillo,puntos,8));
+    AD5933_SetPointCallback(&dev,recibirPunto,&sim);
+    AD5933_SetPointRing(&dev,&anillo);
+    barridoEnCurso  = &barrido;
+    puntosRecibidos = 0;
+
+    // sin arreglos: los puntos solo se publican
+    sim.measurements = 0;
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    TEST_ASSERT_EQUAL_UINT16(10,barrido.count);
+    TEST_ASSERT_EQUAL_UINT16(10,puntosRecibidos);
+    // el anillo de 8 puntos pierde los 2 ultimos
+    TEST_ASSERT_EQUAL_UINT32(2,atomic_load(&anillo.dropped));
+    while(AD5933_RingPop(&anillo,&punto))
+    {
+        TEST_ASSERT_EQUAL_UINT16(indice,punto.index);
+        indice++;
+    }
+    TEST_ASSERT_EQUAL_UINT16(8,indice);
+}
+
+/* testeo que el transporte en lotes mide lo mismo con menos llamadas */
+void test_transporteEnLotes(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, 50, 0};
+    signed short       realLote[50];
+    signed short       imagLote[50];
+    AD5933_SweepBuffer lote    = {realLote, imagLote, 50, 0};
+    unsigned long      llamadas = 0;
+
+    sim.conversionScale = 0;
+    AD5933_ConfigSweep(&dev,10000,1000,49);
+    AD5933_Sim_ResetCounters(&sim);
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    llamadas = sim.hostCalls;
+    TEST_ASSERT_EQUAL_UINT32(sim.transactions,llamadas);
+
+    AD5933_SetTransport(&dev,&AD5933_SIM_TRANSPORT);
+    AD5933_Sim_ResetCounters(&sim);
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&lote));
+    TEST_ASSERT_EQUAL_UINT16(50,lote.count);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(real,realLote,50);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(imag,imagLote,50);
+    // el inicio del barrido es una sola llamada
+    TEST_ASSERT_TRUE(sim.hostCalls < llamadas);
+    TEST_ASSERT_TRUE(sim.hostCalls < sim.transactions);
+}
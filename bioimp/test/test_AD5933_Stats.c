@@ -0,0 +1,114 @@
+/*
+Estadisticas del driver:
+contadores del bus y de las consultas de STATUS,
+e histogramas de latencia con el reloj virtual.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Stats.h"
+#include "AD5933_Sim.h"
+#include "math.h"
+
+#define PUNTOS  10
+
+static AD5933_Sim           sim;
+static AD5933_Device        dev;
+static AD5933_Stats         estadisticas;
+static AD5933_StatsSnapshot copia;
+static signed short         real[PUNTOS];
+static signed short         imag[PUNTOS];
+
+/* el reloj de las estadisticas es el tiempo virtual del simulador */
+static unsigned long long relojVirtual(void *contexto)
+{
+    return ((AD5933_Sim *)contexto)->nowNs;
+}
+
+static unsigned long totalHistograma(AD5933_Latency latencia)
+{
+    unsigned long total  = 0;
+    unsigned char indice = 0;
+
+    for(indice = 0; indice < AD5933_STATS_BUCKETS; indice++)
+    {
+        total += copia.histograms[latencia][indice];
+    }
+    return total;
+}
+
+void setUp(void)
+{
+    AD5933_Sim_Init(&sim,0x0D);
+    AD5933_Init(&dev,0x0D);
+    AD5933_SIM_ATTACH();
+    AD5933_StatsInit(&estadisticas,relojVirtual,&sim);
+    AD5933_SetStats(&dev,&estadisticas);
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim);
+}
+
+/* testeo los contadores de un barrido contra los del simulador */
+void test_contadoresBarrido(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, PUNTOS, 0};
+
+    AD5933_ConfigSweep(&dev,30000,1000,PUNTOS - 1);
+    AD5933_Sim_ResetCounters(&sim);
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    AD5933_StatsRead(&estadisticas,&copia);
+
+    TEST_ASSERT_EQUAL_UINT32(0,copia.retries);
+    TEST_ASSERT_EQUAL_UINT32(PUNTOS,copia.counters[AD5933_COUNTER_DATA_WAITS]);
+    TEST_ASSERT_EQUAL_UINT32(sim.statusPolls,copia.counters[AD5933_COUNTER_DATA_POLLS]);
+    // con los tiempos de la hoja de datos hay mas de una consulta por punto
+    TEST_ASSERT_TRUE(copia.counters[AD5933_COUNTER_DATA_POLLS] > PUNTOS);
+    TEST_ASSERT_EQUAL_UINT32(1,totalHistograma(AD5933_LATENCY_SWEEP));
+    TEST_ASSERT_EQUAL_UINT32(PUNTOS,totalHistograma(AD5933_LATENCY_POINT));
+    TEST_ASSERT_EQUAL_UINT32(1,totalHistograma(AD5933_LATENCY_CONFIG));
+
+    // la configuracion repetida no llega al bus
+    AD5933_ConfigSweep(&dev,30000,1000,PUNTOS - 1);
+    AD5933_StatsRead(&estadisticas,&copia);
+    TEST_ASSERT_EQUAL_UINT32(1,copia.counters[AD5933_COUNTER_REDUNDANT_WRITES]);
+    TEST_ASSERT_EQUAL_UINT32(2,totalHistograma(AD5933_LATENCY_CONFIG));
+}
+
+/* testeo que las operaciones del bus coinciden con las transacciones */
+void test_contadoresBus(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, PUNTOS, 0};
+
+    sim.conversionScale = 0;
+    AD5933_ConfigSweep(&dev,30000,1000,PUNTOS - 1);
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    TEST_ASSERT_FALSE(isnan(AD5933_GetTemperature(&dev,0)));
+    AD5933_StatsRead(&estadisticas,&copia);
+
+    TEST_ASSERT_EQUAL_UINT32(sim.reads,copia.counters[AD5933_COUNTER_BUS_READS]);
+    TEST_ASSERT_EQUAL_UINT32(sim.writes,copia.counters[AD5933_COUNTER_BUS_WRITES]);
+    TEST_ASSERT_EQUAL_UINT32(1,copia.counters[AD5933_COUNTER_TEMP_WAITS]);
+    TEST_ASSERT_EQUAL_UINT32(1,totalHistograma(AD5933_LATENCY_TEMPERATURE));
+}
+
+/* testeo los cuantiles contra el tiempo virtual de cada punto */
+void test_cuantilesLatencia(void)
+{
+    AD5933_SweepBuffer barrido = {real, imag, PUNTOS, 0};
+    unsigned long      punto   = 0;
+
+    AD5933_ConfigSweep(&dev,30000,1000,PUNTOS - 1);
+    AD5933_Sim_ResetCounters(&sim);
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    AD5933_StatsRead(&estadisticas,&copia);
+
+    // la mediana acota el tiempo medio de un punto por arriba y por debajo
+    punto = (unsigned long)(sim.nowNs / 1000 / PUNTOS);
+    TEST_ASSERT_TRUE(AD5933_StatsQuantile(&copia,AD5933_LATENCY_POINT,0.5f) >= punto / 2);
+    TEST_ASSERT_TRUE(AD5933_StatsQuantile(&copia,AD5933_LATENCY_POINT,0.5f) < punto * 2);
+    TEST_ASSERT_TRUE(AD5933_StatsQuantile(&copia,AD5933_LATENCY_SWEEP,1.0f) >= sim.nowNs / 1000);
+    TEST_ASSERT_EQUAL_UINT32(0,AD5933_StatsQuantile(&copia,AD5933_LATENCY_TEMPERATURE,0.5f));
+}
@@ -0,0 +1,148 @@
+/*
+Modo continuo a frecuencia fija:
+DFT repetidas con REPEAT_FREQ, marcadas en el tiempo
+y diezmadas con CIC y FIR mientras se adquieren.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Stream.h"
+#include "AD5933_Sim.h"
+#include "math.h"
+
+#define MUESTRAS    64
+
+static AD5933_Sim          sim;
+static AD5933_Device       dev;
+static AD5933_Stream       flujo;
+static AD5933_Ring         anillo;
+static AD5933_StreamSample muestras[MUESTRAS];
+
+static unsigned long long relojSimulado(void *contexto)
+{
+    return ((AD5933_Sim *)contexto)->nowNs;
+}
+
+void setUp(void)
+{
+    AD5933_Sim_Init(&sim,0x0D);
+    AD5933_Init(&dev,0x0D);
+    AD5933_SIM_ATTACH();
+    AD5933_RingInit(&anillo,muestras,sizeof(AD5933_StreamSample),MUESTRAS);
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim);
+}
+
+/* testeo que el CIC diezma y con entrada constante da la misma constante */
+void test_diezmadoCic(void)
+{
+    AD5933_StreamConfig config  = {10000, 15, AD5933_SETTLING_X1, 3, 8,
+                                   0, 0, 1, 0, 0};
+    AD5933_StreamSample muestra;
+    unsigned short      entrada = 0;
+
+    TEST_ASSERT_TRUE(AD5933_InitStream(&flujo,&config,&anillo));
+    for(entrada = 0; entrada < 8 * 10; entrada++)
+    {
+        TEST_ASSERT_EQUAL((entrada % 8) == 7,
+                          AD5933_FeedStream(&flujo,1000,-500,entrada * 1000ull));
+    }
+    TEST_ASSERT_EQUAL_UINT32(10,flujo.outputs);
+    // pasado el transitorio de los tres peines la salida es exacta
+    while(AD5933_RingPop(&anillo,&muestra))
+    {
+        if(muestra.index >= 3)
+        {
+            TEST_ASSERT_EQUAL_FLOAT(1000,muestra.realData);
+            TEST_ASSERT_EQUAL_FLOAT(-500,muestra.imagData);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT64(79000,muestra.timestampNs);
+    TEST_ASSERT_EQUAL_FLOAT(10.5f,AD5933_GetStreamDelay(&config));
+    // una ganancia que no cabe en 64 bits se rechaza
+    config.cicOrder = 4;
+    config.cicRatio = 8192;
+    TEST_ASSERT_FALSE(AD5933_InitStream(&flujo,&config,&anillo));
+}
+
+/* testeo el FIR con diezmado: promedio movil de 4 cada 2 entradas */
+void test_diezmadoFir(void)
+{
+    static const float  promedio[4] = {0.25f, 0.25f, 0.25f, 0.25f};
+    AD5933_StreamConfig config  = {10000, 15, AD5933_SETTLING_X1, 0, 1,
+                                   promedio, 4, 2, 0, 0};
+    AD5933_StreamSample muestra;
+    signed short        entrada = 0;
+
+    TEST_ASSERT_TRUE(AD5933_InitStream(&flujo,&config,&anillo));
+    for(entrada = 0; entrada < 8; entrada++)
+    {
+        AD5933_FeedStream(&flujo,entrada,-2 * entrada,0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(4,flujo.outputs);
+    while(AD5933_RingPop(&anillo,&muestra))
+    {
+    }
+    // promedio de 4, 5, 6 y 7
+    TEST_ASSERT_EQUAL_FLOAT(5.5f,muestra.realData);
+    TEST_ASSERT_EQUAL_FLOAT(-11,muestra.imagData);
+    TEST_ASSERT_EQUAL_FLOAT(1.5f,AD5933_GetStreamDelay(&config));
+}
+
+/* testeo que cada DFT cuesta una escritura y una lectura del bloque */
+void test_modoContinuo(void)
+{
+    AD5933_StreamConfig config   = {10000, 15, AD5933_SETTLING_X1, 2, 4,
+                                    0, 0, 1, relojSimulado, &sim};
+    AD5933_StreamSample muestra;
+    AD5933_StreamSample anterior;
+    AD5933_PollResult   resultado = AD5933_POLL_PENDING;
+    double              real      = 0;
+    double              imag      = 0;
+    unsigned long       escrituras = 0;
+    unsigned long       lecturas  = 0;
+
+    TEST_ASSERT_TRUE(AD5933_InitStream(&flujo,&config,&anillo));
+    TEST_ASSERT_TRUE(AD5933_StartStream(&dev,&flujo));
+    // el reloj virtual vuelve a 0 con los contadores
+    AD5933_Sim_ResetCounters(&sim);
+    flujo.armedNs = 0;
+    while(flujo.inputs < 4 * 40)
+    {
+        resultado = AD5933_ServiceStream(&dev,&flujo);
+        TEST_ASSERT_TRUE(resultado == AD5933_POLL_PENDING ||
+                         resultado == AD5933_POLL_READY);
+        if(resultado == AD5933_POLL_PENDING)
+        {
+            // el host espera sin tocar el bus
+            AD5933_Sim_Advance(&sim,5000);
+        }
+    }
+    escrituras = sim.writes;
+    lecturas   = sim.reads;
+    TEST_ASSERT_TRUE(AD5933_StopStream(&dev));
+    // mas el puntero de direccion de la primera lectura
+    TEST_ASSERT_EQUAL_UINT32(4 * 40 + 1,escrituras);
+    TEST_ASSERT_EQUAL_UINT32(4 * 40,lecturas);
+    TEST_ASSERT_EQUAL_UINT32(40,flujo.outputs);
+
+    // las muestras diezmadas siguen la impedancia y avanzan en el tiempo
+    AD5933_Sim_Impedance(&sim,10000,&real,&imag);
+    TEST_ASSERT_TRUE(AD5933_RingPop(&anillo,&anterior));
+    while(AD5933_RingPop(&anillo,&muestra))
+    {
+        TEST_ASSERT_TRUE(muestra.timestampNs > anterior.timestampNs);
+        TEST_ASSERT_EQUAL_UINT32(anterior.index + 1,muestra.index);
+        if(muestra.index >= 2)
+        {
+            TEST_ASSERT_FLOAT_WITHIN(0.01 * sim.dftScale / real,
+                                     hypot(muestra.realData,muestra.imagData),
+                                     sim.dftScale / hypot(real,imag));
+        }
+        anterior = muestra;
+    }
+    TEST_ASSERT_EQUAL_UINT32(39,anterior.index);
+}
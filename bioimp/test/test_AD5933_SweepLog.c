@@ -0,0 +1,187 @@
+/*
+Registro binario de barridos:
+escritura con buffer fijo y lectura
+mapeando el archivo en memoria.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_SweepLog.h"
+#include "math.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+
+#define PUNTOS  1500
+
+static AD5933_Device dev;
+static char          archivo[] = "/tmp/AD5933_SweepLogXXXXXX";
+
+void setUp(void)
+{
+    int fd = mkstemp(archivo);
+
+    close(fd);
+    AD5933_Init(&dev,0x0D);
+    dev.range = AD5933_RANGE_1000mVpp;
+    dev.gain  = AD5933_GAIN_X1;
+}
+void tearDown(void)
+{
+    unlink(archivo);
+    strcpy(archivo,"/tmp/AD5933_SweepLogXXXXXX");
+}
+
+/* testeo que la cabecera sale del perfil y del estado del dispositivo */
+void test_cabecera(void)
+{
+    AD5933_SweepProfile perfil;
+    AD5933_SweepHeader  cabecera;
+
+    AD5933_CompileSweepProfile(&dev,&perfil,30000,10,100,15,AD5933_SETTLING_X2);
+    AD5933_SweepLogHeader(&dev,&perfil,24.5f,1234,&cabecera);
+    TEST_ASSERT_EQUAL_HEX32(0x0F5C29,cabecera.startCode);
+    TEST_ASSERT_EQUAL_HEX32(0x000150,cabecera.incCode);
+    TEST_ASSERT_EQUAL_UINT32(perfil.sysClk,cabecera.sysClk);
+    TEST_ASSERT_EQUAL_UINT16(101,cabecera.points);
+    TEST_ASSERT_EQUAL_INT16(784,cabecera.temperature);
+    TEST_ASSERT_EQUAL_HEX8(AD5933_RANGE_1000mVpp,cabecera.range);
+    TEST_ASSERT_EQUAL_HEX8(AD5933_GAIN_X1,cabecera.gain);
+    AD5933_SweepLogHeader(&dev,&perfil,NAN,1234,&cabecera);
+    TEST_ASSERT_EQUAL_INT16(-32768,cabecera.temperature);
+}
+
+/* testeo escribir varios barridos y leerlos en cualquier orden */
+void test_escribirYLeer(void)
+{
+    static signed short    real[PUNTOS];
+    static signed short    imag[PUNTOS];
+    static signed short    leidoReal[PUNTOS];
+    static signed short    leidoImag[PUNTOS];
+    static AD5933_SweepLogWriter escritor;
+    AD5933_SweepBuffer     barrido = {real, imag, PUNTOS, 0};
+    AD5933_SweepBuffer     leido   = {leidoReal, leidoImag, PUNTOS, 0};
+    AD5933_SweepHeader     cabecera = {0x0F5C29, 0x150, 16000000ul, 0, 800, 0,
+                                       AD5933_RANGE_1000mVpp, AD5933_GAIN_X1, 0};
+    AD5933_SweepLogReader  lector;
+    unsigned short         punto = 0;
+    unsigned long          n     = 0;
+
+    TEST_ASSERT_TRUE(AD5933_SweepLogCreate(&escritor,archivo));
+    for(n = 0; n < 3; n++)
+    {
+        for(punto = 0; punto < PUNTOS; punto++)
+        {
+            real[punto] = (signed short)(punto * (n + 1));
+            imag[punto] = (signed short)(-punto - n);
+        }
+        barrido.count      = (unsigned short)(10 + n * 700);
+        cabecera.timestamp = 0x100000000ull + n;
+        TEST_ASSERT_TRUE(AD5933_SweepLogAppend(&escritor,&cabecera,&barrido));
+    }
+    TEST_ASSERT_TRUE(AD5933_SweepLogCloseWriter(&escritor));
+
+    /* reabrir para agregar no repite la cabecera del archivo */
+    TEST_ASSERT_TRUE(AD5933_SweepLogCreate(&escritor,archivo));
+    barrido.count = 0;
+    TEST_ASSERT_TRUE(AD5933_SweepLogAppend(&escritor,&cabecera,&barrido));
+    TEST_ASSERT_TRUE(AD5933_SweepLogCloseWriter(&escritor));
+
+    TEST_ASSERT_TRUE(AD5933_SweepLogOpen(&lector,archivo));
+    TEST_ASSERT_EQUAL_UINT32(4,lector.count);
+    TEST_ASSERT_EQUAL_UINT32(16 + 4 * 32 + 4 * (10 + 710 + 1410),lector.size);
+
+    TEST_ASSERT_TRUE(AD5933_SweepLogRead(&lector,2,&cabecera,&leido));
+    TEST_ASSERT_EQUAL_UINT16(1410,cabecera.points);
+    TEST_ASSERT_EQUAL_UINT16(1410,leido.count);
+    TEST_ASSERT_TRUE(cabecera.timestamp == 0x100000002ull);
+    TEST_ASSERT_EQUAL_INT16(800,cabecera.temperature);
+    TEST_ASSERT_EQUAL_HEX32(0x0F5C29,cabecera.startCode);
+    TEST_ASSERT_EQUAL_UINT32(16000000ul,cabecera.sysClk);
+    TEST_ASSERT_EQUAL_INT16(3 * 1409,leidoReal[1409]);
+    TEST_ASSERT_EQUAL_INT16(-1409 - 2,leidoImag[1409]);
+
+    TEST_ASSERT_TRUE(AD5933_SweepLogRead(&lector,0,&cabecera,&leido));
+    TEST_ASSERT_EQUAL_UINT16(10,leido.count);
+    TEST_ASSERT_EQUAL_INT16(9,leidoReal[9]);
+    TEST_ASSERT_TRUE(AD5933_SweepLogRead(&lector,3,&cabecera,0));
+    TEST_ASSERT_EQUAL_UINT16(0,cabecera.points);
+    TEST_ASSERT_FALSE(AD5933_SweepLogRead(&lector,4,&cabecera,&leido));
+
+    /* un buffer chico recibe los puntos que entran */
+    leido.capacity = 5;
+    TEST_ASSERT_FALSE(AD5933_SweepLogRead(&lector,1,&cabecera,&leido));
+    TEST_ASSERT_EQUAL_UINT16(5,leido.count);
+    TEST_ASSERT_EQUAL_INT16(8,leidoReal[4]);
+    AD5933_SweepLogClose(&lector);
+    TEST_ASSERT_EQUAL_UINT32(0,lector.count);
+}
+
+/* testeo que un registro cortado al final del archivo se ignora */
+void test_archivoCortado(void)
+{
+    static AD5933_SweepLogWriter escritor;
+    signed short           real[4] = {1, 2, 3, 4};
+    signed short           imag[4] = {5, 6, 7, 8};
+    AD5933_SweepBuffer     barrido = {real, imag, 4, 4};
+    AD5933_SweepHeader     cabecera = {0};
+    AD5933_SweepLogReader  lector;
+
+    TEST_ASSERT_TRUE(AD5933_SweepLogCreate(&escritor,archivo));
+    TEST_ASSERT_TRUE(AD5933_SweepLogAppend(&escritor,&cabecera,&barrido));
+    TEST_ASSERT_TRUE(AD5933_SweepLogAppend(&escritor,&cabecera,&barrido));
+    TEST_ASSERT_TRUE(AD5933_SweepLogCloseWriter(&escritor));
+    TEST_ASSERT_EQUAL_INT(0,truncate(archivo,16 + 2 * (32 + 16) - 3));
+
+    TEST_ASSERT_TRUE(AD5933_SweepLogOpen(&lector,archivo));
+    TEST_ASSERT_EQUAL_UINT32(1,lector.count);
+    AD5933_SweepLogClose(&lector);
+
+    /* un archivo que no es un registro de barridos se rechaza */
+    TEST_ASSERT_EQUAL_INT(0,truncate(archivo,8));
+    TEST_ASSERT_FALSE(AD5933_SweepLogOpen(&lector,archivo));
+    TEST_ASSERT_FALSE(AD5933_SweepLogCreate(&escritor,archivo));
+}
+
+/* testeo que al reabrir un archivo cortado se agrega despues del ultimo
+   registro completo */
+void test_reabrirArchivoCortado(void)
+{
+    static AD5933_SweepLogWriter escritor;
+    signed short           real[4] = {1, 2, 3, 4};
+    signed short           imag[4] = {5, 6, 7, 8};
+    signed short           leidoReal[4];
+    signed short           leidoImag[4];
+    AD5933_SweepBuffer     barrido = {real, imag, 4, 4};
+    AD5933_SweepBuffer     leido   = {leidoReal, leidoImag, 4, 0};
+    AD5933_SweepHeader     cabecera = {0};
+    AD5933_SweepLogReader  lector;
+    unsigned char          indice  = 0;
+
+    TEST_ASSERT_TRUE(AD5933_SweepLogCreate(&escritor,archivo));
+    TEST_ASSERT_TRUE(AD5933_SweepLogAppend(&escritor,&cabecera,&barrido));
+    TEST_ASSERT_TRUE(AD5933_SweepLogAppend(&escritor,&cabecera,&barrido));
+    TEST_ASSERT_TRUE(AD5933_SweepLogCloseWriter(&escritor));
+    TEST_ASSERT_EQUAL_INT(0,truncate(archivo,16 + 2 * (32 + 16) - 3));
+
+    // el escritor descarta el registro cortado antes de agregar
+    TEST_ASSERT_TRUE(AD5933_SweepLogCreate(&escritor,archivo));
+    for(indice = 0; indice < 5; indice++)
+    {
+        cabecera.timestamp = 100 + indice;
+        TEST_ASSERT_TRUE(AD5933_SweepLogAppend(&escritor,&cabecera,&barrido));
+    }
+    TEST_ASSERT_TRUE(AD5933_SweepLogCloseWriter(&escritor));
+
+    TEST_ASSERT_TRUE(AD5933_SweepLogOpen(&lector,archivo));
+    TEST_ASSERT_EQUAL_UINT32(6,lector.count);
+    for(indice = 1; indice < 6; indice++)
+    {
+        TEST_ASSERT_TRUE(AD5933_SweepLogRead(&lector,indice,&cabecera,&leido));
+        TEST_ASSERT_EQUAL_UINT64(99 + indice,cabecera.timestamp);
+        TEST_ASSERT_EQUAL_INT16_ARRAY(real,leidoReal,4);
+        TEST_ASSERT_EQUAL_INT16_ARRAY(imag,leidoImag,4);
+    }
+    AD5933_SweepLogClose(&lector);
+}
@@ -0,0 +1,79 @@
+/*
+Servicio de temperatura:
+la temperatura se mide en los huecos entre barridos
+sin esperar el bit TEMP_VALID.
+*/
+
+#include "unity.h"
+#include "mock_i2c.h"
+#include "AD5933.h"
+#include "AD5933_Temperature.h"
+#include "AD5933_Sim.h"
+#include "math.h"
+
+static AD5933_Sim         sim;
+static AD5933_Device      dev;
+static AD5933_TempService servicio;
+
+void setUp(void)
+{
+    AD5933_Sim_Init(&sim,0x0D);
+    AD5933_Init(&dev,0x0D);
+    AD5933_SIM_ATTACH();
+    sim.temperature = 31.5;
+    AD5933_InitTempService(&servicio,1000);
+}
+void tearDown(void)
+{
+    AD5933_Sim_Detach(&sim);
+}
+
+/* testeo que la medicion no bloquea y queda en la cache con su edad */
+void test_temperaturaEnSegundoPlano(void)
+{
+    unsigned long edad = 0;
+    unsigned long llamadas = 0;
+
+    TEST_ASSERT_TRUE(isnan(AD5933_GetCachedTemperature(&servicio,0,&edad)));
+    TEST_ASSERT_FALSE(AD5933_ServiceTemperature(&dev,&servicio,0));
+    TEST_ASSERT_TRUE(servicio.pending);
+    // comando y puntero de direccion, despues una sola lectura del estado
+    // por llamada
+    while(!AD5933_ServiceTemperature(&dev,&servicio,5))
+    {
+        llamadas++;
+        TEST_ASSERT_EQUAL_UINT32(llamadas + 2,sim.transactions);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-6,31.5,AD5933_GetCachedTemperature(&servicio,305,&edad));
+    TEST_ASSERT_EQUAL_UINT32(300,edad);
+
+    // no hay otra medicion hasta que pase el periodo
+    sim.transactions = 0;
+    TEST_ASSERT_FALSE(AD5933_ServiceTemperature(&dev,&servicio,900));
+    TEST_ASSERT_EQUAL_UINT32(0,sim.transactions);
+    sim.temperature = 33;
+    TEST_ASSERT_FALSE(AD5933_ServiceTemperature(&dev,&servicio,1005));
+    TEST_ASSERT_TRUE(servicio.pending);
+    while(!AD5933_ServiceTemperature(&dev,&servicio,1010))
+    {
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-6,33,AD5933_GetCachedTemperature(&servicio,1010,0));
+    TEST_ASSERT_EQUAL_UINT32(2,servicio.samples);
+}
+
+/* testeo que un barrido cancela la medicion y se reintenta despues */
+void test_barridoInterrumpe(void)
+{
+    signed short       real[3];
+    signed short       imag[3];
+    AD5933_SweepBuffer barrido = {real, imag, 3, 0};
+
+    sim.conversionScale = 0;
+    AD5933_ConfigSweep(&dev,10000,1000,2);
+    TEST_ASSERT_FALSE(AD5933_ServiceTemperature(&dev,&servicio,0));
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&barrido));
+    TEST_ASSERT_FALSE(AD5933_ServiceTemperature(&dev,&servicio,10));
+    TEST_ASSERT_TRUE(servicio.pending);
+    TEST_ASSERT_TRUE(AD5933_ServiceTemperature(&dev,&servicio,11));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6,31.5,servicio.temperature);
+}
@@ -11,10 +11,12 @@ un espectro de 100 Hz a 100 kHz.
 #include "math.h"
 
 //static uint16_t puerto;
+static AD5933_Device dev;
 
 void setUp(void)
 {
     //  LedsInit(&puerto);
+    AD5933_Init(&dev,0x0D);
 }
 void tearDown(void)
 {
@@ -31,15 +33,20 @@ void test_AD5933_tomaTemperatura(void)
     int registerAddress_TEMP_DATA_1 = 0x92;
     int registerAddress_TEMP_DATA_2 = 0x93;
 
+    unsigned char estado = 1;
+
     // escritura registro BARRIDO
     wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,writeData[0],writeData[1],true);
-    // lectura registro STATUS
-    wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,registerAddress_STATUS,1);
+    // lectura registro STATUS con lectura en bloque
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,registerAddress_STATUS,true);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,1,1);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(&estado,1);
     // lectura registro TEMP_1
     wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,registerAddress_TEMP_DATA_1,1);
     // lectura registro TEMP_2
     wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,registerAddress_TEMP_DATA_2,1);
-    float val = AD5933_GetTemperature(status);
+    float val = AD5933_GetTemperature(&dev,status);
     TEST_ASSERT_EQUAL_FLOAT(8.03125,val);
 }
 
@@ -47,7 +54,7 @@ void test_AD5933_tomaTemperatura(void)
 void test_AD5933_Init(void)
 {
     int inicio = 1;
-    bool res = AD5933_Init(inicio);
+    bool res = AD5933_Init(&dev,inicio);
     TEST_ASSERT_TRUE(res);
 }
 
@@ -55,7 +62,7 @@ void test_AD5933_Init(void)
 void test_AD5933_NO_Init(void)
 {
     int inicio = 0;
-    bool res = AD5933_Init(inicio);
+    bool res = AD5933_Init(&dev,inicio);
     TEST_ASSERT_FALSE(res);
 }
 
@@ -68,7 +75,7 @@ void test_lecturaRegistro(void)
     int registerAddress = 0x0D;
     //lectura de registro
     wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,registerAddress,1);
-    resultado = AD5933_GetRegisterValue(i2cdevice,numero);
+    resultado = AD5933_GetRegisterValue(&dev,i2cdevice,numero);
     TEST_ASSERT_EQUAL_INT64 (1, resultado);
 }
 
@@ -81,24 +88,21 @@ void test_calculoFactorGanancia(void)
     int i2cdevice = 0x0D;
     unsigned char registerAddress_BARRIDO = 0x8F;
     unsigned char registerAddress_R1 = 0x94;
-    unsigned char registerAddress_R2 = 0x95;
-    unsigned char registerAddress_R3 = 0x96;
-    unsigned char registerAddress_R4 = 0x97;
     unsigned char writeData[2]  ={0x80, 0x81};
+    unsigned char bloque[4] = {0, 3, 0, 4};
 
     // escritura registro BARRIDO
     wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,writeData[0],writeData[1],true);
-    // lectura registro parte_REAL1
-    wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,registerAddress_R1,0);
-    // lectura registro parte_REAL2
-    wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,registerAddress_R2,0);
-    // lectura registro parte_IMG1
-    wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,registerAddress_R3,0);
-    // lectura registro parte_IMG2
-    wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,registerAddress_R4,0);
+    // puntero de direccion a parte_REAL1
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,registerAddress_R1,true);
+    // lectura en bloque de parte_REAL y parte_IMG
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,4,4);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(bloque,4);
 
-    factorGanancia = AD5933_CalculateGainFactor(calibracion,frecuenciaFuncion);
-    TEST_ASSERT_EQUAL_UINT32(0,factorGanancia);
+    factorGanancia = AD5933_CalculateGainFactor(&dev,calibracion,frecuenciaFuncion);
+    // |3 + 4j| = 5, 1 / (5 * 1000)
+    TEST_ASSERT_EQUAL_DOUBLE(0.0002,factorGanancia);
 }
 
 /* testeo la puesta en Stand By */
@@ -109,6 +113,336 @@ void test_ponerStandBy(void)
     // escritura registro STANDBY
     wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,writeData[0],writeData[1],true);
 
-    bool val = AD5933_SetToStandBy();
+    bool val = AD5933_SetToStandBy(&dev);
     TEST_ASSERT_TRUE(val);
-}
\ No newline at end of file
+}
+
+/* testeo la lectura en bloque de STATUS, parte real e imaginaria */
+void test_lecturaBloqueDatos(void)
+{
+    int i2cdevice = 0x0D;
+    unsigned char bloque[9] = {0x02, 0, 0, 0, 0, 0x01, 0x2C, 0xFF, 0x38};
+    signed short real = 0;
+    signed short imag = 0;
+    unsigned char status = 0;
+
+    // puntero de direccion a STATUS
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x8F,true);
+    // lectura en bloque de STATUS hasta parte_IMG
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,9,9);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(bloque,9);
+
+    TEST_ASSERT_TRUE(AD5933_GetData(&dev,&real,&imag,&status));
+    TEST_ASSERT_EQUAL_HEX8(0x02,status);
+    TEST_ASSERT_EQUAL_INT16(300,real);
+    TEST_ASSERT_EQUAL_INT16(-200,imag);
+}
+
+/* testeo que el puntero de direccion no se reescribe entre lecturas en bloque */
+void test_lecturaBloqueSinRepetirPuntero(void)
+{
+    int i2cdevice = 0x0D;
+    unsigned char bloque[4] = {0, 1, 0, 2};
+    signed short real = 0;
+    signed short imag = 0;
+
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x94,true);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,4,4);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(bloque,4);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,4,4);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(bloque,4);
+
+    TEST_ASSERT_TRUE(AD5933_GetData(&dev,&real,&imag,NULL));
+    TEST_ASSERT_TRUE(AD5933_GetData(&dev,&real,&imag,NULL));
+    TEST_ASSERT_EQUAL_INT16(1,real);
+    TEST_ASSERT_EQUAL_INT16(2,imag);
+}
+
+
+/* testeo la conversion exacta de frecuencia a codigo y de codigo a frecuencia */
+void test_codigoFrecuencia(void)
+{
+    // tabla calculada en tiempo de compilacion
+    static const unsigned long codigos[3] = {AD5933_INT_FREQ_CODE(1000),
+                                             AD5933_INT_FREQ_CODE(30000),
+                                             AD5933_INT_FREQ_CODE(100000)};
+    AD5933_SweepProfile perfil;
+
+    // 30000 * 2^29 / 16 MHz = 1006632.96, se redondea
+    TEST_ASSERT_EQUAL_UINT32(33554,codigos[0]);
+    TEST_ASSERT_EQUAL_UINT32(1006633,codigos[1]);
+    TEST_ASSERT_EQUAL_UINT32(3355443,codigos[2]);
+    TEST_ASSERT_EQUAL_UINT32(codigos[1],AD5933_FrequencyToCode(30000,16000000ul));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFF,AD5933_FrequencyToCode(1000000ul,16000000ul));
+    TEST_ASSERT_EQUAL_UINT32(30000001,AD5933_CodeToFrequency(codigos[1],16000000ul));
+
+    // frecuencia real de cada punto del barrido
+    AD5933_CompileSweepProfile(&dev,&perfil,30000,10,100,15,AD5933_SETTLING_X2);
+    TEST_ASSERT_EQUAL_UINT32(30000001,AD5933_GetPointFrequency(&perfil,0));
+    TEST_ASSERT_EQUAL_UINT32(31001359,AD5933_GetPointFrequency(&perfil,100));
+}
+
+/* testeo que el perfil de barrido se carga con una sola escritura en bloque */
+void test_cargaPerfilBarrido(void)
+{
+    int i2cdevice = 0x0D;
+    AD5933_SweepProfile perfil;
+    unsigned char imagen[10] = {0x0F, 0x5C, 0x29,   // 30 kHz
+                                0x00, 0x01, 0x50,   // 10 Hz
+                                0x00, 0x64,         // 100 incrementos
+                                0x02, 0x0F};        // 15 ciclos x2
+
+    AD5933_CompileSweepProfile(&dev,&perfil,30000,10,100,15,AD5933_SETTLING_X2);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(imagen,perfil.image,10);
+
+    // puntero de direccion a FREQ_START
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x82,true);
+    // escritura en bloque de 0x82 a 0x8B
+    wiringPiI2CWriteBlockData_ExpectWithArrayAndReturn(i2cdevice,0xA0,imagen,10,10,true);
+
+    TEST_ASSERT_TRUE(AD5933_LoadSweepProfile(&dev,&perfil));
+}
+
+/* testeo que el perfil armado con codigos se decodifica igual */
+void test_perfilPorCodigos(void)
+{
+    AD5933_SweepProfile perfil;
+    AD5933_SweepProfile porCodigos;
+    unsigned long  inicio = 0;
+    unsigned long  incremento = 0;
+    unsigned short incrementos = 0;
+    unsigned short asentamiento = 0;
+
+    AD5933_CompileSweepProfile(&dev,&perfil,30000,10,100,15,AD5933_SETTLING_X2);
+    AD5933_DecodeSweepProfile(&perfil,&inicio,&incremento,&incrementos,&asentamiento);
+    TEST_ASSERT_EQUAL_HEX32(0x0F5C29,inicio);
+    TEST_ASSERT_EQUAL_HEX32(0x000150,incremento);
+    TEST_ASSERT_EQUAL_UINT16(100,incrementos);
+    TEST_ASSERT_EQUAL_HEX16(0x020F,asentamiento);
+    AD5933_CompileCodeProfile(&porCodigos,inicio,incremento,incrementos,
+                              asentamiento,perfil.sysClk);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(perfil.image,porCodigos.image,10);
+    TEST_ASSERT_EQUAL_UINT32(perfil.sysClk,porCodigos.sysClk);
+}
+
+/* testeo un barrido completo de dos puntos sobre el buffer del usuario */
+void test_barridoCompleto(void)
+{
+    int i2cdevice = 0x0D;
+    signed short real[2];
+    signed short imag[2];
+    AD5933_SweepBuffer buffer = {real, imag, 2, 0};
+    unsigned char esperando[9] = {0x00, 0, 0, 0, 0, 0, 0, 0, 0};
+    unsigned char punto1[9] = {0x02, 0, 0, 0, 0, 0x00, 0x64, 0xFF, 0x9C};
+    unsigned char punto2[9] = {0x06, 0, 0, 0, 0, 0x00, 0xC8, 0xFF, 0x38};
+
+    // STANDBY, RESET, INIT_START_FREQ y START_SWEEP
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0xB1,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x81,0x10,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0x11,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0x21,true);
+    // primer punto: el puntero se fija una sola vez
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x8F,true);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,9,9);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(esperando,9);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,9,9);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(punto1,9);
+    // INC_FREQ y segundo punto con SWEEP_DONE
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0x31,true);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,9,9);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(punto2,9);
+
+    TEST_ASSERT_TRUE(AD5933_RunSweep(&dev,&buffer));
+    TEST_ASSERT_EQUAL_UINT16(2,buffer.count);
+    TEST_ASSERT_EQUAL_INT16(100,real[0]);
+    TEST_ASSERT_EQUAL_INT16(-100,imag[0]);
+    TEST_ASSERT_EQUAL_INT16(200,real[1]);
+    TEST_ASSERT_EQUAL_INT16(-200,imag[1]);
+}
+
+
+/* testeo que una segunda puesta en Stand By no vuelve a escribir el registro */
+void test_ponerStandByDosVeces(void)
+{
+    int i2cdevice = 0x0D;
+    // una sola escritura registro STANDBY
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0xB1,true);
+
+    TEST_ASSERT_TRUE(AD5933_SetToStandBy(&dev));
+    TEST_ASSERT_TRUE(AD5933_SetToStandBy(&dev));
+}
+
+/* testeo que los registros se reescriben desde la copia luego de un reinicio */
+void test_restaurarRegistros(void)
+{
+    int i2cdevice = 0x0D;
+    AD5933_SweepProfile perfil;
+
+    AD5933_CompileSweepProfile(&dev,&perfil,30000,10,100,15,AD5933_SETTLING_X2);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x82,true);
+    wiringPiI2CWriteBlockData_ExpectWithArrayAndReturn(i2cdevice,0xA0,perfil.image,10,10,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0xB1,true);
+    TEST_ASSERT_TRUE(AD5933_LoadSweepProfile(&dev,&perfil));
+    TEST_ASSERT_TRUE(AD5933_SetToStandBy(&dev));
+
+    // el mismo perfil no se vuelve a cargar
+    TEST_ASSERT_TRUE(AD5933_LoadSweepProfile(&dev,&perfil));
+
+    // restauracion: perfil, reloj y STANDBY
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x82,true);
+    wiringPiI2CWriteBlockData_ExpectWithArrayAndReturn(i2cdevice,0xA0,perfil.image,10,10,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x81,0x00,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0xB1,true);
+    TEST_ASSERT_TRUE(AD5933_RestoreRegisters(&dev));
+}
+
+
+/* testeo que dos dispositivos no comparten el estado de rango y ganancia */
+void test_dosDispositivos(void)
+{
+    AD5933_Device otro;
+
+    TEST_ASSERT_TRUE(AD5933_Init(&otro,0x0E));
+    wiringPiI2CWriteReg8_ExpectAndReturn(0x0E,0x80,0x06,true);
+    AD5933_SetRangeAndGain(&otro,AD5933_RANGE_1000mVpp,AD5933_GAIN_X5);
+
+    // el primer dispositivo sigue en 2 Vpp y ganancia x1
+    wiringPiI2CWriteReg8_ExpectAndReturn(0x0D,0x80,0xB1,true);
+    TEST_ASSERT_TRUE(AD5933_SetToStandBy(&dev));
+    // el segundo usa su propio rango y ganancia
+    wiringPiI2CWriteReg8_ExpectAndReturn(0x0E,0x80,0xB6,true);
+    TEST_ASSERT_TRUE(AD5933_SetToStandBy(&otro));
+}
+
+
+/* testeo que la consulta no bloqueante informa el vencimiento del plazo */
+void test_consultaConTimeout(void)
+{
+    int i2cdevice = 0x0D;
+    unsigned char esperando[1] = {0x00};
+
+    AD5933_SetPollLimit(&dev,2);
+    // escritura registro TEMPERATURA
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0x91,true);
+    // dos lecturas de STATUS sin TEMP_VALID
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x8F,true);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,1,1);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(esperando,1);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,1,1);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(esperando,1);
+
+    TEST_ASSERT_TRUE(AD5933_BeginTemperature(&dev));
+    TEST_ASSERT_EQUAL(AD5933_POLL_PENDING,AD5933_Poll(&dev));
+    TEST_ASSERT_EQUAL(AD5933_POLL_TIMEOUT,AD5933_Poll(&dev));
+    // sin operacion pendiente no hay acceso al bus
+    TEST_ASSERT_EQUAL(AD5933_POLL_ERROR,AD5933_Poll(&dev));
+}
+
+/* testeo que un error del bus al consultar la temperatura no da un estado falso */
+void test_consultaTemperaturaErrorBus(void)
+{
+    int i2cdevice = 0x0D;
+
+    // escritura registro TEMPERATURA
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0x91,true);
+    // el chip no responde a la lectura de STATUS
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x8F,true);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,1,-1);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+
+    TEST_ASSERT_TRUE(isnan(AD5933_GetTemperature(&dev,0)));
+    // la operacion ya no esta pendiente
+    TEST_ASSERT_EQUAL(AD5933_POLL_ERROR,AD5933_Poll(&dev));
+}
+
+/* testeo que un error al leer el dato de temperatura no se lee como 0 grados */
+void test_datoTemperaturaErrorBus(void)
+{
+    int i2cdevice = 0x0D;
+    unsigned long valor = 7;
+
+    // el chip no responde al primer byte del dato
+    wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,0x92,-1);
+    TEST_ASSERT_FALSE(AD5933_ReadRegisterValue(&dev,0x92,2,&valor));
+    TEST_ASSERT_EQUAL_UINT32(7,valor);
+
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0x91,true);
+    wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,0x92,0x01);
+    wiringPiI2CReadReg8_ExpectAndReturn(i2cdevice,0x93,-1);
+    TEST_ASSERT_TRUE(isnan(AD5933_GetTemperature(&dev,AD5933_STAT_TEMP_VALID)));
+}
+
+/* testeo una medicion no bloqueante con REPEAT_FREQ */
+void test_medicionNoBloqueante(void)
+{
+    int i2cdevice = 0x0D;
+    unsigned char esperando[9] = {0x00, 0, 0, 0, 0, 0, 0, 0, 0};
+    unsigned char listo[9] = {0x02, 0, 0, 0, 0, 0x01, 0x00, 0x00, 0x80};
+    signed short real = 0;
+    signed short imag = 0;
+    unsigned char status = 0;
+
+    // escritura registro REPEAT_FREQ
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x80,0x41,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0xB0,0x8F,true);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,9,9);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(esperando,9);
+    wiringPiI2CReadBlockData_ExpectAndReturn(i2cdevice,0xA1,NULL,9,9);
+    wiringPiI2CReadBlockData_IgnoreArg_values();
+    wiringPiI2CReadBlockData_ReturnArrayThruPtr_values(listo,9);
+
+    TEST_ASSERT_TRUE(AD5933_BeginPoint(&dev,AD5933_FUNCTION_REPEAT_FREQ));
+    TEST_ASSERT_EQUAL(AD5933_POLL_PENDING,AD5933_Poll(&dev));
+    TEST_ASSERT_EQUAL(AD5933_POLL_READY,AD5933_Poll(&dev));
+    AD5933_CollectData(&dev,&real,&imag,&status);
+    TEST_ASSERT_EQUAL_INT16(256,real);
+    TEST_ASSERT_EQUAL_INT16(128,imag);
+}
+
+/* testeo la escritura de los ciclos de asentamiento */
+void test_ciclosAsentamiento(void)
+{
+    int i2cdevice = 0x0D;
+
+    // 600 ciclos se limitan a 511, con el multiplicador x4
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x8B,0xFF,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x8A,0x07,true);
+    TEST_ASSERT_TRUE(AD5933_SetSettlingCycles(&dev,600,AD5933_SETTLING_X4));
+    // el mismo valor no se vuelve a escribir
+    TEST_ASSERT_TRUE(AD5933_SetSettlingCycles(&dev,511,AD5933_SETTLING_X4));
+
+    TEST_ASSERT_EQUAL_HEX16(0x0064,AD5933_EncodeSettlingCycles(100));
+    TEST_ASSERT_EQUAL_HEX16(0x03F4,AD5933_EncodeSettlingCycles(1000));
+    TEST_ASSERT_EQUAL_HEX16(0x07FF,AD5933_EncodeSettlingCycles(5000));
+}
+
+/* testeo que un lote encola las escrituras hasta enviarlo */
+void test_loteDeEscrituras(void)
+{
+    int i2cdevice = 0x0D;
+    AD5933_BusOp lote[4];
+
+    AD5933_BeginBatch(&dev,lote,4);
+    TEST_ASSERT_TRUE(AD5933_SetRegisterValue(&dev,AD5933_REG_FREQ_START,0x0F5C29,3));
+    TEST_ASSERT_EQUAL_UINT8(3,dev.batchCount);
+    // el bus recien se usa al enviar el lote, en el mismo orden
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x84,0x29,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x83,0x5C,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x82,0x0F,false);
+    TEST_ASSERT_FALSE(AD5933_SubmitBatch(&dev));
+    // un lote fallido invalida la copia de los registros
+    TEST_ASSERT_EQUAL_HEX16(0,dev.shadowValid);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x84,0x29,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x83,0x5C,true);
+    wiringPiI2CWriteReg8_ExpectAndReturn(i2cdevice,0x82,0x0F,true);
+    TEST_ASSERT_TRUE(AD5933_SetRegisterValue(&dev,AD5933_REG_FREQ_START,0x0F5C29,3));
+}